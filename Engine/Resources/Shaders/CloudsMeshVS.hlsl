@@ -0,0 +1,48 @@
+#include "GPUShared.hlsli"
+#include "CubeVerticies.hlsli"
+
+struct CloudVSOutput
+{
+    float4 svPosition : SV_POSITION;
+    float4 colour : CLOUD_COLOUR;
+};
+
+// Matches CloudQuad in CloudField.h
+struct CloudQuad
+{
+    float3 basePos; // Center of the column's lowest voxel
+    uint faceAndLayers; // Face (3 bits) | first layer (14 bits) | number of layers (15 bits)
+};
+
+StructuredBuffer<CloudQuad> cloudQuads : register(t0, space0);
+StructuredBuffer<uint> cloudInstances : register(t1, space0); // Slots of cloudQuads in use
+cbuffer cloudRenderData : register(b1, space0)
+{
+    float4 colour;
+    float3 offset;
+    float scale;
+    float voxelSize;
+};
+
+CloudVSOutput main(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID)
+{
+    CloudVSOutput output;
+    
+    CloudQuad quad = cloudQuads[cloudInstances[instanceId]];
+    uint face = quad.faceAndLayers & 0x7;
+    uint firstLayer = (quad.faceAndLayers >> 3) & 0x3FFF;
+    uint numLayers = quad.faceAndLayers >> 17;
+    
+    // Same faces as the cube, stretched vertically over the quad's layers
+    float3 cubePos = CUBE_VERTICIES[face * 6 + vertexId];
+    
+    float3 vertexPos;
+    vertexPos.xz = quad.basePos.xz + cubePos.xz * voxelSize;
+    vertexPos.y = quad.basePos.y + (firstLayer + (cubePos.y + 0.5f) * numLayers - 0.5f) * voxelSize;
+    vertexPos += offset;
+
+    output.svPosition = mul(float4(vertexPos, 1.f), renderCB.viewProjMatrix);
+    output.colour = colour;
+    
+    return output;
+}
@@ -8,11 +8,13 @@ struct CloudVSOutput
 };
 
 StructuredBuffer<float3> cloudList : register(t0, space0);
+StructuredBuffer<uint> cloudInstances : register(t1, space0); // Slots of cloudList in use
 cbuffer cloudRenderData : register(b1, space0)
 {
     float4 colour;
     float3 offset;
     float scale;
+    float voxelSize;
 };
 
 CloudVSOutput main(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID)
@@ -21,7 +23,7 @@ CloudVSOutput main(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID)
     
     float3 vertexPos = CUBE_VERTICIES[vertexId];
     vertexPos *= scale;
-    vertexPos += cloudList[instanceId] + offset;
+    vertexPos += cloudList[cloudInstances[instanceId]] + offset;
 
     output.svPosition = mul(float4(vertexPos, 1.f), renderCB.viewProjMatrix);
     output.colour = colour;
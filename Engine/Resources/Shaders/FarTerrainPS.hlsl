@@ -0,0 +1,20 @@
+#include "FarTerrainShared.hlsli"
+
+// Colour of the skybox at the horizon
+static const float3 HORIZON_COLOUR = float3(1.f, 1.f, 1.f);
+
+float4 main(FarTerrainVSOutput input) : SV_TARGET
+{
+    // The voxels are drawn on top of this area
+    float2 cameraToPixel = input.worldPos.xz - farTerrainCB.cameraPos.xz;
+    if (dot(cameraToPixel, cameraToPixel) < farTerrainCB.innerRadius * farTerrainCB.innerRadius)
+        discard;
+    
+    float3 SUN_DIR = -normalize(float3(-0.469, -0.820, -0.327));
+    
+    float lightIntensity = max(dot(SUN_DIR, normalize(input.normal)), 0.3f) * 1.2f;
+    float3 colour = input.colour * lightIntensity;
+    
+    float fade = saturate(length(cameraToPixel) / farTerrainCB.fadeDistance);
+    return float4(lerp(colour, HORIZON_COLOUR, fade * fade), 0.f);
+}
@@ -0,0 +1,32 @@
+
+static const uint FAR_TERRAIN_GRID_CELLS = 64;
+static const uint FAR_TERRAIN_NUM_SAMPLES = FAR_TERRAIN_GRID_CELLS + 1;
+
+struct FarTerrainRenderData
+{
+    float4x4 viewProjMatrix;
+    float3 cameraPos;
+    float innerRadius;
+    float oceanHeight;
+    float fadeDistance;
+    float2 padding0;
+};
+
+struct FarTerrainLevel
+{
+    int2 originSample;
+    int2 holeMin;
+    int2 holeMax;
+    uint spacing;
+    uint heightsOffset;
+};
+
+struct FarTerrainVSOutput
+{
+    float4 svPosition : SV_POSITION;
+    float3 worldPos : WORLD_POS;
+    float3 normal : NORMAL;
+    float3 colour : COLOUR;
+};
+
+ConstantBuffer<FarTerrainRenderData> farTerrainCB : register(b0, space0);
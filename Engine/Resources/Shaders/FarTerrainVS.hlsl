@@ -0,0 +1,99 @@
+#include "FarTerrainShared.hlsli"
+
+cbuffer FarTerrainDrawData : register(b1, space0)
+{
+    uint levelIdx;
+};
+
+StructuredBuffer<float> heights : register(t0, space0);
+StructuredBuffer<FarTerrainLevel> levels : register(t1, space0);
+
+// Same winding as the top face of the voxels
+static const int2 CELL_CORNERS[6] =
+{
+    int2(0, 0),
+    int2(0, 1),
+    int2(1, 1),
+    
+    int2(1, 1),
+    int2(1, 0),
+    int2(0, 0),
+};
+
+static const float3 GRASS_COLOUR = float3(95.f, 159.f, 53.f) / 255.f;
+static const float3 WATER_COLOUR = float3(44.f, 94.f, 180.f) / 255.f;
+
+int positiveModulo(int value, int divisor)
+{
+    return ((value % divisor) + divisor) % divisor;
+}
+
+float loadHeight(FarTerrainLevel level, int2 gridCoord)
+{
+    // Samples outside of the grid aren't up to date, the toroidal storage holds samples from the other side there
+    gridCoord = clamp(gridCoord, 0, (int)FAR_TERRAIN_GRID_CELLS);
+    
+    int2 sampleCoord = level.originSample + gridCoord;
+    uint storageIdx = positiveModulo(sampleCoord.x, FAR_TERRAIN_NUM_SAMPLES) + positiveModulo(sampleCoord.y, FAR_TERRAIN_NUM_SAMPLES) * FAR_TERRAIN_NUM_SAMPLES;
+    
+    return heights[level.heightsOffset + storageIdx];
+}
+
+float sampleHeight(FarTerrainLevel level, int2 gridCoord)
+{
+    // Odd vertices on the outer edge are moved onto the line between their neighbours,
+    // which is exactly where the edge of the next (2x coarser) level is, so there are no cracks between the levels
+    bool onEdgeX = gridCoord.x == 0 || gridCoord.x == (int)FAR_TERRAIN_GRID_CELLS;
+    bool onEdgeZ = gridCoord.y == 0 || gridCoord.y == (int)FAR_TERRAIN_GRID_CELLS;
+    
+    if (onEdgeX && (gridCoord.y & 1))
+        return (loadHeight(level, gridCoord - int2(0, 1)) + loadHeight(level, gridCoord + int2(0, 1))) * 0.5f;
+    
+    if (onEdgeZ && (gridCoord.x & 1))
+        return (loadHeight(level, gridCoord - int2(1, 0)) + loadHeight(level, gridCoord + int2(1, 0))) * 0.5f;
+
+    return loadHeight(level, gridCoord);
+}
+
+FarTerrainVSOutput main(uint vertexId : SV_VertexID)
+{
+    FarTerrainVSOutput output;
+    
+    FarTerrainLevel level = levels[levelIdx];
+    
+    uint cellIdx = vertexId / 6;
+    int2 cellCoord = int2(cellIdx % FAR_TERRAIN_GRID_CELLS, cellIdx / FAR_TERRAIN_GRID_CELLS);
+    
+    // Cells covered by the next finer level are collapsed into degenerate triangles
+    int2 cellMin = (level.originSample + cellCoord) * (int)level.spacing;
+    int2 cellMax = cellMin + (int)level.spacing;
+    if (all(cellMin >= level.holeMin) && all(cellMax <= level.holeMax))
+    {
+        output.svPosition = float4(0.f, 0.f, 0.f, 1.f);
+        output.worldPos = float3(0.f, 0.f, 0.f);
+        output.normal = float3(0.f, 1.f, 0.f);
+        output.colour = float3(0.f, 0.f, 0.f);
+        return output;
+    }
+    
+    int2 gridCoord = cellCoord + CELL_CORNERS[vertexId % 6];
+    
+    float height = sampleHeight(level, gridCoord);
+    float heightLeft = sampleHeight(level, gridCoord - int2(1, 0));
+    float heightRight = sampleHeight(level, gridCoord + int2(1, 0));
+    float heightBack = sampleHeight(level, gridCoord - int2(0, 1));
+    float heightForward = sampleHeight(level, gridCoord + int2(0, 1));
+    
+    bool underWater = height <= farTerrainCB.oceanHeight;
+    
+    float3 worldPos;
+    worldPos.xz = float2((level.originSample + gridCoord) * (int)level.spacing);
+    worldPos.y = max(height, farTerrainCB.oceanHeight);
+
+    output.normal = underWater ? float3(0.f, 1.f, 0.f) : normalize(float3(heightLeft - heightRight, 2.f * level.spacing, heightBack - heightForward));
+    output.colour = underWater ? WATER_COLOUR : GRASS_COLOUR;
+    output.worldPos = worldPos;
+    output.svPosition = mul(float4(worldPos, 1.f), farTerrainCB.viewProjMatrix);
+    
+    return output;
+}
@@ -22,6 +22,14 @@ struct RenderData
 struct DrawCallData
 {
     float3 chunkWorldPos;
+    uint vertexEnd; // Only used by merged draws
+};
+
+// Root constants, set per draw directly or through ExecuteIndirect
+struct DrawIndex
+{
+    uint drawIdx;
+    uint numDrawData; // Above 1 for merged draws, one DrawCallData per member chunk
 };
 
 struct VoxelVSOutput
@@ -62,9 +70,10 @@ struct Vertex
 };
 
 ConstantBuffer<RenderData> renderCB : register(b0, space0);
-ConstantBuffer<DrawCallData> drawCB : register(b1, space0);
+ConstantBuffer<DrawIndex> drawIndexCB : register(b1, space0);
 StructuredBuffer<Vertex> verticies : register(t0, space0);
 Texture2D<float4> textureSheet : register(t1, space0);
+StructuredBuffer<DrawCallData> drawData : register(t2, space0);
 SamplerState pointSampler : register(s0, space0);
 
 float2 calculateUVCoords(float2 globalUV, uint textureID)
@@ -86,6 +95,16 @@ float2 calculateUVCoords(float2 globalUV, uint textureID)
 }
 
 
+DrawCallData getDrawCallData(uint vertexId)
+{
+    // Members are stored in vertex order, so the first one ending after the vertex is the one it belongs to
+    uint drawIdx = drawIndexCB.drawIdx;
+    for (uint i = 1; i < drawIndexCB.numDrawData && vertexId >= drawData[drawIdx].vertexEnd; i++)
+        drawIdx++;
+    
+    return drawData[drawIdx];
+}
+
 uint extractData(uint data, uint bitPos, uint numBits)
 {
     return (data << bitPos) >> (32 - numBits);
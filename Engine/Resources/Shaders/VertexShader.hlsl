@@ -12,7 +12,7 @@ VoxelVSOutput main(uint vertexId : SV_VertexID)
     position.x = (float)extractData(vertex.data, 0, 5);
     position.y = (float)extractData(vertex.data, 5, 9);
     position.z = (float)extractData(vertex.data, 14, 5);
-    position += drawCB.chunkWorldPos;
+    position += getDrawCallData(vertexId).chunkWorldPos;
     
     float2 globalUV;
     globalUV.x = (float)extractData(vertex.data, 19, 1);
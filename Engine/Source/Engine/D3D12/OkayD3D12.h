@@ -100,6 +100,17 @@ namespace Okay
 		return param;
 	}
 
+	constexpr D3D12_ROOT_PARAMETER createRootParamConstants(D3D12_SHADER_VISIBILITY visibility, uint32_t shaderRegister, uint32_t registerSpace, uint32_t num32BitValues)
+	{
+		D3D12_ROOT_PARAMETER param = {};
+		param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		param.ShaderVisibility = visibility;
+		param.Constants.ShaderRegister = shaderRegister;
+		param.Constants.RegisterSpace = registerSpace;
+		param.Constants.Num32BitValues = num32BitValues;
+		return param;
+	}
+
 	constexpr D3D12_ROOT_PARAMETER createRootParamTable(D3D12_SHADER_VISIBILITY visibility, D3D12_DESCRIPTOR_RANGE* pRanges, uint32_t numRanges)
 	{
 		D3D12_ROOT_PARAMETER param = {};
@@ -3,11 +3,11 @@
 #include "Engine/World/World.h"
 #include "Engine/Application/ImguiHelper.h"
 #include "Engine/World/Camera.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb/stb_image.h"
+#include "Engine/Application/Time.h"
 
 #include <shared_mutex>
+#include <unordered_set>
+#include <latch>
 
 namespace Okay
 {
@@ -26,13 +26,32 @@ namespace Okay
 		glm::vec4 colour = glm::vec4(1.f);
 		glm::vec3 offset = glm::vec3(0.f);
 		float scale = 1.f;
+		float voxelSize = 1.f;
+		glm::vec3 padding0;
 	};
 	
-	struct GPUDrawCallData
+	struct GPUFarTerrainRenderData
+	{
+		glm::mat4 viewProjMatrix = glm::mat4(1.f);
+		glm::vec3 cameraPos = glm::vec3(0.f);
+		float innerRadius = 0.f;
+		float oceanHeight = 0.f;
+		float fadeDistance = 0.f;
+		glm::vec2 padding0 = glm::vec2(0.f);
+	};
+
+	struct GPUFarTerrainLevel
 	{
-		glm::vec3 chunkWorldPos = glm::vec3(0.f);
+		glm::ivec2 originSample = glm::ivec2(0);
+		glm::ivec2 holeMin = glm::ivec2(INT_MAX);
+		glm::ivec2 holeMax = glm::ivec2(INT_MIN);
+		uint32_t spacing = 0;
+		uint32_t heightsOffset = 0;
 	};
 
+	// Own depth range for the far terrain, the depth buffer is cleared before the voxels are drawn
+	static const float FAR_TERRAIN_NEAR_Z = 1.f;
+
 	static std::shared_mutex s_loadingChunksMutis;
 
 	void Renderer::initialize(Window& window)
@@ -61,31 +80,47 @@ namespace Okay
 
 		window.registerResizeCallback(std::bind(&Renderer::onResize, this, std::placeholders::_1, std::placeholders::_2));
 
+		m_ringBuffer.initialize(m_pDevice, UPLOAD_RING_BUFFER_SIZE);
+
 		for (FrameResources& frame : m_frames)
-			initializeFrameResources(frame, 100'000'000);
+			initializeFrameResources(frame);
 
 		createVoxelRenderPass();
 		createSkyboxRenderPass();
 		createCloudsRenderPass();
+		createFarTerrainRenderPass();
 
-		m_gpuVertexData.initialize(m_pDevice, 1'000'000, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-		m_gpuIndicesData.initialize(m_pDevice, 1'000'000, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+		uint64_t farTerrainHeightsSize = FarTerrain::NUM_LEVELS * FarTerrain::NUM_SAMPLES * FarTerrain::NUM_SAMPLES * sizeof(float);
+		m_pFarTerrainHeights = createCommittedBuffer(farTerrainHeightsSize, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_HEAP_TYPE_DEFAULT, L"FarTerrainHeights");
+
+		m_gpuVertexData.initialize(m_pDevice, MESH_ARENA_PAGE_SIZE, D3D12_RESOURCE_STATE_COMMON);
+		m_gpuIndicesData.initialize(m_pDevice, MESH_ARENA_PAGE_SIZE, D3D12_RESOURCE_STATE_COMMON);
+		m_pDefragScratchBuffer = createCommittedBuffer(DefragmentationData::SCRATCH_BUFFER_SIZE, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_DEFAULT, L"DefragScratchBuffer");
 
 		FrameResources initFrame;
-		initializeFrameResources(initFrame, 100'000);
+		initializeFrameResources(initFrame);
 		reset(initFrame.pCommandAllocator, initFrame.pCommandList);
 
-		m_pTextureSheet = createTextureSheet(initFrame);
+		// The sheet only has to live until its data is copied into the ring buffer
+		{
+			TextureSheet textureSheet;
+			loadTextureSheet(textureSheet);
+			m_pTextureSheet = createTextureSheet(initFrame, textureSheet);
+		}
+
 		m_textureHandle = createSRVDescriptor(m_pTextureDescHeap, 0, m_pTextureSheet, nullptr);
 
 		flush(initFrame.pCommandList, initFrame.pCommandAllocator, initFrame.pFence, initFrame.fenceValue);
+		m_ringBuffer.endFrame(m_pCommandQueue);
 		shutdowFrameResources(initFrame);
 
-		generateTextureSheetMipMaps(m_pTextureSheet, TEXTURE_SHEET_TILE_SIZE);
-
 		uint32_t numThreads = glm::max(uint32_t(std::thread::hardware_concurrency() * 0.5), 1u);
 		m_threadPool.initialize(numThreads);
 
+		m_occlusionThreadPool.initialize(OcclusionCullingData::NUM_BANDS - 1);
+		m_drawRecordingThreadPool.initialize(DrawRecordingData::NUM_THREADS - 1);
+		m_occlusionBuffer.initialize(OcclusionCullingData::BUFFER_WIDTH, OcclusionCullingData::BUFFER_HEIGHT);
+
 		// In this version of Imgui, only 1 SRV is needed, it's stated that future versions will need more, but I don't see a reason to switch version atm :]
 		m_pImguiDescriptorHeap = createDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1, true, L"Imgui");
 		imguiInitialize(window, m_pDevice, m_pCommandQueue, m_pImguiDescriptorHeap, MAX_FRAMES_IN_FLIGHT);
@@ -96,16 +131,21 @@ namespace Okay
 		for (FrameResources& frame : m_frames)
 			shutdowFrameResources(frame);
 
+		m_ringBuffer.shutdown();
+
 		for (FrameGarbage& frameGarbage : m_frameGarbage)
 			D3D12_RELEASE(frameGarbage.pDxUnknown);
 
 		D3D12_RELEASE(m_pDevice);
 		D3D12_RELEASE(m_pCommandQueue);
+		D3D12_RELEASE(m_pCopyQueue);
+		D3D12_RELEASE(m_pCopyFence);
 		D3D12_RELEASE(m_pSwapChain);
 
 		D3D12_RELEASE(m_pVoxelRootSignature);
 		D3D12_RELEASE(m_pVoxelPSO);
 		D3D12_RELEASE(m_pWaterPSO);
+		D3D12_RELEASE(m_pVoxelCommandSignature);
 		D3D12_RELEASE(m_pTextureSheet);
 
 		D3D12_RELEASE(m_pSkyBoxRootSignature);
@@ -113,6 +153,15 @@ namespace Okay
 
 		D3D12_RELEASE(m_pCloudsRootSignature);
 		D3D12_RELEASE(m_pCloudsPSO);
+		D3D12_RELEASE(m_pCloudsMeshPSO);
+		D3D12_RELEASE(m_cloudPoints.pElements);
+		D3D12_RELEASE(m_cloudPoints.pInstances);
+		D3D12_RELEASE(m_cloudQuads.pElements);
+		D3D12_RELEASE(m_cloudQuads.pInstances);
+
+		D3D12_RELEASE(m_pFarTerrainRootSignature);
+		D3D12_RELEASE(m_pFarTerrainPSO);
+		D3D12_RELEASE(m_pFarTerrainHeights);
 
 		D3D12_RELEASE(m_pRTVDescHeap);
 		D3D12_RELEASE(m_pDSVDescHeap);
@@ -120,7 +169,11 @@ namespace Okay
 
 		m_gpuVertexData.shutdown();
 		m_gpuIndicesData.shutdown();
+		D3D12_RELEASE(m_pDefragScratchBuffer);
 		m_threadPool.shutdown();
+		m_occlusionThreadPool.shutdown();
+		m_drawRecordingThreadPool.shutdown();
+		m_occlusionBuffer.shutdown();
 
 		D3D12_RELEASE(m_pImguiDescriptorHeap);
 		imguiShutdown();
@@ -156,11 +209,17 @@ namespace Okay
 			wait(frame.pFence, frame.fenceValue);
 
 		m_dxChunks.clear();
+		m_dxChunkHandles.clear();
 		m_gpuVertexData.clear();
 		m_gpuIndicesData.clear();
+		m_frameSlotGarbage.clear();
+		m_numIdleDefragChunks = 0;
+		m_drawRegions.clear();
+		m_dirtyDrawRegions.clear();
 
 		std::unique_lock lock(s_loadingChunksMutis);
 		m_loadingChunkMesh.clear();
+		m_uploadScheduler.clear();
 	}
 
 	void Renderer::render(const World& world, const Camera& camera)
@@ -171,564 +230,1978 @@ namespace Okay
 		clearFrameGarbage();
 		reset(frame.pCommandAllocator, frame.pCommandList);
 
-		frame.ringBuffer.jumpToStart();
-		frame.ringBuffer.map();
+		// The frame fence is signaled after the direct queue waited for this frame's copies, so the copy allocator is free as well
+		m_uploadsOnCopyQueue = m_uploadData.useCopyQueue;
+		m_copyListRecorded = false;
+		if (m_uploadsOnCopyQueue)
+			reset(frame.pCopyCommandAllocator, frame.pCopyCommandList);
 
 		updateBuffers(world, camera);
 		preRender();
 		renderWorld(world);
 		postRender();
+	}
+
+	ResourceArenaStatistics Renderer::getVertexArenaStatistics() const
+	{
+		return m_gpuVertexData.getStatistics();
+	}
+
+	ResourceArenaStatistics Renderer::getIndexArenaStatistics() const
+	{
+		return m_gpuIndicesData.getStatistics();
+	}
+
+	uint64_t Renderer::getNumDefragmentedBytes() const
+	{
+		return m_numDefragmentedBytes;
+	}
+
+	uint32_t Renderer::getNumPendingUploads() const
+	{
+		return m_uploadScheduler.getNumPending();
+	}
+
+	uint64_t Renderer::getNumPendingUploadBytes() const
+	{
+		return m_uploadScheduler.getNumPendingBytes();
+	}
 
-		frame.ringBuffer.unmap();
+	uint64_t Renderer::getNumUploadedBytes() const
+	{
+		return m_numUploadedBytes;
+	}
+
+	const RingBuffer& Renderer::getRingBuffer() const
+	{
+		return m_ringBuffer;
+	}
+
+	const RenderStatistics& Renderer::getRenderStatistics() const
+	{
+		return m_renderStats;
 	}
 
 	void Renderer::updateBuffers(const World& world, const Camera& camera)
 	{
-		FrameResources& frame = getCurrentFrameResorces();
+		glm::mat4 viewProjMatrix = camera.getProjectionMatrix() * camera.transform.getViewMatrix();
 
 		GPURenderData renderData = {};
-		renderData.viewProjMatrix = glm::transpose(camera.getProjectionMatrix() * camera.transform.getViewMatrix());
+		renderData.viewProjMatrix = glm::transpose(viewProjMatrix);
 		renderData.cameraPos = camera.transform.position;
 		renderData.textureSheetTileSize = TEXTURE_SHEET_TILE_SIZE;
 		renderData.textureSheetPadding = TEXTURE_SHEET_PADDING;
 
-		m_renderDataGVA = frame.ringBuffer.allocate(&renderData, sizeof(renderData));
+		m_renderDataGVA = m_ringBuffer.allocate(&renderData, sizeof(renderData));
 
+		m_cameraPos = camera.transform.position;
+		m_currentCamChunkCoord = chunkIDToChunkCoord(blockCoordToChunkID(glm::floor(camera.transform.position)));
+		updateFarTerrain(world, camera);
+		updateClouds(world);
 		updateChunks(world);
+		cullChunks(viewProjMatrix, camera.transform.position);
 	}
 
-	void Renderer::preRender()
+	void Renderer::updateClouds(const World& world)
 	{
-		FrameResources& frame = getCurrentFrameResorces();
-		transitionResource(frame.pCommandList, frame.pBackBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		const CloudField& cloudField = world.getCloudField();
 
-		static const float CLEAR_COLOUR[4] = { 0.4f, 0.3f, 0.7f, 0.f };
-		frame.pCommandList->ClearRenderTargetView(frame.cpuBackBufferRTV, CLEAR_COLOUR, 0, nullptr);
-		frame.pCommandList->ClearDepthStencilView(frame.cpuDepthTextureDSV, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
+		// Both lists are kept up to date so switching between cubes & meshed clouds doesn't need a rebuild
+		bool recreate = m_cloudLayoutVersion != cloudField.getLayoutVersion();
+		if (!recreate && m_cloudVersion == cloudField.getVersion())
+			return;
+
+		const std::vector<glm::vec3>& points = cloudField.getPoints();
+		const std::vector<CloudQuad>& quads = cloudField.getQuads();
+
+		updateCloudBuffer(m_cloudPoints, points.data(), sizeof(glm::vec3), (uint32_t)points.size(), cloudField.getInstances(), cloudField.getDirtyRanges(), recreate, L"CloudPoints");
+		updateCloudBuffer(m_cloudQuads, quads.data(), sizeof(CloudQuad), (uint32_t)quads.size(), cloudField.getQuadInstances(), cloudField.getQuadDirtyRanges(), recreate, L"CloudQuads");
+
+		m_cloudLayoutVersion = cloudField.getLayoutVersion();
+		m_cloudVersion = cloudField.getVersion();
 	}
 
-	void Renderer::renderWorld(const World& world)
+	void Renderer::updateCloudBuffer(CloudBuffer& buffer, const void* pElements, uint32_t elementSize, uint32_t numElements, const std::vector<uint32_t>& instances,
+		const std::vector<CloudDirtyRange>& dirtyRanges, bool recreate, std::wstring_view name)
 	{
 		FrameResources& frame = getCurrentFrameResorces();
+		const uint8_t* pElementBytes = (const uint8_t*)pElements;
 
-		frame.pCommandList->SetGraphicsRootSignature(m_pVoxelRootSignature);
-		frame.pCommandList->SetPipelineState(m_pVoxelPSO);
+		if (recreate)
+		{
+			// Frames in flight can still be drawing the old ones
+			if (buffer.pElements)
+			{
+				addToFrameGarbage(buffer.pElements);
+				addToFrameGarbage(buffer.pInstances);
+			}
 
-		frame.pCommandList->SetDescriptorHeaps(1, &m_pTextureDescHeap);
-		frame.pCommandList->SetGraphicsRootDescriptorTable(3, m_textureHandle);
+			uint64_t numSlots = glm::max((uint64_t)numElements, 1ull);
+			buffer.pElements = createCommittedBuffer(numSlots * elementSize, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_HEAP_TYPE_DEFAULT, name);
+			buffer.pInstances = createCommittedBuffer(numSlots * sizeof(uint32_t), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_HEAP_TYPE_DEFAULT, L"CloudInstances");
+		}
 
-		frame.pCommandList->SetGraphicsRootConstantBufferView(0, m_renderDataGVA);
+		buffer.numInstances = (uint32_t)instances.size();
 
-		frame.pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		frame.pCommandList->RSSetViewports(1, &frame.viewport);
-		frame.pCommandList->RSSetScissorRects(1, &frame.scissorRect);
-		frame.pCommandList->OMSetRenderTargets(1, &frame.cpuBackBufferRTV, false, &frame.cpuDepthTextureDSV);
+		if (!numElements)
+			return;
 
-		for (DXChunk& dxChunk : m_dxChunks)
-		{
-			GPUDrawCallData drawData = {};
-			drawData.chunkWorldPos = chunkCoordToWorldCoord(chunkIDToChunkCoord(dxChunk.chunkID));
-			dxChunk.drawDataGVA = frame.ringBuffer.allocate(&drawData, sizeof(drawData));
+		transitionResource(frame.pCommandList, buffer.pElements, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+		transitionResource(frame.pCommandList, buffer.pInstances, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
 
-			drawGPUMeshInfo(dxChunk, dxChunk.blockGPUMeshInfo);
+		// Only the cells that changed, unless the buffers were just created
+		if (recreate)
+		{
+			updateDefaultHeapResource(buffer.pElements, 0, pElements, (uint64_t)numElements * elementSize, frame.pCommandList);
 		}
-
-		frame.pCommandList->SetPipelineState(m_pWaterPSO);
-
-		for (const DXChunk& dxChunk : m_dxChunks)
+		else
 		{
-			drawGPUMeshInfo(dxChunk, dxChunk.waterGPUMeshInfo);
+			for (const CloudDirtyRange& range : dirtyRanges)
+			{
+				uint64_t offset = (uint64_t)range.firstElement * elementSize;
+				updateDefaultHeapResource(buffer.pElements, offset, pElementBytes + offset, (uint64_t)range.numElements * elementSize, frame.pCommandList);
+			}
 		}
 
-		drawSkyBox();
-		drawClouds(world);
+		// Which slots are drawn, 4 bytes per element so it's cheap to send again whenever anything changes
+		if (!instances.empty())
+			updateDefaultHeapResource(buffer.pInstances, 0, instances.data(), instances.size() * sizeof(uint32_t), frame.pCommandList);
+
+		transitionResource(frame.pCommandList, buffer.pElements, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		transitionResource(frame.pCommandList, buffer.pInstances, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 	}
 
-	void Renderer::postRender()
+	void Renderer::cullChunks(const glm::mat4& viewProjMatrix, const glm::vec3& cameraPos)
 	{
-		FrameResources& frame = getCurrentFrameResorces();
-		
-		frame.pCommandList->SetDescriptorHeaps(1, &m_pImguiDescriptorHeap);
-		imguiEndFrame(frame.pCommandList);
+		m_dxChunkVisibility.assign(m_dxChunks.size(), 1);
+		m_renderStats = RenderStatistics();
+		m_renderStats.numVisibleChunks = (uint32_t)m_dxChunks.size();
 
-		transitionResource(frame.pCommandList, frame.pBackBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+		if (!m_frustumCulling && !m_caveCulling && !m_occlusionData.enabled)
+			return;
 
-		execute(frame.pCommandList);
-		m_pSwapChain->Present(0, 0);
+		m_dxChunkAABBs.clear();
+		for (const DXChunk& dxChunk : m_dxChunks)
+		{
+			glm::vec3 boxMin = chunkCoordToWorldCoord(chunkIDToChunkCoord(dxChunk.chunkID));
+			glm::vec3 boxMax = boxMin + glm::vec3((float)CHUNK_WIDTH, 0.f, (float)CHUNK_WIDTH);
+			boxMin.y = dxChunk.meshMinY;
+			boxMax.y = dxChunk.meshMaxY;
 
-		signal(frame.pFence, frame.fenceValue);
-	}
+			m_dxChunkAABBs.add((boxMin + boxMax) * 0.5f, (boxMax - boxMin) * 0.5f);
+		}
 
-	void Renderer::drawGPUMeshInfo(const DXChunk& dxChunk, const GPUMeshInfo& gpuMeshInfo)
-	{
-		if (gpuMeshInfo.indicesCount == 0)
-			return;
+		if (m_frustumCulling)
+		{
+			Collision::FrustumPlanes frustum = Collision::createFrustumPlanes(viewProjMatrix);
+			m_renderStats.numVisibleChunks = Collision::frustumAABBBatch(frustum, m_dxChunkAABBs, m_dxChunkVisibility);
+		}
 
-		FrameResources& frame = getCurrentFrameResorces();
+		if (m_caveCulling)
+			cullCaveChunks(cameraPos);
 
-		frame.pCommandList->IASetIndexBuffer(&gpuMeshInfo.indicesView);
-		frame.pCommandList->SetGraphicsRootShaderResourceView(2, gpuMeshInfo.vertexDataGVA);
-		frame.pCommandList->SetGraphicsRootConstantBufferView(1, dxChunk.drawDataGVA);
-		frame.pCommandList->DrawIndexedInstanced(gpuMeshInfo.indicesCount, 1, 0, 0, 0);
+		if (m_occlusionData.enabled)
+			cullOccludedChunks(viewProjMatrix, cameraPos);
+
+		m_renderStats.numCulledChunks = (uint32_t)m_dxChunks.size() - m_renderStats.numVisibleChunks;
 	}
 
-	void Renderer::drawSkyBox()
+	// Same order as the vertex sideIdx
+	static const glm::ivec3 SIDE_DIRECTIONS[6] =
 	{
-		// Function assumes the correct RTV, viewport, etc are already bound
-
-		FrameResources& frame = getCurrentFrameResorces();
-		
-		frame.pCommandList->SetGraphicsRootSignature(m_pSkyBoxRootSignature);
-		frame.pCommandList->SetPipelineState(m_pSkyBoxPSO);
-		frame.pCommandList->SetGraphicsRootConstantBufferView(0, m_renderDataGVA);
+		UP_DIR,
+		-UP_DIR,
+		RIGHT_DIR,
+		-RIGHT_DIR,
+		FORWARD_DIR,
+		-FORWARD_DIR,
+	};
 
-		frame.pCommandList->DrawInstanced(36, 1, 0, 0);
+	static uint64_t getSectionSidesBit(uint32_t sideA, uint32_t sideB)
+	{
+		return 1ull << (sideA * 6 + sideB);
 	}
 
-	void Renderer::drawClouds(const World& world)
+	void Renderer::cullCaveChunks(const glm::vec3& cameraPos)
 	{
-		// Function assumes the correct RTV, viewport, etc are already bound
+		auto camChunkIterator = m_dxChunkHandles.find(blockCoordToChunkID(glm::floor(cameraPos)));
+		if (camChunkIterator == m_dxChunkHandles.end())
+			return;
 
-		FrameResources& frame = getCurrentFrameResorces();
+		m_caveVisitedSections.assign(m_dxChunks.size() * NUM_CHUNK_SECTIONS, 0);
+		m_caveOpenChunks.clear();
+		m_caveCullingQueue.clear();
 
-		const std::vector<glm::vec3>& cloudList = world.getCloudList();
-		D3D12_GPU_VIRTUAL_ADDRESS cloudPointsGVA = frame.ringBuffer.allocate(cloudList.data(), cloudList.size() * sizeof(glm::vec3));
+		// Chunks without a mesh are flooded through, but only within the meshed area so the flood stays finite
+		glm::ivec2 minChunkCoord = glm::ivec2(INT_MAX);
+		glm::ivec2 maxChunkCoord = glm::ivec2(INT_MIN);
+		for (const DXChunk& dxChunk : m_dxChunks)
+		{
+			glm::ivec2 chunkCoord = chunkIDToChunkCoord(dxChunk.chunkID);
+			minChunkCoord = glm::min(minChunkCoord, chunkCoord);
+			maxChunkCoord = glm::max(maxChunkCoord, chunkCoord);
+		}
 
-		GPUCloudsRenderData cloudRenderData = {};
-		cloudRenderData.colour = world.m_cloudGenData.colour;
-		cloudRenderData.offset = glm::vec3(world.m_cloudGenData.globalDrift.x, 0.f, world.m_cloudGenData.globalDrift.y);
-		cloudRenderData.scale = world.m_cloudGenData.scale;
+		CaveCullingNode& startNode = m_caveCullingQueue.emplace_back();
+		startNode.chunkID = camChunkIterator->first;
+		startNode.dxChunkIdx = m_dxChunks.getDenseIdx(camChunkIterator->second);
+		startNode.sectionIdx = (uint32_t)glm::clamp((int)glm::floor(cameraPos.y / SECTION_HEIGHT), 0, (int)NUM_CHUNK_SECTIONS - 1);
+		m_caveVisitedSections[startNode.dxChunkIdx * NUM_CHUNK_SECTIONS + startNode.sectionIdx] = 1;
 
-		D3D12_GPU_VIRTUAL_ADDRESS cloudsRenderDataGVA = frame.ringBuffer.allocate(&cloudRenderData, sizeof(GPUCloudsRenderData));
+		// Breadth first, every section is only entered once, from the side it was first reached through
+		for (size_t queueIdx = 0; queueIdx < m_caveCullingQueue.size(); queueIdx++)
+		{
+			CaveCullingNode node = m_caveCullingQueue[queueIdx];
+			uint64_t connectivity = node.dxChunkIdx != INVALID_UINT32 ? m_dxChunks[node.dxChunkIdx].sectionConnectivity[node.sectionIdx] : ~0ull;
+			glm::ivec2 chunkCoord = chunkIDToChunkCoord(node.chunkID);
 
-		frame.pCommandList->SetGraphicsRootSignature(m_pCloudsRootSignature);
-		frame.pCommandList->SetPipelineState(m_pCloudsPSO);
-		frame.pCommandList->SetGraphicsRootConstantBufferView(0, m_renderDataGVA);
-		frame.pCommandList->SetGraphicsRootShaderResourceView(1, cloudPointsGVA);
-		frame.pCommandList->SetGraphicsRootConstantBufferView(2, cloudsRenderDataGVA);
+			for (uint32_t side = 0; side < 6; side++)
+			{
+				if (node.entrySide != INVALID_UINT8 && (side == node.entrySide || !(connectivity & getSectionSidesBit(node.entrySide, side))))
+					continue;
 
-		frame.pCommandList->DrawInstanced(36, (uint32_t)cloudList.size(), 0, 0);
-	}
+				// Sides come in pairs, side ^ 1 is the opposite one
+				if (node.travelledSides & (1 << (side ^ 1)))
+					continue;
 
-	void Renderer::signal(ID3D12Fence* pFence, uint64_t& fenceValue)
-	{
-		DX_CHECK(m_pCommandQueue->Signal(pFence, ++fenceValue));
-	}
+				const glm::ivec3& direction = SIDE_DIRECTIONS[side];
+				int neighbourSectionIdx = (int)node.sectionIdx + direction.y;
+				if (neighbourSectionIdx < 0 || neighbourSectionIdx >= (int)NUM_CHUNK_SECTIONS)
+					continue;
 
-	void Renderer::execute(ID3D12GraphicsCommandList* pCommandList)
-	{
-		DX_CHECK(pCommandList->Close());
-		m_pCommandQueue->ExecuteCommandLists(1, (ID3D12CommandList**)&pCommandList);
-	}
+				ChunkID neighbourChunkID = node.chunkID;
+				uint32_t neighbourChunkIdx = node.dxChunkIdx;
+				if (direction.y == 0)
+				{
+					glm::ivec2 neighbourChunkCoord = chunkCoord + glm::ivec2(direction.x, direction.z);
+					if (glm::any(glm::lessThan(neighbourChunkCoord, minChunkCoord)) || glm::any(glm::greaterThan(neighbourChunkCoord, maxChunkCoord)))
+						continue;
 
-	void Renderer::wait(ID3D12Fence* pFence, uint64_t fenceValue)
-	{
-		if (pFence->GetCompletedValue() >= fenceValue)
-			return;
+					neighbourChunkID = chunkCoordToChunkID(neighbourChunkCoord);
+					auto neighbourIterator = m_dxChunkHandles.find(neighbourChunkID);
+					neighbourChunkIdx = neighbourIterator != m_dxChunkHandles.end() ? m_dxChunks.getDenseIdx(neighbourIterator->second) : INVALID_UINT32;
+				}
 
-		HANDLE eventHandle = CreateEventEx(nullptr, 0, 0, EVENT_ALL_ACCESS);
-		DX_CHECK(pFence->SetEventOnCompletion(fenceValue, eventHandle));
+				// Outside the frustum, chunks without a mesh have nothing to test so they're always let through
+				if (neighbourChunkIdx != INVALID_UINT32 && !m_dxChunkVisibility[neighbourChunkIdx])
+					continue;
 
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
-	}
+				uint32_t visitedOffset = INVALID_UINT32;
+				if (neighbourChunkIdx != INVALID_UINT32)
+				{
+					visitedOffset = neighbourChunkIdx * NUM_CHUNK_SECTIONS;
+				}
+				else
+				{
+					auto [openIterator, inserted] = m_caveOpenChunks.try_emplace(neighbourChunkID, (uint32_t)m_caveVisitedSections.size());
+					if (inserted)
+						m_caveVisitedSections.resize(m_caveVisitedSections.size() + NUM_CHUNK_SECTIONS, 0);
 
-	void Renderer::reset(ID3D12CommandAllocator* pCommandAlloator, ID3D12GraphicsCommandList* pCommandList)
-	{
-		DX_CHECK(pCommandAlloator->Reset());
-		DX_CHECK(pCommandList->Reset(pCommandAlloator, nullptr));
-	}
+					visitedOffset = openIterator->second;
+				}
 
-	void Renderer::flush(ID3D12GraphicsCommandList* pCommandList, ID3D12CommandAllocator* pCommandAlloator, ID3D12Fence* pFence, uint64_t& fenceValue)
-	{
-		execute(pCommandList);
-		signal(pFence, fenceValue);
-		wait(pFence, fenceValue);
-		reset(pCommandAlloator, pCommandList);
-	}
+				uint8_t& visited = m_caveVisitedSections[visitedOffset + neighbourSectionIdx];
+				if (visited)
+					continue;
 
-	void Renderer::addToFrameGarbage(IUnknown* pDxUnknown)
-	{
-		m_frameGarbage.emplace_back(m_pSwapChain->GetCurrentBackBufferIndex(), pDxUnknown);
-	}
+				visited = 1;
 
-	void Renderer::clearFrameGarbage()
-	{
-		uint32_t currentFrameIdx = m_pSwapChain->GetCurrentBackBufferIndex();
-		for (int i = (int)m_frameGarbage.size() - 1; i >= 0; i--)
-		{
-			if (m_frameGarbage[i].frameIdx == currentFrameIdx)
-			{
-				D3D12_RELEASE(m_frameGarbage[i].pDxUnknown);
-				m_frameGarbage.erase(m_frameGarbage.begin() + i);
+				CaveCullingNode& neighbourNode = m_caveCullingQueue.emplace_back();
+				neighbourNode.chunkID = neighbourChunkID;
+				neighbourNode.dxChunkIdx = neighbourChunkIdx;
+				neighbourNode.sectionIdx = (uint32_t)neighbourSectionIdx;
+				neighbourNode.entrySide = uint8_t(side ^ 1);
+				neighbourNode.travelledSides = node.travelledSides | uint8_t(1 << side);
 			}
 		}
-	}
 
-	void Renderer::transitionResource(ID3D12GraphicsCommandList* pCommandList, ID3D12Resource* pResource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES newState, uint32_t subResource)
-	{
-		D3D12_RESOURCE_BARRIER barrier = {};
-		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-		barrier.Transition.pResource = pResource;
-		barrier.Transition.StateBefore = beforeState;
-		barrier.Transition.StateAfter = newState;
-		barrier.Transition.Subresource = subResource;
-		barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		// Chunks are drawn whole, so reaching any of their sections is enough
+		for (uint32_t i = 0; i < (uint32_t)m_dxChunks.size(); i++)
+		{
+			if (!m_dxChunkVisibility[i])
+				continue;
 
-		pCommandList->ResourceBarrier(1, &barrier);
-	}
+			const uint8_t* pVisited = m_caveVisitedSections.data() + i * NUM_CHUNK_SECTIONS;
+			if (std::find(pVisited, pVisited + NUM_CHUNK_SECTIONS, 1) != pVisited + NUM_CHUNK_SECTIONS)
+				continue;
 
-	void Renderer::updateDefaultHeapResource(ID3D12Resource* pTarget, uint64_t targetOffset, const void* pData, uint64_t dataSize)
-	{
-		FrameResources& frame = getCurrentFrameResorces();
+			m_dxChunkVisibility[i] = 0;
+			m_renderStats.numCaveCulledChunks++;
+		}
 
-		uint64_t uploadBufferOffset = frame.ringBuffer.getOffset();
-		frame.ringBuffer.allocate(pData, dataSize);
-		frame.pCommandList->CopyBufferRegion(pTarget, targetOffset, frame.ringBuffer.getDXResource(), uploadBufferOffset, dataSize);
+		m_renderStats.numVisibleChunks -= m_renderStats.numCaveCulledChunks;
 	}
 
-	static void addVertex(std::vector<uint32_t>& indices, std::vector<Vertex>& verticiesData, Vertex newVertex)
+	void Renderer::cullOccludedChunks(const glm::mat4& viewProjMatrix, const glm::vec3& cameraPos)
 	{
-		uint32_t idx = INVALID_UINT32;
-		int startIdx = glm::max((int)verticiesData.size() - 5, 0); // Lmao
-		for (uint64_t i = startIdx; i < verticiesData.size(); i++)
-		{
-			if (verticiesData[i] == newVertex)
-			{
-				idx = (uint32_t)i;
-				break;
-			}
-		}
+		Timer timer;
+		const float rasterizeBudget = m_occlusionData.timeBudgetMS * 0.0005f; // Timer measures seconds
+		const float totalBudget = m_occlusionData.timeBudgetMS * 0.001f;
 
-		if (idx == INVALID_UINT32)
+		m_occlusionCandidates.clear();
+		for (uint32_t i = 0; i < (uint32_t)m_dxChunks.size(); i++)
 		{
-			indices.emplace_back((uint32_t)verticiesData.size());
-			verticiesData.emplace_back(newVertex);
+			if (m_dxChunkVisibility[i])
+				m_occlusionCandidates.emplace_back(i);
 		}
-		else
+
+		// Nearby chunks cover the most of the screen, so they're rasterized first in case the budget runs out
+		std::sort(m_occlusionCandidates.begin(), m_occlusionCandidates.end(), [&](uint32_t a, uint32_t b)
+			{
+				glm::vec2 toA = glm::vec2(m_dxChunkAABBs.centerX[a] - cameraPos.x, m_dxChunkAABBs.centerZ[a] - cameraPos.z);
+				glm::vec2 toB = glm::vec2(m_dxChunkAABBs.centerX[b] - cameraPos.x, m_dxChunkAABBs.centerZ[b] - cameraPos.z);
+				return glm::dot(toA, toA) < glm::dot(toB, toB);
+			});
+
+		m_occluders.clear();
+		for (uint32_t dxChunkIdx : m_occlusionCandidates)
 		{
-			indices.emplace_back(idx);
-		}
-	}
+			const DXChunk& dxChunk = m_dxChunks[dxChunkIdx];
+			glm::vec3 chunkWorldPos = chunkCoordToWorldCoord(chunkIDToChunkCoord(dxChunk.chunkID));
 
-	void Renderer::generateChunkMesh(const World* pWorld, ChunkID chunkID, uint32_t chunkGenID, ChunkMeshData& outMeshData)
-	{
-		glm::ivec2 chunkCoord = chunkIDToChunkCoord(chunkID);
-		glm::ivec3 worldCoord = chunkCoordToWorldCoord(chunkCoord);
+			for (uint32_t z = 0; z < OCCLUDER_CELLS_PER_SIDE; z++)
+			{
+				for (uint32_t x = 0; x < OCCLUDER_CELLS_PER_SIDE; x++)
+				{
+					uint16_t height = dxChunk.occluderHeights[x + z * OCCLUDER_CELLS_PER_SIDE];
+					if (!height)
+						continue;
 
-		outMeshData.blockMesh.vertices.reserve(MAX_BLOCKS_IN_CHUNK * 36ull);
-		outMeshData.blockMesh.indices.reserve(MAX_BLOCKS_IN_CHUNK * 36ull);
+					OccluderBox& occluder = m_occluders.emplace_back();
+					occluder.boxMin = chunkWorldPos + glm::vec3((float)(x * OCCLUDER_CELL_WIDTH), 0.f, (float)(z * OCCLUDER_CELL_WIDTH));
+					occluder.boxMax = occluder.boxMin + glm::vec3((float)OCCLUDER_CELL_WIDTH, (float)height, (float)OCCLUDER_CELL_WIDTH);
+				}
+			}
+		}
 
-		outMeshData.waterMesh.vertices.reserve(MAX_BLOCKS_IN_CHUNK * 36ull / 2);
-		outMeshData.waterMesh.indices.reserve(MAX_BLOCKS_IN_CHUNK * 36ull / 2);
+		m_occlusionBuffer.clear();
+		m_occlusionBuffer.setViewProjection(viewProjMatrix, cameraPos);
 
-		for (uint32_t i = 0; i < MAX_BLOCKS_IN_CHUNK; i++)
+		// Projected & clipped once here, the bands only rasterize their own rows of the triangles.
+		// Stopping early only leaves holes in the buffer, which makes the tests more conservative
+		uint32_t numPreparedOccluders = 0;
+		for (; numPreparedOccluders < (uint32_t)m_occluders.size(); numPreparedOccluders++)
 		{
-			std::shared_lock lock(s_loadingChunksMutis);
+			if (numPreparedOccluders % 32 == 0 && timer.measure() > rasterizeBudget)
+				break;
 
-			const auto& chunkIterator = m_loadingChunkMesh.find(chunkID);
-			if (chunkIterator == m_loadingChunkMesh.end())
-				return;
+			OccluderBox& occluder = m_occluders[numPreparedOccluders];
+			m_occlusionBuffer.addOccluder(occluder.boxMin, occluder.boxMax);
+			occluder.trianglesEnd = m_occlusionBuffer.getNumTriangles();
+		}
 
-			const ThreadSafeChunkMesh& threadChunk = chunkIterator->second;
-			if (threadChunk.latestChunkGenID != chunkGenID)
-				return;
+		// The render thread takes band 0 itself and waits for the workers to finish the rest
+		auto runOnAllBands = [&](const std::function<void(uint32_t band)>& job)
+			{
+				std::latch bandsDone(OcclusionCullingData::NUM_BANDS - 1);
+				for (uint32_t band = 1; band < OcclusionCullingData::NUM_BANDS; band++)
+				{
+					m_occlusionThreadPool.queueJob([&, band]()
+						{
+							job(band);
+							bandsDone.count_down();
+						});
+				}
 
-			lock.unlock();
+				job(0);
+				bandsDone.wait();
+			};
 
+		const uint32_t rowsPerBand = (OcclusionCullingData::BUFFER_HEIGHT + OcclusionCullingData::NUM_BANDS - 1) / OcclusionCullingData::NUM_BANDS;
+		uint32_t numRasterized[OcclusionCullingData::NUM_BANDS] = {};
+		uint32_t numOccluded[OcclusionCullingData::NUM_BANDS] = {};
 
-			BlockType block = pWorld->tryGetBlock(chunkID, i);
-			if (block == BlockType::INVALID) // Chunk is no longer loaded
-				return;
+		runOnAllBands([&](uint32_t band)
+			{
+				uint32_t rowBegin = band * rowsPerBand;
+				uint32_t occluderIdx = 0;
 
-			if (block == BlockType::AIR)
-				continue;
+				for (; occluderIdx < numPreparedOccluders; occluderIdx++)
+				{
+					if (occluderIdx % 32 == 0 && timer.measure() > rasterizeBudget)
+						break;
 
+					uint32_t trianglesBegin = occluderIdx ? m_occluders[occluderIdx - 1].trianglesEnd : 0;
+					m_occlusionBuffer.rasterizeTriangles(trianglesBegin, m_occluders[occluderIdx].trianglesEnd, rowBegin, rowBegin + rowsPerBand);
+				}
 
-			glm::ivec3 chunkBlockCoord = chunkBlockIdxToChunkBlockCoord(i);
-			glm::ivec3 worldBlockCoord = chunkBlockCoord + worldCoord;
+				numRasterized[band] = occluderIdx;
+			});
 
-			if (block == BlockType::WATER)
-			{
-				addWaterMeshData(pWorld, chunkBlockCoord, worldBlockCoord, outMeshData.waterMesh);
-			}
-			else
+		// Testing reads the whole buffer, so the candidates are interleaved between the threads instead
+		runOnAllBands([&](uint32_t band)
 			{
-				addBlockMeshData(pWorld, block, chunkBlockCoord, worldBlockCoord, outMeshData.blockMesh);
-			}
-		}
-	}
+				uint32_t numTested = 0;
+				for (uint32_t i = band; i < (uint32_t)m_occlusionCandidates.size(); i += OcclusionCullingData::NUM_BANDS)
+				{
+					if (numTested++ % 16 == 0 && timer.measure() > totalBudget)
+						break;
+
+					uint32_t dxChunkIdx = m_occlusionCandidates[i];
+					glm::vec3 center = glm::vec3(m_dxChunkAABBs.centerX[dxChunkIdx], m_dxChunkAABBs.centerY[dxChunkIdx], m_dxChunkAABBs.centerZ[dxChunkIdx]);
+					glm::vec3 extents = glm::vec3(m_dxChunkAABBs.extentsX[dxChunkIdx], m_dxChunkAABBs.extentsY[dxChunkIdx], m_dxChunkAABBs.extentsZ[dxChunkIdx]);
+
+					if (!m_occlusionBuffer.testAABB(center - extents, center + extents))
+					{
+						m_dxChunkVisibility[dxChunkIdx] = 0;
+						numOccluded[band]++;
+					}
+				}
+			});
+
+		m_renderStats.numOccluders = (uint32_t)m_occluders.size();
+		m_renderStats.numRasterizedOccluders = (uint32_t)m_occluders.size();
+		for (uint32_t band = 0; band < OcclusionCullingData::NUM_BANDS; band++)
+		{
+			m_renderStats.numRasterizedOccluders = glm::min(m_renderStats.numRasterizedOccluders, numRasterized[band]);
+			m_renderStats.numOccludedChunks += numOccluded[band];
+		}
+
+		m_renderStats.numVisibleChunks -= m_renderStats.numOccludedChunks;
+	}
+
+	void Renderer::updateFarTerrain(const World& world, const Camera& camera)
+	{
+		FrameResources& frame = getCurrentFrameResorces();
+		const FarTerrain& farTerrain = world.m_farTerrain;
+
+		const uint32_t levelNumSamples = FarTerrain::NUM_SAMPLES * FarTerrain::NUM_SAMPLES;
+		const FarTerrainLevel& coarsestLevel = farTerrain.getLevel(FarTerrain::NUM_LEVELS - 1);
+		const float farTerrainRadius = float(FarTerrain::GRID_CELLS / 2 * coarsestLevel.spacing);
+
+		bool heightsTransitioned = false;
+		GPUFarTerrainLevel gpuLevels[FarTerrain::NUM_LEVELS] = {};
+
+		for (uint32_t i = 0; i < FarTerrain::NUM_LEVELS; i++)
+		{
+			const FarTerrainLevel& level = farTerrain.getLevel(i);
+
+			gpuLevels[i].originSample = level.originSample;
+			gpuLevels[i].spacing = level.spacing;
+			gpuLevels[i].heightsOffset = i * levelNumSamples;
+
+			// The hole is where the previous level is drawn, if it's not active the voxels cover the area instead
+			const FarTerrainLevel& finerLevel = farTerrain.getLevel(glm::max(i, 1u) - 1);
+			if (i > 0 && finerLevel.active)
+			{
+				gpuLevels[i].holeMin = finerLevel.originSample * (int)finerLevel.spacing;
+				gpuLevels[i].holeMax = (finerLevel.originSample + (int)FarTerrain::GRID_CELLS) * (int)finerLevel.spacing;
+			}
+
+			if (!level.active || m_farTerrainLevelVersions[i] == level.version)
+				continue;
+
+			if (!heightsTransitioned)
+			{
+				transitionResource(frame.pCommandList, m_pFarTerrainHeights, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+				heightsTransitioned = true;
+			}
+
+			updateDefaultHeapResource(m_pFarTerrainHeights, gpuLevels[i].heightsOffset * sizeof(float), level.heights.data(), levelNumSamples * sizeof(float));
+			m_farTerrainLevelVersions[i] = level.version;
+		}
+
+		if (heightsTransitioned)
+			transitionResource(frame.pCommandList, m_pFarTerrainHeights, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+		glm::mat4 farProjectionMatrix = glm::perspectiveFovLH_ZO(glm::radians(camera.fov), camera.viewportDims.x, camera.viewportDims.y, FAR_TERRAIN_NEAR_Z, farTerrainRadius * 1.5f);
+
+		GPUFarTerrainRenderData renderData = {};
+		renderData.viewProjMatrix = glm::transpose(farProjectionMatrix * camera.transform.getViewMatrix());
+		renderData.cameraPos = camera.transform.position;
+		renderData.innerRadius = world.getFarTerrainInnerRadius();
+		renderData.oceanHeight = (float)world.m_worldGenData.oceanHeight;
+		renderData.fadeDistance = farTerrainRadius;
+
+		m_farTerrainRenderDataGVA = m_ringBuffer.allocate(&renderData, sizeof(renderData));
+		m_farTerrainLevelsGVA = m_ringBuffer.allocate(gpuLevels, sizeof(gpuLevels));
+	}
+
+	void Renderer::preRender()
+	{
+		FrameResources& frame = getCurrentFrameResorces();
+		transitionResource(frame.pCommandList, frame.pBackBuffer, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+		static const float CLEAR_COLOUR[4] = { 0.4f, 0.3f, 0.7f, 0.f };
+		frame.pCommandList->ClearRenderTargetView(frame.cpuBackBufferRTV, CLEAR_COLOUR, 0, nullptr);
+		frame.pCommandList->ClearDepthStencilView(frame.cpuDepthTextureDSV, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
+	}
+
+	// Region coords packed the same way as chunk coords
+	static uint64_t getDrawRegionID(ChunkID chunkID)
+	{
+		glm::ivec2 chunkCoord = chunkIDToChunkCoord(chunkID);
+		glm::ivec2 regionCoord = glm::ivec2(glm::floor(glm::vec2(chunkCoord) / (float)RegionBatchingData::REGION_CHUNK_WIDTH));
+
+		return chunkCoordToChunkID(regionCoord);
+	}
+
+	// Dirty regions are queued in the chunk upload scheduler under this bit, ChunkIDs never use it
+	static const uint64_t REGION_UPLOAD_KEY = 1ull << 63;
+
+	void Renderer::renderWorld(const World& world)
+	{
+		FrameResources& frame = getCurrentFrameResorces();
+
+		frame.pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		frame.pCommandList->RSSetViewports(1, &frame.viewport);
+		frame.pCommandList->RSSetScissorRects(1, &frame.scissorRect);
+		frame.pCommandList->OMSetRenderTargets(1, &frame.cpuBackBufferRTV, false, &frame.cpuDepthTextureDSV);
+
+		// Background first, the far terrain uses a different depth range so the depth is cleared after
+		drawSkyBox();
+		drawFarTerrain(world);
+
+		frame.pCommandList->SetGraphicsRootSignature(m_pVoxelRootSignature);
+
+		frame.pCommandList->SetDescriptorHeaps(1, &m_pTextureDescHeap);
+		frame.pCommandList->SetGraphicsRootDescriptorTable(3, m_textureHandle);
+
+		frame.pCommandList->SetGraphicsRootConstantBufferView(0, m_renderDataGVA);
+
+		Timer submitTimer;
+
+		m_voxelDrawList.clear();
+		m_visibleDrawRegions.clear();
+		for (uint32_t i = 0; i < m_dxChunks.size(); i++)
+		{
+			if (!m_dxChunkVisibility[i])
+				continue;
+
+			const DXChunk& dxChunk = m_dxChunks[i];
+			const GPUMeshInfo* chunkMeshes[(uint32_t)VoxelPass::NUM_PASSES] = { &dxChunk.blockGPUMeshInfo, &dxChunk.waterGPUMeshInfo };
+
+			glm::vec3 chunkCenter = glm::vec3(chunkCoordToWorldCoord(chunkIDToChunkCoord(dxChunk.chunkID))) +
+				glm::vec3(CHUNK_WIDTH * 0.5f, (dxChunk.meshMinY + dxChunk.meshMaxY) * 0.5f, CHUNK_WIDTH * 0.5f);
+			float chunkDepth = glm::distance(m_cameraPos, chunkCenter);
+
+			uint32_t drawIdx = INVALID_UINT32;
+			for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+			{
+				if (dxChunk.mergedPasses & (1 << pass))
+				{
+					m_visibleDrawRegions.insert(getDrawRegionID(dxChunk.chunkID));
+					continue;
+				}
+
+				if (drawIdx == INVALID_UINT32)
+					drawIdx = m_voxelDrawList.addDrawData(chunkCoordToWorldCoord(chunkIDToChunkCoord(dxChunk.chunkID)));
+
+				const GPUMeshInfo& mesh = *chunkMeshes[pass];
+				m_voxelDrawList.addDraw((VoxelPass)pass, drawIdx, mesh.vertexDataGVA, mesh.indicesView, mesh.indicesCount, chunkDepth);
+			}
+		}
+
+		// A region is drawn whole once any of its members is visible, the extra chunks are cheap compared to splitting the draw
+		for (uint64_t regionID : m_visibleDrawRegions)
+		{
+			auto regionIterator = m_drawRegions.find(regionID);
+			if (regionIterator == m_drawRegions.end())
+				continue;
+
+			// Regions don't track their height, so they're sorted by horizontal distance
+			const float regionWorldWidth = float(RegionBatchingData::REGION_CHUNK_WIDTH * CHUNK_WIDTH);
+			glm::vec2 regionCenter = (glm::vec2(chunkIDToChunkCoord(regionID)) + glm::vec2(0.5f)) * regionWorldWidth;
+			float regionDepth = glm::distance(glm::vec2(m_cameraPos.x, m_cameraPos.z), regionCenter);
+
+			const DrawRegion& region = regionIterator->second;
+			for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+			{
+				const std::vector<GPUDrawCallData>& members = region.mergedMembers[pass];
+				if (members.empty())
+					continue;
+
+				uint32_t firstDrawIdx = (uint32_t)m_voxelDrawList.getDrawData().size();
+				for (const GPUDrawCallData& member : members)
+					m_voxelDrawList.addDrawData(member.chunkWorldPos, member.vertexEnd);
+
+				const GPUMeshInfo& mergedMesh = region.mergedMeshes[pass];
+				m_voxelDrawList.addDraw((VoxelPass)pass, firstDrawIdx, mergedMesh.vertexDataGVA, mergedMesh.indicesView, mergedMesh.indicesCount, regionDepth, (uint32_t)members.size());
+			}
+		}
+
+		if (m_sortDraws)
+		{
+			Timer sortTimer;
+			m_voxelDrawList.sortDraws();
+			m_renderStats.sortTimeMS = sortTimer.measure() * 1000.f;
+		}
+
+		m_renderStats.numDrawnRegions = (uint32_t)m_visibleDrawRegions.size();
+		m_renderStats.numDraws = m_voxelDrawList.getNumDraws();
+
+		// All chunk positions in one buffer instead of a constant buffer per chunk
+		const std::vector<GPUDrawCallData>& drawData = m_voxelDrawList.getDrawData();
+		D3D12_GPU_VIRTUAL_ADDRESS drawDataGVA = m_ringBuffer.allocate(drawData.data(), drawData.size() * sizeof(GPUDrawCallData));
+		frame.pCommandList->SetGraphicsRootShaderResourceView(4, drawDataGVA);
+
+		// Written for all partitions up front since the ring buffer isn't thread safe.
+		// The ring buffer is in an upload heap, which is always readable as indirect arguments
+		uint64_t argumentOffsets[(uint32_t)VoxelPass::NUM_PASSES] = {};
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES && m_indirectDrawing; pass++)
+		{
+			const std::vector<IndirectDrawArguments>& draws = m_voxelDrawList.getDraws((VoxelPass)pass);
+			if (draws.empty())
+				continue;
+
+			uint64_t byteWidth = draws.size() * sizeof(IndirectDrawArguments);
+			argumentOffsets[pass] = m_ringBuffer.reserve(byteWidth);
+			memcpy(m_ringBuffer.getMappedPtr(argumentOffsets[pass]), draws.data(), byteWidth);
+		}
+
+		uint32_t maxPartitions = m_drawRecordingData.multithreaded ? DrawRecordingData::NUM_THREADS : 1;
+		uint32_t numPartitions = m_voxelDrawList.partitionDraws(maxPartitions, DrawRecordingData::MIN_DRAWS_PER_THREAD, m_voxelDrawRanges);
+
+		std::latch bundlesRecorded(numPartitions ? numPartitions - 1 : 0);
+		for (uint32_t partitionIdx = 1; partitionIdx < numPartitions; partitionIdx++)
+		{
+			m_drawRecordingThreadPool.queueJob([&, partitionIdx]()
+				{
+					ID3D12GraphicsCommandList* pBundle = frame.pBundles[partitionIdx - 1];
+					reset(frame.pBundleAllocators[partitionIdx - 1], pBundle);
+
+					// Bundles only inherit the render targets & viewport, everything else is set again
+					pBundle->SetGraphicsRootSignature(m_pVoxelRootSignature);
+					pBundle->SetDescriptorHeaps(1, &m_pTextureDescHeap);
+					pBundle->SetGraphicsRootDescriptorTable(3, m_textureHandle);
+					pBundle->SetGraphicsRootConstantBufferView(0, m_renderDataGVA);
+					pBundle->SetGraphicsRootShaderResourceView(4, drawDataGVA);
+					pBundle->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+					recordVoxelDraws(pBundle, partitionIdx, argumentOffsets);
+					DX_CHECK(pBundle->Close());
+
+					bundlesRecorded.count_down();
+				});
+		}
+
+		// The first partition goes straight into the frame's list while the workers record theirs
+		recordVoxelDraws(frame.pCommandList, 0, argumentOffsets);
+		bundlesRecorded.wait();
+
+		for (uint32_t partitionIdx = 1; partitionIdx < numPartitions; partitionIdx++)
+			frame.pCommandList->ExecuteBundle(frame.pBundles[partitionIdx - 1]);
+
+		m_renderStats.numDrawCalls = m_indirectDrawing ? (uint32_t)m_voxelDrawRanges.size() : m_renderStats.numDraws;
+		m_renderStats.numRecordingThreads = numPartitions;
+		m_renderStats.submitTimeMS = submitTimer.measure() * 1000.f;
+
+		drawClouds(world);
+	}
+
+	void Renderer::postRender()
+	{
+		FrameResources& frame = getCurrentFrameResorces();
+		
+		frame.pCommandList->SetDescriptorHeaps(1, &m_pImguiDescriptorHeap);
+		imguiEndFrame(frame.pCommandList);
+
+		transitionResource(frame.pCommandList, frame.pBackBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+
+		submitUploads();
+		execute(frame.pCommandList);
+		m_pSwapChain->Present(0, 0);
+
+		signal(frame.pFence, frame.fenceValue);
+		m_ringBuffer.endFrame(m_pCommandQueue);
+	}
+
+	void Renderer::recordVoxelDraws(ID3D12GraphicsCommandList* pCommandList, uint32_t partitionIdx, const uint64_t* pArgumentOffsets)
+	{
+		// Called from several threads at once, only reads the draw list
+		VoxelPass currentPass = VoxelPass::NUM_PASSES;
+
+		for (const VoxelDrawRange& range : m_voxelDrawRanges)
+		{
+			if (range.partitionIdx != partitionIdx)
+				continue;
+
+			if (range.pass != currentPass)
+			{
+				pCommandList->SetPipelineState(range.pass == VoxelPass::WATER ? m_pWaterPSO : m_pVoxelPSO);
+				currentPass = range.pass;
+			}
+
+			if (m_indirectDrawing)
+			{
+				uint64_t argumentsOffset = pArgumentOffsets[(uint32_t)range.pass] + range.firstDraw * sizeof(IndirectDrawArguments);
+				pCommandList->ExecuteIndirect(m_pVoxelCommandSignature, range.numDraws, m_ringBuffer.getDXResource(), argumentsOffset, nullptr, 0);
+				continue;
+			}
+
+			const std::vector<IndirectDrawArguments>& draws = m_voxelDrawList.getDraws(range.pass);
+			for (uint32_t i = range.firstDraw; i < range.firstDraw + range.numDraws; i++)
+			{
+				const IndirectDrawArguments& draw = draws[i];
+				pCommandList->SetGraphicsRoot32BitConstants(1, 2, &draw.drawIdx, 0);
+				pCommandList->SetGraphicsRootShaderResourceView(2, draw.vertexDataGVA);
+				pCommandList->IASetIndexBuffer(&draw.indicesView);
+				pCommandList->DrawIndexedInstanced(draw.drawArguments.IndexCountPerInstance, 1, 0, 0, 0);
+			}
+		}
+	}
+
+	void Renderer::drawSkyBox()
+	{
+		// Function assumes the correct RTV, viewport, etc are already bound
+
+		FrameResources& frame = getCurrentFrameResorces();
+		
+		frame.pCommandList->SetGraphicsRootSignature(m_pSkyBoxRootSignature);
+		frame.pCommandList->SetPipelineState(m_pSkyBoxPSO);
+		frame.pCommandList->SetGraphicsRootConstantBufferView(0, m_renderDataGVA);
+
+		frame.pCommandList->DrawInstanced(36, 1, 0, 0);
+	}
+
+	void Renderer::drawFarTerrain(const World& world)
+	{
+		// Function assumes the correct RTV, viewport, etc are already bound
+
+		FrameResources& frame = getCurrentFrameResorces();
+		const FarTerrain& farTerrain = world.m_farTerrain;
+
+		if (farTerrain.m_enabled)
+		{
+			frame.pCommandList->SetGraphicsRootSignature(m_pFarTerrainRootSignature);
+			frame.pCommandList->SetPipelineState(m_pFarTerrainPSO);
+			frame.pCommandList->SetGraphicsRootConstantBufferView(0, m_farTerrainRenderDataGVA);
+			frame.pCommandList->SetGraphicsRootShaderResourceView(2, m_pFarTerrainHeights->GetGPUVirtualAddress());
+			frame.pCommandList->SetGraphicsRootShaderResourceView(3, m_farTerrainLevelsGVA);
+
+			for (uint32_t i = 0; i < FarTerrain::NUM_LEVELS; i++)
+			{
+				if (!farTerrain.getLevel(i).active)
+					continue;
+
+				frame.pCommandList->SetGraphicsRoot32BitConstant(1, i, 0);
+				frame.pCommandList->DrawInstanced(FarTerrain::GRID_CELLS * FarTerrain::GRID_CELLS * 6, 1, 0, 0);
+			}
+		}
+
+		frame.pCommandList->ClearDepthStencilView(frame.cpuDepthTextureDSV, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
+	}
+
+	void Renderer::drawClouds(const World& world)
+	{
+		// Function assumes the correct RTV, viewport, etc are already bound
+
+		FrameResources& frame = getCurrentFrameResorces();
+
+		// Meshed clouds draw one quad per instance instead of a cube
+		const CloudBuffer& cloudBuffer = m_meshedClouds ? m_cloudQuads : m_cloudPoints;
+		if (!cloudBuffer.numInstances)
+			return;
+
+		GPUCloudsRenderData cloudRenderData = {};
+		cloudRenderData.colour = world.m_cloudGenData.colour;
+		cloudRenderData.offset = glm::vec3(world.m_cloudGenData.globalDrift.x, 0.f, world.m_cloudGenData.globalDrift.y);
+		cloudRenderData.scale = world.m_cloudGenData.scale;
+		cloudRenderData.voxelSize = world.getCloudField().getVoxelSize();
+
+		D3D12_GPU_VIRTUAL_ADDRESS cloudsRenderDataGVA = m_ringBuffer.allocate(&cloudRenderData, sizeof(GPUCloudsRenderData));
+
+		frame.pCommandList->SetGraphicsRootSignature(m_pCloudsRootSignature);
+		frame.pCommandList->SetPipelineState(m_meshedClouds ? m_pCloudsMeshPSO : m_pCloudsPSO);
+		frame.pCommandList->SetGraphicsRootConstantBufferView(0, m_renderDataGVA);
+		frame.pCommandList->SetGraphicsRootShaderResourceView(1, cloudBuffer.pElements->GetGPUVirtualAddress());
+		frame.pCommandList->SetGraphicsRootConstantBufferView(2, cloudsRenderDataGVA);
+		frame.pCommandList->SetGraphicsRootShaderResourceView(3, cloudBuffer.pInstances->GetGPUVirtualAddress());
+
+		frame.pCommandList->DrawInstanced(m_meshedClouds ? 6 : 36, cloudBuffer.numInstances, 0, 0);
+	}
+
+	void Renderer::signal(ID3D12Fence* pFence, uint64_t& fenceValue)
+	{
+		DX_CHECK(m_pCommandQueue->Signal(pFence, ++fenceValue));
+	}
+
+	void Renderer::execute(ID3D12GraphicsCommandList* pCommandList)
+	{
+		DX_CHECK(pCommandList->Close());
+		m_pCommandQueue->ExecuteCommandLists(1, (ID3D12CommandList**)&pCommandList);
+	}
+
+	void Renderer::wait(ID3D12Fence* pFence, uint64_t fenceValue)
+	{
+		if (pFence->GetCompletedValue() >= fenceValue)
+			return;
+
+		HANDLE eventHandle = CreateEventEx(nullptr, 0, 0, EVENT_ALL_ACCESS);
+		DX_CHECK(pFence->SetEventOnCompletion(fenceValue, eventHandle));
+
+		WaitForSingleObject(eventHandle, INFINITE);
+		CloseHandle(eventHandle);
+	}
+
+	void Renderer::reset(ID3D12CommandAllocator* pCommandAlloator, ID3D12GraphicsCommandList* pCommandList)
+	{
+		DX_CHECK(pCommandAlloator->Reset());
+		DX_CHECK(pCommandList->Reset(pCommandAlloator, nullptr));
+	}
+
+	void Renderer::flush(ID3D12GraphicsCommandList* pCommandList, ID3D12CommandAllocator* pCommandAlloator, ID3D12Fence* pFence, uint64_t& fenceValue)
+	{
+		execute(pCommandList);
+		signal(pFence, fenceValue);
+		wait(pFence, fenceValue);
+		reset(pCommandAlloator, pCommandList);
+	}
+
+	void Renderer::addToFrameGarbage(IUnknown* pDxUnknown)
+	{
+		m_frameGarbage.emplace_back(m_pSwapChain->GetCurrentBackBufferIndex(), pDxUnknown);
+	}
+
+	void Renderer::addToFrameGarbage(ResourceArena& arena, const ResourceSlot& slot)
+	{
+		m_frameSlotGarbage.emplace_back(m_pSwapChain->GetCurrentBackBufferIndex(), &arena, slot);
+	}
+
+	void Renderer::removeMeshAllocation(ResourceArena& arena, const ResourceSlot& slot)
+	{
+		// The copy queue doesn't wait for the frames in flight, so a range they still draw from can't be handed out to the next upload yet.
+		// On the direct queue the new copy is ordered after those draws anyway
+		if (m_uploadsOnCopyQueue)
+		{
+			addToFrameGarbage(arena, slot);
+		}
+		else
+		{
+			arena.removeAllocation(slot);
+			m_numIdleDefragChunks = 0;
+		}
+	}
+
+	void Renderer::clearFrameGarbage()
+	{
+		uint32_t currentFrameIdx = m_pSwapChain->GetCurrentBackBufferIndex();
+		for (int i = (int)m_frameGarbage.size() - 1; i >= 0; i--)
+		{
+			if (m_frameGarbage[i].frameIdx == currentFrameIdx)
+			{
+				D3D12_RELEASE(m_frameGarbage[i].pDxUnknown);
+				m_frameGarbage.erase(m_frameGarbage.begin() + i);
+			}
+		}
+
+		for (int i = (int)m_frameSlotGarbage.size() - 1; i >= 0; i--)
+		{
+			if (m_frameSlotGarbage[i].frameIdx == currentFrameIdx)
+			{
+				m_frameSlotGarbage[i].pArena->removeAllocation(m_frameSlotGarbage[i].slot);
+				m_frameSlotGarbage.erase(m_frameSlotGarbage.begin() + i);
+				m_numIdleDefragChunks = 0;
+			}
+		}
+	}
+
+	void Renderer::transitionResource(ID3D12GraphicsCommandList* pCommandList, ID3D12Resource* pResource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES newState, uint32_t subResource)
+	{
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Transition.pResource = pResource;
+		barrier.Transition.StateBefore = beforeState;
+		barrier.Transition.StateAfter = newState;
+		barrier.Transition.Subresource = subResource;
+		barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+
+		pCommandList->ResourceBarrier(1, &barrier);
+	}
+
+	void Renderer::updateDefaultHeapResource(ID3D12Resource* pTarget, uint64_t targetOffset, const void* pData, uint64_t dataSize, ID3D12GraphicsCommandList* pCommandList)
+	{
+		if (!pCommandList)
+			pCommandList = getCurrentFrameResorces().pCommandList;
+
+		uint64_t uploadBufferOffset = m_ringBuffer.reserve(dataSize, D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT);
+		memcpy(m_ringBuffer.getMappedPtr(uploadBufferOffset), pData, dataSize);
+		pCommandList->CopyBufferRegion(pTarget, targetOffset, m_ringBuffer.getDXResource(), uploadBufferOffset, dataSize);
+	}
+
+	ID3D12GraphicsCommandList* Renderer::getUploadCommandList()
+	{
+		FrameResources& frame = getCurrentFrameResorces();
+		if (!m_uploadsOnCopyQueue)
+			return frame.pCommandList;
+
+		m_copyListRecorded = true;
+		return frame.pCopyCommandList;
+	}
+
+	void Renderer::submitUploads()
+	{
+		if (!m_uploadsOnCopyQueue)
+			return;
+
+		FrameResources& frame = getCurrentFrameResorces();
+		DX_CHECK(frame.pCopyCommandList->Close());
+
+		if (!m_copyListRecorded)
+			return;
+
+		// GPU side wait, the CPU doesn't stall and the copies can overlap with the previous frames rendering
+		m_pCopyQueue->ExecuteCommandLists(1, (ID3D12CommandList**)&frame.pCopyCommandList);
+		DX_CHECK(m_pCopyQueue->Signal(m_pCopyFence, ++m_copyFenceValue));
+		DX_CHECK(m_pCommandQueue->Wait(m_pCopyFence, m_copyFenceValue));
+	}
+
+	static void addVertex(std::vector<uint32_t>& indices, std::vector<Vertex>& verticiesData, Vertex newVertex)
+	{
+		uint32_t idx = INVALID_UINT32;
+		int startIdx = glm::max((int)verticiesData.size() - 5, 0); // Lmao
+		for (uint64_t i = startIdx; i < verticiesData.size(); i++)
+		{
+			if (verticiesData[i] == newVertex)
+			{
+				idx = (uint32_t)i;
+				break;
+			}
+		}
+
+		if (idx == INVALID_UINT32)
+		{
+			indices.emplace_back((uint32_t)verticiesData.size());
+			verticiesData.emplace_back(newVertex);
+		}
+		else
+		{
+			indices.emplace_back(idx);
+		}
+	}
+
+	static bool isOutsideChunkXZ(const glm::ivec3& chunkBlockCoord)
+	{
+		return chunkBlockCoord.x < 0 || chunkBlockCoord.x >= (int)CHUNK_WIDTH || chunkBlockCoord.z < 0 || chunkBlockCoord.z >= (int)CHUNK_WIDTH;
+	}
+
+	// Flood fills the non solid blocks of each section, every pair of sides touched by the same fill can see each other
+	static void computeSectionConnectivity(const std::vector<uint8_t>& seeThroughBlocks, uint64_t* pOutConnectivity)
+	{
+		const glm::ivec3 sectionDims = glm::ivec3(CHUNK_WIDTH, SECTION_HEIGHT, CHUNK_WIDTH);
+		std::vector<uint8_t> visited(CHUNK_WIDTH * SECTION_HEIGHT * CHUNK_WIDTH);
+		std::vector<glm::ivec3> floodStack;
+
+		auto getSectionBlockIdx = [&](const glm::ivec3& sectionBlockCoord)
+			{
+				return sectionBlockCoord.x + sectionBlockCoord.y * sectionDims.x + sectionBlockCoord.z * sectionDims.x * sectionDims.y;
+			};
+
+		for (uint32_t section = 0; section < NUM_CHUNK_SECTIONS; section++)
+		{
+			const glm::ivec3 sectionOffset = glm::ivec3(0, section * SECTION_HEIGHT, 0);
+			std::fill(visited.begin(), visited.end(), 0);
+			uint64_t connectivity = 0;
+
+			for (int z = 0; z < sectionDims.z; z++)
+			{
+				for (int y = 0; y < sectionDims.y; y++)
+				{
+					for (int x = 0; x < sectionDims.x; x++)
+					{
+						glm::ivec3 startCoord = glm::ivec3(x, y, z);
+						if (visited[getSectionBlockIdx(startCoord)] || !seeThroughBlocks[chunkBlockCoordToChunkBlockIdx(startCoord + sectionOffset)])
+							continue;
+
+						visited[getSectionBlockIdx(startCoord)] = 1;
+						floodStack.emplace_back(startCoord);
+						uint8_t touchedSides = 0;
+
+						while (!floodStack.empty())
+						{
+							glm::ivec3 coord = floodStack.back();
+							floodStack.pop_back();
+
+							for (uint32_t side = 0; side < 6; side++)
+							{
+								glm::ivec3 adjacentCoord = coord + SIDE_DIRECTIONS[side];
+								if (glm::any(glm::lessThan(adjacentCoord, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(adjacentCoord, sectionDims)))
+								{
+									touchedSides |= 1 << side;
+									continue;
+								}
+
+								uint8_t& adjacentVisited = visited[getSectionBlockIdx(adjacentCoord)];
+								if (adjacentVisited || !seeThroughBlocks[chunkBlockCoordToChunkBlockIdx(adjacentCoord + sectionOffset)])
+									continue;
+
+								adjacentVisited = 1;
+								floodStack.emplace_back(adjacentCoord);
+							}
+						}
+
+						for (uint32_t sideA = 0; sideA < 6; sideA++)
+						{
+							for (uint32_t sideB = 0; sideB < 6; sideB++)
+							{
+								if ((touchedSides & (1 << sideA)) && (touchedSides & (1 << sideB)))
+									connectivity |= getSectionSidesBit(sideA, sideB);
+							}
+						}
+					}
+				}
+			}
+
+			pOutConnectivity[section] = connectivity;
+		}
+	}
+
+	static bool isLODCellFilled(BlockType block)
+	{
+		return block != BlockType::AIR && block != BlockType::WATER;
+	}
+
+	// Finds the block representing a (scale x scale x scale) cell, searched top down so surfaces keep their top block (like grass)
+	static BlockType sampleLODCell(const World* pWorld, const glm::ivec3& cellBlockCoord, int scale)
+	{
+		BlockType cellBlock = BlockType::AIR;
+
+		glm::ivec3 offset = glm::ivec3(0);
+		for (offset.y = scale - 1; offset.y >= 0; offset.y--)
+		{
+			for (offset.z = 0; offset.z < scale; offset.z++)
+			{
+				for (offset.x = 0; offset.x < scale; offset.x++)
+				{
+					BlockType block = pWorld->getBlockAtBlockCoord(cellBlockCoord + offset);
+					if (block == BlockType::INVALID || isLODCellFilled(block))
+						return block;
+
+					if (block == BlockType::WATER)
+						cellBlock = BlockType::WATER;
+				}
+			}
+		}
+
+		return cellBlock;
+	}
+
+	// Checks a horizontal face of a cell against the adjacent chunk's cells, sampled at the size & alignment that chunk is meshed at.
+	// Only the layer of adjacent cells touching the border can cover the face
+	// Lower detail cells are filled if any of their blocks are, so a coarser neighbour never exposes a face the blocks don't
+	static bool isLODBorderFaceHidden(const World* pWorld, const glm::ivec3& adjacentCellBlockCoord, uint32_t side, int scale, int adjacentScale)
+	{
+		if (adjacentScale >= scale)
+		{
+			// Both are aligned to the world grid, so the face is within a single adjacent cell
+			glm::ivec3 alignedCoord = adjacentCellBlockCoord & glm::ivec3(~(adjacentScale - 1));
+			return World::isBlockTypeSolid(sampleLODCell(pWorld, alignedCoord, adjacentScale));
+		}
+
+		const glm::ivec3& direction = SIDE_DIRECTIONS[side];
+		glm::ivec3 layerCoord = adjacentCellBlockCoord - glm::min(direction, glm::ivec3(0)) * (scale - adjacentScale);
+
+		for (int v = 0; v < scale; v += adjacentScale)
+		{
+			for (int u = 0; u < scale; u += adjacentScale)
+			{
+				glm::ivec3 offset = glm::ivec3(direction.z ? u : 0, v, direction.x ? u : 0);
+				if (!World::isBlockTypeSolid(sampleLODCell(pWorld, layerCoord + offset, adjacentScale)))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool Renderer::isChunkMeshLatest(ChunkID chunkID, uint32_t chunkGenID)
+	{
+		std::shared_lock lock(s_loadingChunksMutis);
+
+		const auto& chunkIterator = m_loadingChunkMesh.find(chunkID);
+		if (chunkIterator == m_loadingChunkMesh.end())
+			return false;
+
+		return chunkIterator->second.latestChunkGenID == chunkGenID;
+	}
+
+	void Renderer::generateChunkMesh(const World* pWorld, ChunkID chunkID, uint32_t chunkGenID, const ChunkMeshingInfo& meshingInfo, ChunkMeshData& outMeshData)
+	{
+		outMeshData.meshingInfo = meshingInfo;
+		if (meshingInfo.lodLevel > 0)
+		{
+			// Too far away for cave culling to matter, lower detail meshes never block the flood
+			std::fill(std::begin(outMeshData.sectionConnectivity), std::end(outMeshData.sectionConnectivity), SECTION_FULLY_CONNECTED);
+			generateChunkLODMesh(pWorld, chunkID, chunkGenID, meshingInfo, outMeshData);
+			return;
+		}
+
+		glm::ivec2 chunkCoord = chunkIDToChunkCoord(chunkID);
+		glm::ivec3 worldCoord = chunkCoordToWorldCoord(chunkCoord);
+
+		outMeshData.blockMesh.vertices.reserve(MAX_BLOCKS_IN_CHUNK * 36ull);
+		outMeshData.blockMesh.indices.reserve(MAX_BLOCKS_IN_CHUNK * 36ull);
+
+		outMeshData.waterMesh.vertices.reserve(MAX_BLOCKS_IN_CHUNK * 36ull / 2);
+		outMeshData.waterMesh.indices.reserve(MAX_BLOCKS_IN_CHUNK * 36ull / 2);
+
+		uint16_t solidColumnHeights[CHUNK_WIDTH * CHUNK_WIDTH] = {};
+		std::vector<uint8_t> seeThroughBlocks(MAX_BLOCKS_IN_CHUNK);
+
+		for (uint32_t i = 0; i < MAX_BLOCKS_IN_CHUNK; i++)
+		{
+			if (!isChunkMeshLatest(chunkID, chunkGenID))
+				return;
+
+			BlockType block = pWorld->tryGetBlock(chunkID, i);
+			if (block == BlockType::INVALID) // Chunk is no longer loaded
+				return;
+
+			glm::ivec3 chunkBlockCoord = chunkBlockIdxToChunkBlockCoord(i);
+
+			// Each column is visited bottom up, so it stays solid until the first non solid block
+			uint16_t& solidColumnHeight = solidColumnHeights[chunkBlockCoord.x + chunkBlockCoord.z * CHUNK_WIDTH];
+			bool solid = World::isBlockTypeSolid(block);
+			if (solidColumnHeight == chunkBlockCoord.y && solid)
+				solidColumnHeight++;
+
+			seeThroughBlocks[i] = !solid;
+
+			if (block == BlockType::AIR)
+				continue;
+
+			glm::ivec3 worldBlockCoord = chunkBlockCoord + worldCoord;
+
+			if (block == BlockType::WATER)
+			{
+				if (pWorld->getBlockAtBlockCoord(worldBlockCoord + UP_DIR) != BlockType::WATER)
+					addWaterMeshData(chunkBlockCoord, 1, outMeshData.waterMesh);
+
+				continue;
+			}
+
+			uint8_t visibleSides = 0;
+			for (uint32_t side = 0; side < 6; side++)
+			{
+				if (!pWorld->isBlockCoordSolid(worldBlockCoord + SIDE_DIRECTIONS[side]))
+					visibleSides |= 1 << side;
+			}
+
+			addBlockMeshData(block, chunkBlockCoord, 1, visibleSides, outMeshData.blockMesh);
+		}
+
+		for (uint32_t cellZ = 0; cellZ < OCCLUDER_CELLS_PER_SIDE; cellZ++)
+		{
+			for (uint32_t cellX = 0; cellX < OCCLUDER_CELLS_PER_SIDE; cellX++)
+			{
+				uint16_t minHeight = WORLD_HEIGHT;
+				for (uint32_t z = 0; z < OCCLUDER_CELL_WIDTH; z++)
+				{
+					for (uint32_t x = 0; x < OCCLUDER_CELL_WIDTH; x++)
+					{
+						uint32_t columnIdx = (cellX * OCCLUDER_CELL_WIDTH + x) + (cellZ * OCCLUDER_CELL_WIDTH + z) * CHUNK_WIDTH;
+						minHeight = glm::min(minHeight, solidColumnHeights[columnIdx]);
+					}
+				}
+
+				outMeshData.occluderHeights[cellX + cellZ * OCCLUDER_CELLS_PER_SIDE] = minHeight;
+			}
+		}
+
+		computeSectionConnectivity(seeThroughBlocks, outMeshData.sectionConnectivity);
+	}
+
+	void Renderer::generateChunkLODMesh(const World* pWorld, ChunkID chunkID, uint32_t chunkGenID, const ChunkMeshingInfo& meshingInfo, ChunkMeshData& outMeshData)
+	{
+		// Cells are aligned to the world grid, so adjacent chunks at the same level always agree on their shared border
+		const int scale = 1 << meshingInfo.lodLevel;
+		const glm::ivec3 cellDims = glm::ivec3(CHUNK_WIDTH, WORLD_HEIGHT, CHUNK_WIDTH) / scale;
+		const glm::ivec3 worldCoord = chunkCoordToWorldCoord(chunkIDToChunkCoord(chunkID));
+
+		auto getCellIdx = [&](const glm::ivec3& cellCoord)
+			{
+				return cellCoord.x + cellCoord.y * cellDims.x + cellCoord.z * cellDims.x * cellDims.y;
+			};
+
+		std::vector<BlockType> cells((uint64_t)cellDims.x * cellDims.y * cellDims.z);
+
+		glm::ivec3 cellCoord = glm::ivec3(0);
+		for (cellCoord.z = 0; cellCoord.z < cellDims.z; cellCoord.z++)
+		{
+			if (!isChunkMeshLatest(chunkID, chunkGenID))
+				return;
+
+			for (cellCoord.y = 0; cellCoord.y < cellDims.y; cellCoord.y++)
+			{
+				for (cellCoord.x = 0; cellCoord.x < cellDims.x; cellCoord.x++)
+				{
+					BlockType cell = sampleLODCell(pWorld, worldCoord + cellCoord * scale, scale);
+					if (cell == BlockType::INVALID) // Chunk is no longer loaded
+						return;
+
+					cells[getCellIdx(cellCoord)] = cell;
+				}
+			}
+		}
+
+		for (cellCoord.z = 0; cellCoord.z < cellDims.z; cellCoord.z++)
+		{
+			for (cellCoord.y = 0; cellCoord.y < cellDims.y; cellCoord.y++)
+			{
+				for (cellCoord.x = 0; cellCoord.x < cellDims.x; cellCoord.x++)
+				{
+					BlockType cell = cells[getCellIdx(cellCoord)];
+					if (cell == BlockType::AIR)
+						continue;
+
+					glm::ivec3 chunkBlockCoord = cellCoord * scale;
+
+					if (cell == BlockType::WATER)
+					{
+						bool topOfWorld = cellCoord.y + 1 >= cellDims.y;
+						if (topOfWorld || cells[getCellIdx(cellCoord + UP_DIR)] != BlockType::WATER)
+							addWaterMeshData(chunkBlockCoord, scale, outMeshData.waterMesh);
+
+						continue;
+					}
+
+					uint8_t visibleSides = 0;
+					for (uint32_t side = 0; side < 6; side++)
+					{
+						glm::ivec3 adjacentCellCoord = cellCoord + SIDE_DIRECTIONS[side];
+
+						BlockType adjacentCell = BlockType::AIR;
+						if (adjacentCellCoord.y < 0 || adjacentCellCoord.y >= cellDims.y)
+						{
+							adjacentCell = BlockType::AIR;
+						}
+						else if (isOutsideChunkXZ(adjacentCellCoord * scale))
+						{
+							int adjacentScale = 1 << meshingInfo.adjacentLODLevels[side];
+							if (!isLODBorderFaceHidden(pWorld, worldCoord + adjacentCellCoord * scale, side, scale, adjacentScale))
+								visibleSides |= 1 << side;
+
+							continue;
+						}
+						else
+						{
+							adjacentCell = cells[getCellIdx(adjacentCellCoord)];
+						}
+
+						if (!World::isBlockTypeSolid(adjacentCell))
+							visibleSides |= 1 << side;
+					}
+
+					addBlockMeshData(cell, chunkBlockCoord, scale, visibleSides, outMeshData.blockMesh);
+				}
+			}
+		}
+	}
 
-	void Renderer::addBlockMeshData(const World* pWorld, BlockType block, const glm::ivec3& chunkBlockCoord, const glm::ivec3& worldBlockCoord, MeshData& outMeshData)
+	void Renderer::addBlockMeshData(BlockType block, const glm::ivec3& chunkBlockCoord, int scale, uint8_t visibleSides, MeshData& outMeshData)
 	{
 		// Top
-		if (!pWorld->isBlockCoordSolid(worldBlockCoord + UP_DIR))
+		if (visibleSides & (1 << 0))
 		{
 			uint32_t textureId = getTextureID(block, BlockSide::TOP);
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0), glm::vec2(1, 0), textureId, 0));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 1), glm::vec2(1, 1), textureId, 0));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1), glm::vec2(0, 1), textureId, 0));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0) * scale, glm::vec2(1, 0), textureId, 0));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 1) * scale, glm::vec2(1, 1), textureId, 0));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1) * scale, glm::vec2(0, 1), textureId, 0));
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1), glm::vec2(0, 1), textureId, 0));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0), glm::vec2(0, 0), textureId, 0));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0), glm::vec2(1, 0), textureId, 0));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1) * scale, glm::vec2(0, 1), textureId, 0));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0) * scale, glm::vec2(0, 0), textureId, 0));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0) * scale, glm::vec2(1, 0), textureId, 0));
 		}
 
 		// Bottom
-		if (!pWorld->isBlockCoordSolid(worldBlockCoord - UP_DIR))
+		if (visibleSides & (1 << 1))
 		{
 			uint32_t textureId = getTextureID(block, BlockSide::BOTTOM);
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1), glm::vec2(1, 1), textureId, 1));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1), glm::vec2(1, 0), textureId, 1));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0), glm::vec2(0, 0), textureId, 1));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1) * scale, glm::vec2(1, 1), textureId, 1));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1) * scale, glm::vec2(1, 0), textureId, 1));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0) * scale, glm::vec2(0, 0), textureId, 1));
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0), glm::vec2(0, 0), textureId, 1));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 0), glm::vec2(0, 1), textureId, 1));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1), glm::vec2(1, 1), textureId, 1));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0) * scale, glm::vec2(0, 0), textureId, 1));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 0) * scale, glm::vec2(0, 1), textureId, 1));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1) * scale, glm::vec2(1, 1), textureId, 1));
 		}
 
 		// Right
-		if (!pWorld->isBlockCoordSolid(worldBlockCoord + RIGHT_DIR))
+		if (visibleSides & (1 << 2))
 		{
 			uint32_t textureId = getTextureID(block, BlockSide::SIDE);
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0), glm::vec2(0, 0), textureId, 2));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1), glm::vec2(1, 0), textureId, 2));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1), glm::vec2(1, 1), textureId, 2));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0) * scale, glm::vec2(0, 0), textureId, 2));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1) * scale, glm::vec2(1, 0), textureId, 2));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1) * scale, glm::vec2(1, 1), textureId, 2));
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0), glm::vec2(0, 0), textureId, 2));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1), glm::vec2(1, 1), textureId, 2));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 0), glm::vec2(0, 1), textureId, 2));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0) * scale, glm::vec2(0, 0), textureId, 2));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1) * scale, glm::vec2(1, 1), textureId, 2));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 0) * scale, glm::vec2(0, 1), textureId, 2));
 		}
 
 		// Left
-		if (!pWorld->isBlockCoordSolid(worldBlockCoord - RIGHT_DIR))
+		if (visibleSides & (1 << 3))
 		{
 			uint32_t textureId = getTextureID(block, BlockSide::SIDE);
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1), glm::vec2(0, 1), textureId, 3));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 1), glm::vec2(0, 0), textureId, 3));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0), glm::vec2(1, 0), textureId, 3));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1) * scale, glm::vec2(0, 1), textureId, 3));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 1) * scale, glm::vec2(0, 0), textureId, 3));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0) * scale, glm::vec2(1, 0), textureId, 3));
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0), glm::vec2(1, 1), textureId, 3));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1), glm::vec2(0, 1), textureId, 3));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0), glm::vec2(1, 0), textureId, 3));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0) * scale, glm::vec2(1, 1), textureId, 3));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1) * scale, glm::vec2(0, 1), textureId, 3));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0) * scale, glm::vec2(1, 0), textureId, 3));
 		}
 
 		// Forward
-		if (!pWorld->isBlockCoordSolid(worldBlockCoord + FORWARD_DIR))
+		if (visibleSides & (1 << 4))
 		{
 			uint32_t textureId = getTextureID(block, BlockSide::SIDE);
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1), glm::vec2(0, 0), textureId, 4));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 1), glm::vec2(1, 0), textureId, 4));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1), glm::vec2(1, 1), textureId, 4));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1) * scale, glm::vec2(0, 0), textureId, 4));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 1) * scale, glm::vec2(1, 0), textureId, 4));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1) * scale, glm::vec2(1, 1), textureId, 4));
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1), glm::vec2(1, 1), textureId, 4));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1), glm::vec2(0, 1), textureId, 4));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1), glm::vec2(0, 0), textureId, 4));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 1) * scale, glm::vec2(1, 1), textureId, 4));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 1) * scale, glm::vec2(0, 1), textureId, 4));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1) * scale, glm::vec2(0, 0), textureId, 4));
 		}
 
 		// Backward
-		if (!pWorld->isBlockCoordSolid(worldBlockCoord - FORWARD_DIR))
+		if (visibleSides & (1 << 5))
 		{
 			uint32_t textureId = getTextureID(block, BlockSide::SIDE);
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0), glm::vec2(0, 1), textureId, 5));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0), glm::vec2(0, 0), textureId, 5));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0), glm::vec2(1, 0), textureId, 5));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0) * scale, glm::vec2(0, 1), textureId, 5));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0) * scale, glm::vec2(0, 0), textureId, 5));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0) * scale, glm::vec2(1, 0), textureId, 5));
+
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0) * scale, glm::vec2(1, 0), textureId, 5));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 0) * scale, glm::vec2(1, 1), textureId, 5));
+			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0) * scale, glm::vec2(0, 1), textureId, 5));
+		}
+	}
+
+	void Renderer::addWaterMeshData(const glm::ivec3& chunkBlockCoord, int scale, MeshData& outMeshData)
+	{
+		// Top
+		uint32_t textureId = getTextureID(BlockType::WATER, BlockSide::SIDE);
+
+		addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0) * scale, glm::vec2(1, 0), textureId));
+		addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 1) * scale, glm::vec2(1, 1), textureId));
+		addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1) * scale, glm::vec2(0, 1), textureId));
+
+		addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1) * scale, glm::vec2(0, 1), textureId));
+		addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0) * scale, glm::vec2(0, 0), textureId));
+		addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0) * scale, glm::vec2(1, 0), textureId));
+	}
+
+	void Renderer::updateChunks(const World& world)
+	{
+		for (ChunkID chunkID : world.getRemovedChunks())
+		{
+			findAndDeleteDXChunk(chunkID);
+		}
+
+		std::unique_lock lock(s_loadingChunksMutis);
+		processAddedChunks(world);
+		updateChunkLODs(world);
+		processLoadingChunkMeshes(world);
+		defragmentMeshArenas();
+	}
+
+	void Renderer::processAddedChunks(const World& world)
+	{
+		// Not sure if should be static or not, prolly doesn't really matter :3
+		static const glm::ivec2 OFFSETS[] =
+		{
+			glm::ivec2( 0,  0),
+			glm::ivec2(-1,  0),
+			glm::ivec2( 1,  0),
+			glm::ivec2( 0, -1),
+			glm::ivec2( 0,  1),
+		};
+
+		for (ChunkID chunkID : world.getAddedChunks())
+		{
+			glm::ivec2 chunkCoord = chunkIDToChunkCoord(chunkID);
+			for (const glm::ivec2& offset : OFFSETS)
+			{
+				ChunkID adjacentChunkID = chunkCoordToChunkID(chunkCoord + offset);
+				if (!world.isChunkLoaded(adjacentChunkID))
+					continue;
+
+				queueChunkMesh(world, adjacentChunkID);
+			}
+		}
+	}
+
+	void Renderer::updateChunkLODs(const World& world)
+	{
+		bool lodDataChanged = memcmp(&m_appliedLodData, &m_lodData, sizeof(LevelOfDetailData)) != 0;
+		if (m_lodCamChunkCoord == m_currentCamChunkCoord && !lodDataChanged)
+			return;
+
+		m_lodCamChunkCoord = m_currentCamChunkCoord;
+		m_appliedLodData = m_lodData;
+
+		// The meshing info includes the neighbours' levels, so chunks whose borders need to change are remeshed as well
+		for (const DXChunk& dxChunk : m_dxChunks)
+		{
+			if (dxChunk.meshingInfo != findChunkMeshingInfo(dxChunk.chunkID) && world.isChunkLoaded(dxChunk.chunkID))
+				queueChunkMesh(world, dxChunk.chunkID);
+		}
+	}
+
+	void Renderer::queueChunkMesh(const World& world, ChunkID chunkID)
+	{
+		uint32_t chunkGenID = INVALID_UINT32;
+		auto chunkIterator = m_loadingChunkMesh.find(chunkID);
+
+		if (chunkIterator != m_loadingChunkMesh.end())
+		{
+			ThreadSafeChunkMesh& chunkMesh = chunkIterator->second;
+			chunkGenID = ++chunkMesh.latestChunkGenID;
+			chunkMesh.meshGenerated.store(false);
+		}
+		else
+		{
+			ThreadSafeChunkMesh& chunkMesh = m_loadingChunkMesh[chunkID];
+			chunkMesh.latestChunkGenID = 0;
+			chunkGenID = 0;
+			chunkMesh.meshGenerated.store(false);
+		}
+
+		ChunkMeshingInfo meshingInfo = findChunkMeshingInfo(chunkID);
+
+		const World* pWorld = &world;
+		m_threadPool.queueJob([=]()
+			{
+				ChunkMeshData outMeshData;
+				generateChunkMesh(pWorld, chunkID, chunkGenID, meshingInfo, outMeshData);
+
+				std::shared_lock lock(s_loadingChunksMutis);
+				auto chunkIterator = m_loadingChunkMesh.find(chunkID);
+				if (chunkIterator == m_loadingChunkMesh.end())
+					return;
+
+				ThreadSafeChunkMesh& threadChunk = chunkIterator->second;
+				if (threadChunk.latestChunkGenID == chunkGenID)
+				{
+					threadChunk.meshData = std::move(outMeshData);
+					threadChunk.meshGenerated.store(true);
+				}
+			});
+	}
+
+	uint32_t Renderer::findChunkLOD(ChunkID chunkID) const
+	{
+		glm::vec2 camToChunk = glm::vec2(chunkIDToChunkCoord(chunkID) - m_currentCamChunkCoord);
+		float distanceSquared = glm::dot(camToChunk, camToChunk);
+
+		uint32_t lodLevel = 0;
+		for (uint32_t i = 0; i < LevelOfDetailData::NUM_LEVELS - 1; i++)
+		{
+			float levelDistance = (float)m_lodData.levelDistances[i];
+			if (distanceSquared >= levelDistance * levelDistance)
+				lodLevel = i + 1;
+		}
+
+		return lodLevel;
+	}
+
+	ChunkMeshingInfo Renderer::findChunkMeshingInfo(ChunkID chunkID) const
+	{
+		ChunkMeshingInfo meshingInfo;
+		meshingInfo.lodLevel = findChunkLOD(chunkID);
+
+		// Full detail meshes only look at the blocks, so they don't depend on the neighbours' levels
+		if (meshingInfo.lodLevel == 0)
+			return meshingInfo;
+
+		glm::ivec2 chunkCoord = chunkIDToChunkCoord(chunkID);
+		for (uint32_t side = 2; side < 6; side++)
+		{
+			glm::ivec2 adjacentChunkCoord = chunkCoord + glm::ivec2(SIDE_DIRECTIONS[side].x, SIDE_DIRECTIONS[side].z);
+			meshingInfo.adjacentLODLevels[side] = findChunkLOD(chunkCoordToChunkID(adjacentChunkCoord));
+		}
+
+		return meshingInfo;
+	}
+
+	static uint64_t getMeshDataSize(const MeshData& meshData)
+	{
+		return meshData.vertices.size() * sizeof(Vertex) + meshData.indices.size() * sizeof(uint32_t);
+	}
+
+	static bool isBatchedMesh(const MeshData& meshData)
+	{
+		return !meshData.vertices.empty() && meshData.vertices.size() <= RegionBatchingData::MAX_BATCHED_VERTICES;
+	}
+
+	static void expandMeshHeightRange(const MeshData& meshData, float& minY, float& maxY)
+	{
+		for (Vertex vertex : meshData.vertices)
+		{
+			float y = (float)vertex.readBits(5, 9);
+			minY = glm::min(minY, y);
+			maxY = glm::max(maxY, y);
+		}
+	}
+
+	void Renderer::processLoadingChunkMeshes(const World& world)
+	{
+		m_numUploadedBytes = 0;
+
+		auto chunkIterator = m_loadingChunkMesh.begin();
+		while (chunkIterator != m_loadingChunkMesh.end())
+		{
+			ChunkID chunkID = chunkIterator->first;
+			ThreadSafeChunkMesh& threadChunk = chunkIterator->second;
+
+			// Also removes meshes that were re-queued after being scheduled, they're pushed again once the new mesh is done
+			if (!threadChunk.meshGenerated.load())
+			{
+				m_uploadScheduler.remove(chunkID);
+				++chunkIterator;
+				continue;
+			}
+
+			if (!world.isChunkLoaded(chunkID))
+			{
+				m_uploadScheduler.remove(chunkID);
+				chunkIterator = m_loadingChunkMesh.erase(chunkIterator);
+				continue;
+			}
+
+			// The camera can move to another chunk while meshing, a mesh made for other levels would leave cracks at its borders
+			if (threadChunk.meshData.meshingInfo != findChunkMeshingInfo(chunkID))
+			{
+				m_uploadScheduler.remove(chunkID);
+				queueChunkMesh(world, chunkID);
+				++chunkIterator;
+				continue;
+			}
+
+			// Batched meshes are only uploaded as part of their region
+			uint64_t uploadSize = 0;
+			for (const MeshData* pMesh : { &threadChunk.meshData.blockMesh, &threadChunk.meshData.waterMesh })
+			{
+				if (!m_regionBatching.enabled || !isBatchedMesh(*pMesh))
+					uploadSize += getMeshDataSize(*pMesh);
+			}
+
+			m_uploadScheduler.push(chunkID, uploadSize);
+			++chunkIterator;
+		}
+
+		// Switching batching moves the small meshes between the merged meshes & their chunks' own allocations, region by region
+		if (m_drawRegionsMerged != m_regionBatching.enabled)
+		{
+			m_drawRegionsMerged = m_regionBatching.enabled;
+			for (const auto& [regionID, region] : m_drawRegions)
+				m_dirtyDrawRegions.insert(regionID);
+		}
+
+		// Merged meshes are rewritten whole when a member changes, so they share the chunks' budget
+		for (uint64_t regionID : m_dirtyDrawRegions)
+			m_uploadScheduler.push(regionID | REGION_UPLOAD_KEY, getDrawRegionUploadSize(regionID));
+
+		// Leaving room in the ring buffer for the frames in flight
+		uint64_t byteBudget = glm::min(m_uploadData.bytesPerFrame ? (uint64_t)m_uploadData.bytesPerFrame : UINT64_MAX, m_ringBuffer.getSize() / 2);
+
+		std::vector<uint64_t> scheduledKeys;
+		m_uploadScheduler.schedule(byteBudget, [&](uint64_t key)
+			{
+				if (key & REGION_UPLOAD_KEY)
+				{
+					const float regionWidth = (float)RegionBatchingData::REGION_CHUNK_WIDTH;
+					glm::vec2 regionOffset = (glm::vec2(chunkIDToChunkCoord(key & ~REGION_UPLOAD_KEY)) + glm::vec2(0.5f)) * regionWidth - glm::vec2(m_currentCamChunkCoord);
+					return glm::dot(regionOffset, regionOffset);
+				}
+
+				glm::ivec2 chunkOffset = chunkIDToChunkCoord(key) - m_currentCamChunkCoord;
+				return float(chunkOffset.x * chunkOffset.x + chunkOffset.y * chunkOffset.y);
+			}, scheduledKeys);
+
+		std::vector<uint64_t> scheduledChunks;
+		std::vector<uint64_t> scheduledRegions;
+		for (uint64_t key : scheduledKeys)
+		{
+			if (key & REGION_UPLOAD_KEY)
+				scheduledRegions.emplace_back(key & ~REGION_UPLOAD_KEY);
+			else
+				scheduledChunks.emplace_back(key);
+		}
+
+		// Regions are rebuilt here as well since they need the same page transitions
+		if (scheduledChunks.empty() && scheduledRegions.empty())
+			return;
+
+		ID3D12GraphicsCommandList* pUploadList = getUploadCommandList();
+
+		// The copy queue relies on the pages being implicitly promoted to COPY_DEST, which lets the previous frame keep
+		// reading other parts of them on the direct queue while the copies run
+		D3D12_RESOURCE_STATES pageState = m_uploadsOnCopyQueue ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_COPY_DEST;
+		if (!m_uploadsOnCopyQueue)
+		{
+			m_gpuVertexData.transitionPages(pUploadList, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+			m_gpuIndicesData.transitionPages(pUploadList, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+		}
+
+		for (ChunkID chunkID : scheduledChunks)
+		{
+			auto scheduledIterator = m_loadingChunkMesh.find(chunkID);
+			ThreadSafeChunkMesh& threadChunk = scheduledIterator->second;
+
+			// The region keeps drawing the old mesh of a merged pass until it's rebuilt
+			auto oldHandleIterator = m_dxChunkHandles.find(chunkID);
+			uint8_t oldMergedPasses = oldHandleIterator != m_dxChunkHandles.end() ? m_dxChunks.get(oldHandleIterator->second).mergedPasses : 0;
+
+			findAndDeleteDXChunk(chunkID);
+
+			SlotHandle dxChunkHandle = m_dxChunks.insert(DXChunk());
+			m_dxChunkHandles[chunkID] = dxChunkHandle;
+
+			DXChunk& dxChunk = m_dxChunks.get(dxChunkHandle);
+			dxChunk.chunkID = chunkID;
+			dxChunk.meshingInfo = threadChunk.meshData.meshingInfo;
+
+			// One block of margin since water is offset in the shader
+			dxChunk.meshMinY = FLT_MAX;
+			dxChunk.meshMaxY = -FLT_MAX;
+			expandMeshHeightRange(threadChunk.meshData.blockMesh, dxChunk.meshMinY, dxChunk.meshMaxY);
+			expandMeshHeightRange(threadChunk.meshData.waterMesh, dxChunk.meshMinY, dxChunk.meshMaxY);
+			dxChunk.meshMinY = dxChunk.meshMinY == FLT_MAX ? 0.f : dxChunk.meshMinY - 1.f;
+			dxChunk.meshMaxY = dxChunk.meshMaxY == -FLT_MAX ? 0.f : dxChunk.meshMaxY + 1.f;
+			std::copy(std::begin(threadChunk.meshData.occluderHeights), std::end(threadChunk.meshData.occluderHeights), dxChunk.occluderHeights);
+			std::copy(std::begin(threadChunk.meshData.sectionConnectivity), std::end(threadChunk.meshData.sectionConnectivity), dxChunk.sectionConnectivity);
+
+			const MeshData* chunkMeshes[(uint32_t)VoxelPass::NUM_PASSES] = { &threadChunk.meshData.blockMesh, &threadChunk.meshData.waterMesh };
+			GPUMeshInfo* gpuMeshes[(uint32_t)VoxelPass::NUM_PASSES] = { &dxChunk.blockGPUMeshInfo, &dxChunk.waterGPUMeshInfo };
+			for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+			{
+				if (!m_regionBatching.enabled || !isBatchedMesh(*chunkMeshes[pass]))
+				{
+					writeMeshData(pUploadList, pageState, *gpuMeshes[pass], *chunkMeshes[pass]);
+					continue;
+				}
+
+				gpuMeshes[pass]->indicesCount = 0;
+				dxChunk.mergedPasses |= oldMergedPasses & (1 << pass);
+			}
+
+			addChunkToDrawRegion(dxChunk, threadChunk.meshData);
+
+			m_loadingChunkMesh.erase(scheduledIterator);
+		}
+
+		// After the chunks, so members uploaded this frame are merged right away
+		rebuildDrawRegions(pUploadList, pageState, scheduledRegions);
+
+		// Pages added while writing were created in pageState, so they're transitioned with the rest
+		if (!m_uploadsOnCopyQueue)
+		{
+			m_gpuVertexData.transitionPages(pUploadList, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
+			m_gpuIndicesData.transitionPages(pUploadList, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
+		}
+
+		m_numUploadedBytes = m_uploadScheduler.getNumScheduledBytes();
+	}
+
+	void Renderer::writeMeshData(ID3D12GraphicsCommandList* pCommandList, D3D12_RESOURCE_STATES pageState, GPUMeshInfo& gpuMeshInfo, const MeshData& meshData)
+	{
+		if (!meshData.vertices.size())
+		{
+			gpuMeshInfo.indicesCount = 0;
+			return;
+		}
+
+		uint64_t vertexDataSize = meshData.vertices.size() * sizeof(Vertex);
+		uint64_t indexDataSize = meshData.indices.size() * sizeof(uint32_t);
+
+		gpuMeshInfo.vertexDataGVA = m_gpuVertexData.allocate(vertexDataSize, pageState, &gpuMeshInfo.vertexDataSlot);
+		gpuMeshInfo.indicesCount = (uint32_t)meshData.indices.size();
+		gpuMeshInfo.indicesView.BufferLocation = m_gpuIndicesData.allocate(indexDataSize, pageState, &gpuMeshInfo.indicesDataSlot);
+		gpuMeshInfo.indicesView.Format = DXGI_FORMAT_R32_UINT;
+		gpuMeshInfo.indicesView.SizeInBytes = (uint32_t)indexDataSize;
+
+		updateDefaultHeapResource(m_gpuVertexData.getDXResource(gpuMeshInfo.vertexDataSlot.pageIdx), gpuMeshInfo.vertexDataSlot.offset, meshData.vertices.data(), vertexDataSize, pCommandList);
+		updateDefaultHeapResource(m_gpuIndicesData.getDXResource(gpuMeshInfo.indicesDataSlot.pageIdx), gpuMeshInfo.indicesDataSlot.offset, meshData.indices.data(), indexDataSize, pCommandList);
+	}
+
+	void Renderer::defragmentMeshArenas()
+	{
+		m_numDefragmentedBytes = 0;
+
+		// Moving data needs explicit transitions, which would clash with the previous frame still reading the pages
+		// if they were done on the copy queue
+		if (!m_defragData.enabled || m_uploadsOnCopyQueue || m_dxChunks.empty())
+			return;
+
+		// Nothing moved last cycle, only freeing something can give the allocations a better place
+		uint32_t numChunks = (uint32_t)m_dxChunks.size();
+		if (m_numIdleDefragChunks >= numChunks)
+			return;
+
+		bool defragVertices = m_gpuVertexData.getStatistics().fragmentation >= m_defragData.minFragmentation;
+		bool defragIndices = m_gpuIndicesData.getStatistics().fragmentation >= m_defragData.minFragmentation;
+		if (!defragVertices && !defragIndices)
+			return;
+
+		// Both arenas share the scratch buffer, so they share the budget as well
+		uint64_t byteBudget = glm::min((uint64_t)m_defragData.bytesPerFrame, DefragmentationData::SCRATCH_BUFFER_SIZE);
+		uint64_t scratchOffset = 0;
+
+		std::vector<ArenaRelocation> vertexRelocations;
+		std::vector<ArenaRelocation> indexRelocations;
+
+		// Continues where the last frame stopped so every chunk gets a chance to move
+		for (uint32_t i = 0; i < numChunks && scratchOffset < byteBudget && m_numIdleDefragChunks < numChunks; i++)
+		{
+			uint32_t chunkIdx = (m_defragCursor + 1) % numChunks;
+			DXChunk& dxChunk = m_dxChunks[chunkIdx];
+
+			// A chunk that might not fit the rest of the budget waits for the next frame, so it isn't counted as idle
+			uint64_t chunkSize = 0;
+			for (const GPUMeshInfo* pMeshInfo : { &dxChunk.blockGPUMeshInfo, &dxChunk.waterGPUMeshInfo })
+			{
+				if (defragVertices && pMeshInfo->vertexDataSlot.allocationHandle != INVALID_UINT32)
+					chunkSize += pMeshInfo->vertexDataSlot.size;
+
+				if (defragIndices && pMeshInfo->indicesDataSlot.allocationHandle != INVALID_UINT32)
+					chunkSize += pMeshInfo->indicesDataSlot.size;
+			}
+
+			if (scratchOffset && scratchOffset + chunkSize > byteBudget)
+				break;
+
+			m_defragCursor = chunkIdx;
+			uint64_t chunkScratchOffset = scratchOffset;
+
+			for (GPUMeshInfo* pMeshInfo : { &dxChunk.blockGPUMeshInfo, &dxChunk.waterGPUMeshInfo })
+			{
+				if (defragVertices && relocateAllocation(m_gpuVertexData, pMeshInfo->vertexDataSlot, vertexRelocations, scratchOffset, byteBudget))
+					pMeshInfo->vertexDataGVA = m_gpuVertexData.getGVA(pMeshInfo->vertexDataSlot);
+
+				if (defragIndices && relocateAllocation(m_gpuIndicesData, pMeshInfo->indicesDataSlot, indexRelocations, scratchOffset, byteBudget))
+					pMeshInfo->indicesView.BufferLocation = m_gpuIndicesData.getGVA(pMeshInfo->indicesDataSlot);
+			}
+
+			m_numIdleDefragChunks = scratchOffset == chunkScratchOffset ? m_numIdleDefragChunks + 1 : 0;
+		}
+
+		if (vertexRelocations.empty() && indexRelocations.empty())
+			return;
+
+		// A buffer can't be both a copy source & destination, so the data goes through the scratch buffer
+		ID3D12GraphicsCommandList* pCommandList = getCurrentFrameResorces().pCommandList;
+
+		transitionResource(pCommandList, m_pDefragScratchBuffer, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+		copyArenaRelocations(pCommandList, m_gpuVertexData, vertexRelocations, true);
+		copyArenaRelocations(pCommandList, m_gpuIndicesData, indexRelocations, true);
+		transitionResource(pCommandList, m_pDefragScratchBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+		copyArenaRelocations(pCommandList, m_gpuVertexData, vertexRelocations, false);
+		copyArenaRelocations(pCommandList, m_gpuIndicesData, indexRelocations, false);
+		transitionResource(pCommandList, m_pDefragScratchBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COMMON);
+
+		m_numDefragmentedBytes = scratchOffset;
+	}
+
+	bool Renderer::relocateAllocation(ResourceArena& arena, ResourceSlot& slot, std::vector<ArenaRelocation>& relocations, uint64_t& scratchOffset, uint64_t byteBudget)
+	{
+		if (slot.allocationHandle == INVALID_UINT32 || scratchOffset + slot.size > byteBudget)
+			return false;
+
+		// Only moving allocations towards the first page & the start of each page, so the free space gathers at the end
+		ResourceSlot freeSlot;
+		if (!arena.findAllocationSlot(slot.size, &freeSlot))
+			return false;
+
+		if (freeSlot.pageIdx > slot.pageIdx || (freeSlot.pageIdx == slot.pageIdx && freeSlot.offset >= slot.offset))
+			return false;
+
+		ResourceSlot newSlot;
+		arena.claimAllocationSlot(slot.size, freeSlot, &newSlot);
+
+		ArenaRelocation& relocation = relocations.emplace_back();
+		relocation.srcPageIdx = slot.pageIdx;
+		relocation.srcOffset = slot.offset;
+		relocation.dstPageIdx = newSlot.pageIdx;
+		relocation.dstOffset = newSlot.offset;
+		relocation.scratchOffset = scratchOffset;
+		relocation.size = slot.size;
+
+		// Frames in flight might still read from the old location
+		addToFrameGarbage(arena, slot);
+
+		slot = newSlot;
+		scratchOffset += relocation.size;
+
+		return true;
+	}
+
+	void Renderer::copyArenaRelocations(ID3D12GraphicsCommandList* pCommandList, ResourceArena& arena, const std::vector<ArenaRelocation>& relocations, bool toScratchBuffer)
+	{
+		if (relocations.empty())
+			return;
+
+		D3D12_RESOURCE_STATES copyState = toScratchBuffer ? D3D12_RESOURCE_STATE_COPY_SOURCE : D3D12_RESOURCE_STATE_COPY_DEST;
+
+		arena.transitionPages(pCommandList, D3D12_RESOURCE_STATE_COMMON, copyState);
+
+		for (const ArenaRelocation& relocation : relocations)
+		{
+			if (toScratchBuffer)
+				pCommandList->CopyBufferRegion(m_pDefragScratchBuffer, relocation.scratchOffset, arena.getDXResource(relocation.srcPageIdx), relocation.srcOffset, relocation.size);
+			else
+				pCommandList->CopyBufferRegion(arena.getDXResource(relocation.dstPageIdx), relocation.dstOffset, m_pDefragScratchBuffer, relocation.scratchOffset, relocation.size);
+		}
+
+		arena.transitionPages(pCommandList, copyState, D3D12_RESOURCE_STATE_COMMON);
+	}
+
+	void Renderer::findAndDeleteDXChunk(ChunkID chunkID)
+	{
+		auto handleIterator = m_dxChunkHandles.find(chunkID);
+		if (handleIterator == m_dxChunkHandles.end())
+			return;
+
+		const DXChunk& dxChunk = m_dxChunks.get(handleIterator->second);
+
+		removeMeshAllocation(m_gpuVertexData, dxChunk.blockGPUMeshInfo.vertexDataSlot);
+		removeMeshAllocation(m_gpuIndicesData, dxChunk.blockGPUMeshInfo.indicesDataSlot);
+
+		removeMeshAllocation(m_gpuVertexData, dxChunk.waterGPUMeshInfo.vertexDataSlot);
+		removeMeshAllocation(m_gpuIndicesData, dxChunk.waterGPUMeshInfo.indicesDataSlot);
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0), glm::vec2(1, 0), textureId, 5));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 0, 0), glm::vec2(1, 1), textureId, 5));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 0, 0), glm::vec2(0, 1), textureId, 5));
-		}
+		removeChunkFromDrawRegion(dxChunk);
+
+		m_dxChunks.remove(handleIterator->second);
+		m_dxChunkHandles.erase(handleIterator);
 	}
 
-	void Renderer::addWaterMeshData(const World* pWorld, const glm::ivec3& chunkBlockCoord, const glm::ivec3& worldBlockCoord, MeshData& outMeshData)
+	void Renderer::addChunkToDrawRegion(DXChunk& dxChunk, ChunkMeshData& meshData)
 	{
-		// Top
-		if (pWorld->getBlockAtBlockCoord(worldBlockCoord + UP_DIR) != BlockType::WATER)
+		MeshData* chunkMeshes[(uint32_t)VoxelPass::NUM_PASSES] = { &meshData.blockMesh, &meshData.waterMesh };
+
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
 		{
-			uint32_t textureId = getTextureID(BlockType::WATER, BlockSide::SIDE);
+			MeshData& mesh = *chunkMeshes[pass];
+			if (!isBatchedMesh(mesh))
+				continue;
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0), glm::vec2(1, 0), textureId));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 1), glm::vec2(1, 1), textureId));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1), glm::vec2(0, 1), textureId));
+			// The chunk's own GPU mesh is already written if it needs one, so the CPU copy can be moved
+			uint64_t regionID = getDrawRegionID(dxChunk.chunkID);
+			m_drawRegions[regionID].memberMeshes[pass][dxChunk.chunkID] = std::move(mesh);
+			m_dirtyDrawRegions.insert(regionID);
 
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 1), glm::vec2(0, 1), textureId));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(1, 1, 0), glm::vec2(0, 0), textureId));
-			addVertex(outMeshData.indices, outMeshData.vertices, Vertex(chunkBlockCoord + glm::ivec3(0, 1, 0), glm::vec2(1, 0), textureId));
+			dxChunk.batchedPasses |= 1 << pass;
 		}
 	}
 
-	void Renderer::updateChunks(const World& world)
+	void Renderer::removeChunkFromDrawRegion(const DXChunk& dxChunk)
 	{
-		for (ChunkID chunkID : world.getRemovedChunks())
+		if (!dxChunk.batchedPasses)
+			return;
+
+		uint64_t regionID = getDrawRegionID(dxChunk.chunkID);
+		auto regionIterator = m_drawRegions.find(regionID);
+		if (regionIterator == m_drawRegions.end())
+			return;
+
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
 		{
-			findAndDeleteDXChunk(chunkID);
+			if (dxChunk.batchedPasses & (1 << pass))
+				regionIterator->second.memberMeshes[pass].erase(dxChunk.chunkID);
 		}
 
-		std::unique_lock lock(s_loadingChunksMutis);
-		processAddedChunks(world);
-		processLoadingChunkMeshes(world);
+		m_dirtyDrawRegions.insert(regionID);
 	}
 
-	void Renderer::processAddedChunks(const World& world)
+	uint64_t Renderer::getDrawRegionUploadSize(uint64_t regionID) const
 	{
-		// Not sure if should be static or not, prolly doesn't really matter :3
-		static const glm::ivec2 OFFSETS[] =
-		{
-			glm::ivec2( 0,  0),
-			glm::ivec2(-1,  0),
-			glm::ivec2( 1,  0),
-			glm::ivec2( 0, -1),
-			glm::ivec2( 0,  1),
-		};
+		auto regionIterator = m_drawRegions.find(regionID);
+		if (regionIterator == m_drawRegions.end())
+			return 0;
 
-		for (ChunkID chunkID : world.getAddedChunks())
+		// Merging copies every member, splitting only writes back the members that don't have their own allocation
+		uint64_t uploadSize = 0;
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
 		{
-			glm::ivec2 chunkCoord = chunkIDToChunkCoord(chunkID);
-			for (const glm::ivec2& offset : OFFSETS)
+			for (const auto& [chunkID, memberMesh] : regionIterator->second.memberMeshes[pass])
 			{
-				ChunkID adjacentChunkID = chunkCoordToChunkID(chunkCoord + offset);
-				if (!world.isChunkLoaded(adjacentChunkID))
-					continue;
-
-				uint32_t chunkGenID = INVALID_UINT32;
-				auto adjacentChunkIterator = m_loadingChunkMesh.find(adjacentChunkID);
+				const DXChunk& memberChunk = m_dxChunks.get(m_dxChunkHandles.at(chunkID));
+				const GPUMeshInfo& memberGPUMesh = pass == (uint32_t)VoxelPass::BLOCKS ? memberChunk.blockGPUMeshInfo : memberChunk.waterGPUMeshInfo;
 
-				if (adjacentChunkIterator != m_loadingChunkMesh.end())
-				{
-					ThreadSafeChunkMesh& chunkMesh = adjacentChunkIterator->second;
-					chunkGenID = ++chunkMesh.latestChunkGenID;
-					chunkMesh.meshGenerated.store(false);
-				}
-				else
-				{
-					ThreadSafeChunkMesh& chunkMesh = m_loadingChunkMesh[adjacentChunkID];
-					chunkMesh.latestChunkGenID = 0;
-					chunkGenID = 0;
-					chunkMesh.meshGenerated.store(false);
-				}	
-
-				const World* pWorld = &world;
-				m_threadPool.queueJob([=]()
-					{
-						ChunkMeshData outMeshData;
-						generateChunkMesh(pWorld, adjacentChunkID, chunkGenID, outMeshData);
-
-						std::shared_lock lock(s_loadingChunksMutis);
-						auto chunkIterator = m_loadingChunkMesh.find(adjacentChunkID);
-						if (chunkIterator == m_loadingChunkMesh.end())
-							return;
-
-						ThreadSafeChunkMesh& threadChunk = chunkIterator->second;
-						if (threadChunk.latestChunkGenID == chunkGenID)
-						{
-							threadChunk.meshData = std::move(outMeshData);
-							threadChunk.meshGenerated.store(true);
-						}
-					});
+				if (m_regionBatching.enabled || memberGPUMesh.vertexDataSlot.allocationHandle == INVALID_UINT32)
+					uploadSize += getMeshDataSize(memberMesh);
 			}
 		}
+
+		return uploadSize;
 	}
 
-	void Renderer::processLoadingChunkMeshes(const World& world)
+	void Renderer::rebuildDrawRegions(ID3D12GraphicsCommandList* pCommandList, D3D12_RESOURCE_STATES pageState, const std::vector<uint64_t>& regionIDs)
 	{
-		FrameResources& frame = getCurrentFrameResorces();
-
-		bool meshResourcesTranitioned = false;
-		auto chunkIterator = m_loadingChunkMesh.begin();
-		while (chunkIterator != m_loadingChunkMesh.end())
+		for (uint64_t regionID : regionIDs)
 		{
-			ThreadSafeChunkMesh& threadChunk = chunkIterator->second;
-			if (!threadChunk.meshGenerated.load())
-			{
-				++chunkIterator;
-				continue;
-			}
+			m_dirtyDrawRegions.erase(regionID);
 
-			ChunkID chunkID = chunkIterator->first;
-			if (!world.isChunkLoaded(chunkID))
-			{
-				chunkIterator = m_loadingChunkMesh.erase(chunkIterator);
+			auto regionIterator = m_drawRegions.find(regionID);
+			if (regionIterator == m_drawRegions.end())
 				continue;
-			}
-
-			if (!meshResourcesTranitioned)
-			{
-				meshResourcesTranitioned = true;
-				transitionResource(frame.pCommandList, m_gpuVertexData.getDXResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
-				transitionResource(frame.pCommandList, m_gpuIndicesData.getDXResource(), D3D12_RESOURCE_STATE_INDEX_BUFFER, D3D12_RESOURCE_STATE_COPY_DEST);
-			}
-
-			findAndDeleteDXChunk(chunkID);
 
-			DXChunk& dxChunk = m_dxChunks.emplace_back();
-			dxChunk.chunkID = chunkID;
-			writeMeshData(dxChunk.blockGPUMeshInfo, threadChunk.meshData.blockMesh);
-			writeMeshData(dxChunk.waterGPUMeshInfo, threadChunk.meshData.waterMesh);
+			DrawRegion& region = regionIterator->second;
+			bool regionEmpty = true;
 
-			chunkIterator = m_loadingChunkMesh.erase(chunkIterator);
-		}
+			for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+			{
+				// Merged meshes are rebuilt whole, they aren't defragmented since they don't live long enough to matter
+				GPUMeshInfo& mergedMesh = region.mergedMeshes[pass];
+				removeMeshAllocation(m_gpuVertexData, mergedMesh.vertexDataSlot);
+				removeMeshAllocation(m_gpuIndicesData, mergedMesh.indicesDataSlot);
+				mergedMesh = GPUMeshInfo();
 
-		if (meshResourcesTranitioned)
-		{
-			transitionResource(frame.pCommandList, m_gpuVertexData.getDXResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-			transitionResource(frame.pCommandList, m_gpuIndicesData.getDXResource(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+				std::vector<GPUDrawCallData>& mergedMembers = region.mergedMembers[pass];
+				mergedMembers.clear();
 
-			// Need to re-get the GVAs incase the arenas had to resize
-			D3D12_GPU_VIRTUAL_ADDRESS verticesGVA = m_gpuVertexData.getDXResource()->GetGPUVirtualAddress();
-			D3D12_GPU_VIRTUAL_ADDRESS indicesGVA = m_gpuIndicesData.getDXResource()->GetGPUVirtualAddress();
-			for (DXChunk& dxChunk : m_dxChunks)
-			{
-				dxChunk.blockGPUMeshInfo.vertexDataGVA = verticesGVA + dxChunk.blockGPUMeshInfo.vertexDataSlot.offset;
-				dxChunk.blockGPUMeshInfo.indicesView.BufferLocation = indicesGVA + dxChunk.blockGPUMeshInfo.indicesDataSlot.offset;
+				m_mergedMeshScratch.vertices.clear();
+				m_mergedMeshScratch.indices.clear();
 
-				dxChunk.waterGPUMeshInfo.vertexDataGVA = verticesGVA + dxChunk.waterGPUMeshInfo.vertexDataSlot.offset;
-				dxChunk.waterGPUMeshInfo.indicesView.BufferLocation = indicesGVA + dxChunk.waterGPUMeshInfo.indicesDataSlot.offset;
-			}
-		}
-	}
+				// Member indices are offset into the merged vertices, the shader finds the member's position through the vertex ranges.
+				// Only one copy of each mesh is kept on the GPU, so the members' own allocations are freed or written back
+				for (const auto& [chunkID, memberMesh] : region.memberMeshes[pass])
+				{
+					DXChunk& memberChunk = m_dxChunks.get(m_dxChunkHandles.at(chunkID));
+					GPUMeshInfo& memberGPUMesh = pass == (uint32_t)VoxelPass::BLOCKS ? memberChunk.blockGPUMeshInfo : memberChunk.waterGPUMeshInfo;
 
-	void Renderer::writeMeshData(GPUMeshInfo& gpuMeshInfo, const MeshData& meshData)
-	{
-		if (!meshData.vertices.size())
-		{
-			gpuMeshInfo.indicesCount = 0;
-			return;
-		}
+					if (!m_regionBatching.enabled)
+					{
+						if (memberGPUMesh.vertexDataSlot.allocationHandle == INVALID_UINT32)
+							writeMeshData(pCommandList, pageState, memberGPUMesh, memberMesh);
 
-		uint64_t vertexDataSize = meshData.vertices.size() * sizeof(Vertex);
-		uint64_t indexDataSize = meshData.indices.size() * sizeof(uint32_t);
+						memberChunk.mergedPasses &= ~(1 << pass);
+						continue;
+					}
 
-		gpuMeshInfo.vertexDataGVA = allocateIntoResourceArena(m_gpuVertexData, &gpuMeshInfo.vertexDataSlot, meshData.vertices.data(), vertexDataSize);
-		gpuMeshInfo.indicesCount = (uint32_t)meshData.indices.size();
-		gpuMeshInfo.indicesView.BufferLocation = allocateIntoResourceArena(m_gpuIndicesData, &gpuMeshInfo.indicesDataSlot, meshData.indices.data(), indexDataSize);
-		gpuMeshInfo.indicesView.Format = DXGI_FORMAT_R32_UINT;
-		gpuMeshInfo.indicesView.SizeInBytes = (uint32_t)indexDataSize;
+					removeMeshAllocation(m_gpuVertexData, memberGPUMesh.vertexDataSlot);
+					removeMeshAllocation(m_gpuIndicesData, memberGPUMesh.indicesDataSlot);
+					memberGPUMesh = GPUMeshInfo();
+					memberGPUMesh.indicesCount = 0;
+					memberChunk.mergedPasses |= 1 << pass;
 
-		updateDefaultHeapResource(m_gpuVertexData.getDXResource(), gpuMeshInfo.vertexDataSlot.offset, meshData.vertices.data(), vertexDataSize);
-		updateDefaultHeapResource(m_gpuIndicesData.getDXResource(), gpuMeshInfo.indicesDataSlot.offset, meshData.indices.data(), indexDataSize);
-	}
+					uint32_t vertexStart = (uint32_t)m_mergedMeshScratch.vertices.size();
+					m_mergedMeshScratch.vertices.insert(m_mergedMeshScratch.vertices.end(), memberMesh.vertices.begin(), memberMesh.vertices.end());
 
-	void Renderer::findAndDeleteDXChunk(ChunkID chunkID)
-	{
-		for (uint64_t i = 0; i < m_dxChunks.size(); i++)
-		{
-			if (m_dxChunks[i].chunkID != chunkID)
-				continue;
+					for (uint32_t index : memberMesh.indices)
+						m_mergedMeshScratch.indices.emplace_back(vertexStart + index);
 
-			m_gpuVertexData.removeAllocation(m_dxChunks[i].blockGPUMeshInfo.vertexDataSlot);
-			m_gpuIndicesData.removeAllocation(m_dxChunks[i].blockGPUMeshInfo.indicesDataSlot);
+					GPUDrawCallData& member = mergedMembers.emplace_back();
+					member.chunkWorldPos = chunkCoordToWorldCoord(chunkIDToChunkCoord(chunkID));
+					member.vertexEnd = (uint32_t)m_mergedMeshScratch.vertices.size();
+				}
 
-			m_gpuVertexData.removeAllocation(m_dxChunks[i].waterGPUMeshInfo.vertexDataSlot);
-			m_gpuIndicesData.removeAllocation(m_dxChunks[i].waterGPUMeshInfo.indicesDataSlot);
+				writeMeshData(pCommandList, pageState, mergedMesh, m_mergedMeshScratch);
+				regionEmpty &= region.memberMeshes[pass].empty();
+			}
 
-			m_dxChunks.erase(m_dxChunks.begin() + i);
-			break;
+			if (regionEmpty)
+				m_drawRegions.erase(regionIterator);
 		}
 	}
 
@@ -782,24 +2255,6 @@ namespace Okay
 		return gpuHandle;
 	}
 
-	D3D12_GPU_VIRTUAL_ADDRESS Renderer::allocateIntoResourceArena(ResourceArena& arena, ResourceSlot* pOutSlot, const void* pData, uint64_t dataSize)
-	{
-		FrameResources& frame = getCurrentFrameResorces();
-
-		uint32_t allocatinonHandle = INVALID_UINT32;
-		if (arena.findAllocationSlot(dataSize, &allocatinonHandle))
-			return arena.claimAllocationSlot(dataSize, allocatinonHandle, pOutSlot);
-
-		ID3D12Resource* pOldArenaResource = arena.getDXResource();
-		uint64_t oldSize = pOldArenaResource->GetDesc().Width;
-		arena.resize(frame.pCommandList, uint64_t((oldSize + dataSize) * 1.25f), D3D12_RESOURCE_STATE_COPY_DEST);
-
-		addToFrameGarbage(pOldArenaResource);
-
-		arena.findAllocationSlot(dataSize, &allocatinonHandle);
-		return arena.claimAllocationSlot(dataSize, allocatinonHandle, pOutSlot);
-	}
-
 	FrameResources& Renderer::getCurrentFrameResorces()
 	{
 		return m_frames[m_pSwapChain->GetCurrentBackBufferIndex()];
@@ -854,6 +2309,12 @@ namespace Okay
 		queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
 
 		DX_CHECK(m_pDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_pCommandQueue)));
+
+		queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+		DX_CHECK(m_pDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_pCopyQueue)));
+
+		DX_CHECK(m_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_pCopyFence)));
+		m_copyFenceValue = 0;
 	}
 
 	void Renderer::createSwapChain(IDXGIFactory* pFactory, const Window& window)
@@ -886,16 +2347,25 @@ namespace Okay
 		updateBackBufferTextures();
 	}
 
-	void Renderer::initializeFrameResources(FrameResources& frame, uint64_t ringBufferSize)
+	void Renderer::initializeFrameResources(FrameResources& frame)
 	{
 		DX_CHECK(m_pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&frame.pCommandAllocator)));
 		DX_CHECK(m_pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frame.pCommandAllocator, nullptr, IID_PPV_ARGS(&frame.pCommandList)));
 		DX_CHECK(frame.pCommandList->Close());
 
+		DX_CHECK(m_pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&frame.pCopyCommandAllocator)));
+		DX_CHECK(m_pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, frame.pCopyCommandAllocator, nullptr, IID_PPV_ARGS(&frame.pCopyCommandList)));
+		DX_CHECK(frame.pCopyCommandList->Close());
+
+		for (uint32_t i = 0; i < DrawRecordingData::NUM_THREADS - 1; i++)
+		{
+			DX_CHECK(m_pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&frame.pBundleAllocators[i])));
+			DX_CHECK(m_pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, frame.pBundleAllocators[i], nullptr, IID_PPV_ARGS(&frame.pBundles[i])));
+			DX_CHECK(frame.pBundles[i]->Close());
+		}
+
 		DX_CHECK(m_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&frame.pFence)));
 		frame.fenceValue = 0;
-
-		frame.ringBuffer.initialize(m_pDevice, ringBufferSize);
 	}
 
 	void Renderer::shutdowFrameResources(FrameResources& frame)
@@ -905,10 +2375,16 @@ namespace Okay
 		D3D12_RELEASE(frame.pFence);
 		D3D12_RELEASE(frame.pCommandAllocator);
 		D3D12_RELEASE(frame.pCommandList);
+		D3D12_RELEASE(frame.pCopyCommandAllocator);
+		D3D12_RELEASE(frame.pCopyCommandList);
+
+		for (uint32_t i = 0; i < DrawRecordingData::NUM_THREADS - 1; i++)
+		{
+			D3D12_RELEASE(frame.pBundleAllocators[i]);
+			D3D12_RELEASE(frame.pBundles[i]);
+		}
 		D3D12_RELEASE(frame.pBackBuffer);
 		D3D12_RELEASE(frame.pDepthTexture);
-
-		frame.ringBuffer.shutdown();
 	}
 
 	void Renderer::updateBackBufferTextures()
@@ -1005,56 +2481,44 @@ namespace Okay
 		return pResource;
 	}
 
-	ID3D12Resource* Renderer::createTextureSheet(FrameResources& frame)
+	ID3D12Resource* Renderer::createTextureSheet(FrameResources& frame, const TextureSheet& textureSheet)
 	{
-		std::unordered_map<BlockType, BlockTextures> textureNames;
-		findBlockTextures(textureNames);
-
-		std::unordered_map<std::string, uint32_t> textureNameToId;
-		uint32_t textureID = 0;
-		for (const auto& blockTextures : textureNames)
-		{
-			const BlockTextures& textures = blockTextures.second;
-			for (const std::string& texture : textures.textures)
-			{
-				if (textureNameToId.contains(texture))
-					continue;
-
-				textureNameToId[texture] = textureID++;
-			}
-		}
-
 		// Store texture IDs for use during rendering
-		for (const auto& blockTextures : textureNames)
+		for (uint32_t i = 1; i < NUM_BLOCKS; i++)
 		{
-			BlockType blockType = blockTextures.first;
-			const BlockTextures& textures = blockTextures.second;
-
-			for (uint32_t i = 0; i < 3; i++)
+			for (uint32_t side = 0; side < 3; side++)
 			{
-				m_textureIds[blockType].sideIDs[i] = textureNameToId[textures.textures[i]];
+				m_textureIds[BlockType(i)].sideIDs[side] = textureSheet.getTextureID(BlockType(i), BlockSide(side));
 			}
 		}
 
-		uint32_t numXTiles = (uint32_t)glm::ceil(glm::sqrt(textureNameToId.size()));
-		uint32_t numYTiles = (uint32_t)glm::ceil((float)textureNameToId.size() / (float)numXTiles);
-
-		uint32_t textureSheetWidth = numXTiles * TEXTURE_SHEET_TILE_SIZE + (numXTiles - 1) * TEXTURE_SHEET_PADDING;
-		uint32_t textureSheetHeight = numYTiles * TEXTURE_SHEET_TILE_SIZE + (numYTiles - 1) * TEXTURE_SHEET_PADDING;
-
 		D3D12_RESOURCE_DESC desc = {};
 		desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 		desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-		desc.Width = (uint64_t)textureSheetWidth;
-		desc.Height = (uint32_t)textureSheetHeight;
+		desc.Width = (uint64_t)textureSheet.getWidth();
+		desc.Height = textureSheet.getHeight();
 		desc.DepthOrArraySize = 1;
-		desc.MipLevels = 0; // 0 means max possible mipLevels (ID3D12Resource::GetDesc().MipLevels will be set to the real value)
-		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.MipLevels = (uint16_t)textureSheet.getNumMips();
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = 0;
 		desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
+		switch (textureSheet.getFormat())
+		{
+		case TextureSheetFormat::RGBA8:
+			desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			break;
+
+		case TextureSheetFormat::BC1:
+			desc.Format = DXGI_FORMAT_BC1_UNORM;
+			break;
+
+		case TextureSheetFormat::BC3:
+			desc.Format = DXGI_FORMAT_BC3_UNORM;
+			break;
+		}
+
 		D3D12_HEAP_PROPERTIES heapProperties = {};
 		heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
 		heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
@@ -1066,294 +2530,44 @@ namespace Okay
 		DX_CHECK(m_pDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&pTexture)));
 		pTexture->SetName(L"TextureSheet");
 
-		uploadTextureSheetData(pTexture, frame, textureNameToId);
-		transitionResource(frame.pCommandList, pTexture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
-
-		return pTexture;
-	}
-
-	void Renderer::uploadTextureSheetData(ID3D12Resource* pTarget, FrameResources& frame, const std::unordered_map<std::string, uint32_t>& textureIds)
-	{
-		D3D12_RESOURCE_DESC resourceDesc = pTarget->GetDesc();
-		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
-		uint64_t rowSizeInBytes = INVALID_UINT64;
+		// Every mip is already baked, they only need to be copied into the row pitch the GPU wants. For the BC formats the rows are block rows
+		uint32_t numMips = textureSheet.getNumMips();
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(numMips);
+		std::vector<uint32_t> numRows(numMips);
 		uint64_t totalSizeInBytes = INVALID_UINT64;
-		m_pDevice->GetCopyableFootprints(&resourceDesc, 0, 1, 0, &footprint, nullptr, &rowSizeInBytes, &totalSizeInBytes);
-
-		uint32_t padding = TEXTURE_SHEET_PADDING;
-		uint32_t tileSize = TEXTURE_SHEET_TILE_SIZE;
-
-		uint32_t numXTiles = (uint32_t)resourceDesc.Width / (TEXTURE_SHEET_TILE_SIZE + padding) + 1;
-		uint32_t numYTiles = resourceDesc.Height / (TEXTURE_SHEET_TILE_SIZE + padding) + 1;
-
-		uint8_t* pMappedBuffer = frame.ringBuffer.map();
-
-		// Copy source texture data into ringBuffer, taking padding into consideration
- 		for (const auto& textureInfo : textureIds)
-		{
-			const std::string& textureName = textureInfo.first;
-			uint32_t textureId = textureInfo.second;
-
-			uint32_t xSlot = textureId % numXTiles;
-			uint32_t ySlot = textureId / numXTiles;
-
-			uint8_t* pTarget = pMappedBuffer +
-				xSlot * (tileSize + padding) * 4 +
-				ySlot * (tileSize + padding) * footprint.Footprint.RowPitch;
-
-			int sourceWidth, sourceHeight;
-			std::string texturePath = (TEXTURES_PATH / (textureName + ".png")).string();
-			
-			uint8_t* pSource = stbi_load(texturePath.c_str(), &sourceWidth, &sourceHeight, nullptr, STBI_rgb_alpha);
-			OKAY_ASSERT(pSource);
-
-			// Average out RGB values of transparent pixel (so mipmaps generates better)
-			for (int i = 0; i < sourceWidth * sourceHeight; i++)
-			{
-				uint32_t* pPixel = (uint32_t*)pSource + i;
-				uint8_t A = ((uint8_t*)pPixel)[3];
-				if (A == UINT8_MAX)
-					continue;
-
-				glm::ivec2 pixelCoord = glm::ivec2(i % sourceWidth, i / sourceWidth);
-				glm::ivec3 averageRGB = glm::ivec3(0);
-				uint32_t numSamples = 0;
-
-				for (int y = -1; y <= 1; y++)
-				{
-					for (int x = -1; x <= 1; x++)
-					{
-						glm::ivec2 adjacentCoord = glm::ivec2(pixelCoord.x + x, pixelCoord.y + y);
-						if (adjacentCoord.x < 0 || adjacentCoord.x >= sourceWidth || adjacentCoord.y < 0 || adjacentCoord.y >= sourceHeight)
-							continue;
-
-						int adjacentIdx = adjacentCoord.x + adjacentCoord.y * sourceWidth;
-						uint32_t adjacentPixel = ((uint32_t*)pSource)[adjacentIdx];
-						uint8_t adjacentAlpha = ((uint8_t*)&adjacentPixel)[3];
-						if (adjacentAlpha == 0)
-							continue;
-
-						uint8_t r = ((uint8_t*)&adjacentPixel)[0];
-						uint8_t g = ((uint8_t*)&adjacentPixel)[1];
-						uint8_t b = ((uint8_t*)&adjacentPixel)[2];
-
-						averageRGB += glm::ivec3(r, g, b);
-						numSamples++;
-					}
-				}
+		m_pDevice->GetCopyableFootprints(&desc, 0, numMips, 0, footprints.data(), numRows.data(), nullptr, &totalSizeInBytes);
 
-				averageRGB = (glm::vec3)averageRGB / (float)numSamples;
+		uint64_t uploadBufferOffset = m_ringBuffer.reserve(totalSizeInBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		uint8_t* pMappedBuffer = m_ringBuffer.getMappedPtr(uploadBufferOffset);
 
-				uint8_t* pR = (uint8_t*)pPixel + 0;
-				uint8_t* pG = (uint8_t*)pPixel + 1;
-				uint8_t* pB = (uint8_t*)pPixel + 2;
-
-				*pR = averageRGB.r;
-				*pG = averageRGB.g;
-				*pB = averageRGB.b;
-			}
-
-			for (uint32_t i = 0; i < tileSize; i++)
-			{
-				memcpy(pTarget + i * footprint.Footprint.RowPitch, pSource + i * TEXTURE_SHEET_TILE_SIZE * 4, tileSize * 4ull);
-			}
-
-			stbi_image_free(pSource);
-		}
-
-
-		// Fill in column padding
-		for (uint32_t xTex = 0; xTex < numXTiles - 1; xTex++)
-		{
-			uint8_t* pTarget = pMappedBuffer + tileSize * 4 + (xTex * (tileSize + padding) * 4);
-			uint8_t* pSource = pTarget - 4;
-
-			for (uint32_t j = 0; j < padding / 2; j++)
-			{
-				for (uint32_t i = 0; i < resourceDesc.Height; i++)
-				{
-					memcpy(pTarget + i * footprint.Footprint.RowPitch + j * 4, pSource + i * footprint.Footprint.RowPitch, 4ull);
-				}
-			}
-
-			pTarget += (padding / 2) * 4;
-			pSource = pTarget + padding * 2;
-
-			for (uint32_t j = 0; j < padding / 2; j++)
-			{
-				for (uint32_t i = 0; i < resourceDesc.Height; i++)
-				{
-					memcpy(pTarget + i * footprint.Footprint.RowPitch + j * 4, pSource + i * footprint.Footprint.RowPitch, 4ull);
-				}
-			}
-		}
-
-		// Fill in row padding
-		for (uint32_t yTex = 0; yTex < numYTiles - 1; yTex++)
+		for (uint32_t mip = 0; mip < numMips; mip++)
 		{
-			uint8_t* pTarget = pMappedBuffer + tileSize * footprint.Footprint.RowPitch + (yTex * (tileSize + padding) * footprint.Footprint.RowPitch);
-			uint8_t* pSource = pTarget - footprint.Footprint.RowPitch;
-
-			for (uint32_t i = 0; i < padding / 2; i++)
-			{
-				memcpy(pTarget + i * footprint.Footprint.RowPitch, pSource, rowSizeInBytes);
-			}
+			const uint8_t* pSource = textureSheet.getMipData(mip);
+			uint64_t sourceRowSize = textureSheet.getMipRowSize(mip);
+			OKAY_ASSERT(numRows[mip] == textureSheet.getMipNumRows(mip));
 
-			pTarget += (padding / 2) * footprint.Footprint.RowPitch;
-			pSource = pTarget + (padding / 2) * footprint.Footprint.RowPitch;
-
-			for (uint32_t i = 0; i < padding / 2; i++)
+			for (uint32_t row = 0; row < numRows[mip]; row++)
 			{
-				memcpy(pTarget + i * footprint.Footprint.RowPitch, pSource, rowSizeInBytes);
+				memcpy(pMappedBuffer + footprints[mip].Offset + row * footprints[mip].Footprint.RowPitch, pSource + row * sourceRowSize, sourceRowSize);
 			}
-		}
-
-
-		D3D12_TEXTURE_COPY_LOCATION copySource = {};
-		copySource.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-		copySource.PlacedFootprint = footprint;
-		copySource.PlacedFootprint.Offset = frame.ringBuffer.getOffset();
-		copySource.pResource = frame.ringBuffer.getDXResource();
-
-		D3D12_TEXTURE_COPY_LOCATION copyDest = {};
-		copyDest.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-		copyDest.SubresourceIndex = 0;
-		copyDest.pResource = pTarget;
-
-		frame.pCommandList->CopyTextureRegion(&copyDest, 0, 0, 0, &copySource, nullptr);
-		frame.ringBuffer.unmap();
-	}
-
-	void Renderer::generateTextureSheetMipMaps(ID3D12Resource* pTextureSheet, uint32_t tileSize)
-	{
-		D3D12_RESOURCE_DESC textureDesc = pTextureSheet->GetDesc();
-
-		ID3D12RootSignature* pComputeSignature = nullptr;
-		ID3D12PipelineState* pComputePSO = nullptr;
-		{
-			D3D12_DESCRIPTOR_RANGE descRange[] =
-			{
-				createRangeSRV(0, 0, 1, 0),
-				createRangeUAV(0, 0, 1, 1),
-			};
-			D3D12_ROOT_PARAMETER rootParam = createRootParamTable(D3D12_SHADER_VISIBILITY_ALL, descRange, _countof(descRange));
-
-			D3D12_STATIC_SAMPLER_DESC samplerDesc = createDefaultStaticPointSamplerDesc();
-			samplerDesc.Filter = D3D12_FILTER_ANISOTROPIC;
-			samplerDesc.MaxAnisotropy = 16;
-			samplerDesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-			samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-			samplerDesc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-			samplerDesc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-
-			D3D12_ROOT_SIGNATURE_DESC rootDesc = {};
-			rootDesc.NumParameters = 1;
-			rootDesc.pParameters = &rootParam;
-			rootDesc.NumStaticSamplers = 1;
-			rootDesc.pStaticSamplers = &samplerDesc;
-			rootDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
-
-			pComputeSignature = createRootSignature(&rootDesc, L"TextureSheetMipMap");
-
-
-			ID3DBlob* pShaderBlob = nullptr;
-			D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineDesc = {};
-			pipelineDesc.pRootSignature = pComputeSignature;
-			pipelineDesc.CS = compileShader(SHADER_PATH / "TextureSheetMipMapCS.hlsl", "cs_5_1", &pShaderBlob);
-			pipelineDesc.NodeMask = 0;
-			pipelineDesc.CachedPSO.pCachedBlob = nullptr;
-			pipelineDesc.CachedPSO.CachedBlobSizeInBytes = 0;
-			pipelineDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-			DX_CHECK(m_pDevice->CreateComputePipelineState(&pipelineDesc, IID_PPV_ARGS(&pComputePSO)));
-			D3D12_RELEASE(pShaderBlob);
-		}
-
-
-		ID3D12DescriptorHeap* pDescriptorHeap = createDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, textureDesc.MipLevels * 2, true, L"MipMapTextureSheet");
-		ID3D12Resource* pUAVTexture = nullptr;
-		{
-			D3D12_HEAP_PROPERTIES heapProperties = {};
-			heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
-			heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-			heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-			heapProperties.CreationNodeMask = 0;
-			heapProperties.VisibleNodeMask = 0;
-			textureDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-			DX_CHECK(m_pDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &textureDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&pUAVTexture)));
-		}
-
-
-		ID3D12GraphicsCommandList* pComputeList = nullptr;
-		ID3D12CommandAllocator* pComputeAllocator = nullptr;
-		DX_CHECK(m_pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&pComputeAllocator)));
-		DX_CHECK(m_pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, pComputeAllocator, nullptr, IID_PPV_ARGS(&pComputeList)));
-
-		ID3D12Fence* pComputeFence = nullptr;
-		uint64_t fenceValue = 0;
-		DX_CHECK(m_pDevice->CreateFence(fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&pComputeFence)));
-
-
-		D3D12_UNORDERED_ACCESS_VIEW_DESC targetUAV = {};
-		D3D12_SHADER_RESOURCE_VIEW_DESC sourceSRV = {};
-		{
-			targetUAV.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-			targetUAV.Texture2D.PlaneSlice = 0;
-			targetUAV.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-
-			sourceSRV.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-			sourceSRV.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-			sourceSRV.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-			sourceSRV.Texture2D.MipLevels = 1;
-			sourceSRV.Texture2D.PlaneSlice = 0;
-			sourceSRV.Texture2D.ResourceMinLODClamp = 0;
-		}
-
-
-		transitionResource(pComputeList, pTextureSheet, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE);
-		pComputeList->CopyResource(pUAVTexture, pTextureSheet);
-
-		transitionResource(pComputeList, pUAVTexture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		transitionResource(pComputeList, pTextureSheet, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-
-		pComputeList->SetComputeRootSignature(pComputeSignature);
-		pComputeList->SetPipelineState(pComputePSO);
-		pComputeList->SetDescriptorHeaps(1, &pDescriptorHeap);
-
-		for (uint32_t i = 0; i < textureDesc.MipLevels - 1u; i++)
-		{
-			sourceSRV.Texture2D.MostDetailedMip = i;
-			targetUAV.Texture2D.MipSlice = i + 1;
 
-			D3D12_GPU_DESCRIPTOR_HANDLE descriptor0Handle = createSRVDescriptor(pDescriptorHeap, (i * 2), pUAVTexture, &sourceSRV);
-			createUAVDescriptor(pDescriptorHeap, (i * 2) + 1, pUAVTexture, &targetUAV); // Descriptor 1 Handle
+			D3D12_TEXTURE_COPY_LOCATION copySource = {};
+			copySource.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			copySource.PlacedFootprint = footprints[mip];
+			copySource.PlacedFootprint.Offset += uploadBufferOffset;
+			copySource.pResource = m_ringBuffer.getDXResource();
 
-			uint32_t mipWidth = glm::max(1u, (uint32_t)textureDesc.Width / (uint32_t)glm::pow(2, i));
-			uint32_t mipHeight = glm::max(1u, textureDesc.Height / (uint32_t)glm::pow(2, i));
-			uint32_t xGroups = (uint32_t)glm::ceil(mipWidth / 16.f);
-			uint32_t yGroups = (uint32_t)glm::ceil(mipHeight / 16.f);
+			D3D12_TEXTURE_COPY_LOCATION copyDest = {};
+			copyDest.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			copyDest.SubresourceIndex = mip;
+			copyDest.pResource = pTexture;
 
-			transitionResource(pComputeList, pUAVTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, i);
-			pComputeList->SetComputeRootDescriptorTable(0, descriptor0Handle);
-			pComputeList->Dispatch(xGroups, yGroups, 1);
+			frame.pCommandList->CopyTextureRegion(&copyDest, 0, 0, 0, &copySource, nullptr);
 		}
 
-		transitionResource(pComputeList, pUAVTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, textureDesc.MipLevels - 1);
-		transitionResource(pComputeList, pUAVTexture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
-
-		transitionResource(pComputeList, pTextureSheet, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
-		pComputeList->CopyResource(pTextureSheet, pUAVTexture);
-		transitionResource(pComputeList, pTextureSheet, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
-
-		flush(pComputeList, pComputeAllocator, pComputeFence, fenceValue);
+		transitionResource(frame.pCommandList, pTexture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
 
-		D3D12_RELEASE(pComputeAllocator);
-		D3D12_RELEASE(pComputeList);
-		D3D12_RELEASE(pComputeSignature);
-		D3D12_RELEASE(pComputePSO);
-		D3D12_RELEASE(pDescriptorHeap);
-		D3D12_RELEASE(pUAVTexture);
-		D3D12_RELEASE(pComputeFence);
+		return pTexture;
 	}
 
 	uint32_t Renderer::getTextureID(BlockType blockType, BlockSide blockSide)
@@ -1388,11 +2602,12 @@ namespace Okay
 	{
 		std::vector<D3D12_ROOT_PARAMETER> rootParams;
 		rootParams.emplace_back(createRootParamCBV(D3D12_SHADER_VISIBILITY_ALL, 0, 0));
-		rootParams.emplace_back(createRootParamCBV(D3D12_SHADER_VISIBILITY_VERTEX, 1, 0));
+		rootParams.emplace_back(createRootParamConstants(D3D12_SHADER_VISIBILITY_VERTEX, 1, 0, 2));
 		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_VERTEX, 0, 0));
 
 		D3D12_DESCRIPTOR_RANGE textureRange = createRangeSRV(1, 0, 1, 0);
 		rootParams.emplace_back(createRootParamTable(D3D12_SHADER_VISIBILITY_ALL, &textureRange, 1));
+		rootParams.emplace_back(createRootParamSRV(D3D12_SHADER_VISIBILITY_VERTEX, 2, 0));
 
 		D3D12_STATIC_SAMPLER_DESC pointSampler = createDefaultStaticPointSamplerDesc();
 		pointSampler.Filter = D3D12_FILTER_MIN_MAG_POINT_MIP_LINEAR;
@@ -1407,6 +2622,26 @@ namespace Okay
 
 		m_pVoxelRootSignature = createRootSignature(&rootDesc, L"VoxelRootSignature");
 
+		// Same layout as IndirectDrawArguments, changes the drawIdx, vertex data & index buffer per draw
+		D3D12_INDIRECT_ARGUMENT_DESC indirectArguments[4] = {};
+		indirectArguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+		indirectArguments[0].Constant.RootParameterIndex = 1;
+		indirectArguments[0].Constant.DestOffsetIn32BitValues = 0;
+		indirectArguments[0].Constant.Num32BitValuesToSet = 2;
+		indirectArguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW;
+		indirectArguments[1].ShaderResourceView.RootParameterIndex = 2;
+		indirectArguments[2].Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+		indirectArguments[3].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+		D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {};
+		commandSignatureDesc.ByteStride = sizeof(IndirectDrawArguments);
+		commandSignatureDesc.NumArgumentDescs = _countof(indirectArguments);
+		commandSignatureDesc.pArgumentDescs = indirectArguments;
+		commandSignatureDesc.NodeMask = 0;
+
+		DX_CHECK(m_pDevice->CreateCommandSignature(&commandSignatureDesc, m_pVoxelRootSignature, IID_PPV_ARGS(&m_pVoxelCommandSignature)));
+		m_pVoxelCommandSignature->SetName(L"VoxelCommandSignature");
+
 
 		ID3DBlob* pShaderBlobs[5] = {};
 		uint32_t shaderBlobIdx = 0;
@@ -1484,6 +2719,7 @@ namespace Okay
 			createRootParamCBV(D3D12_SHADER_VISIBILITY_VERTEX, 0, 0), // RenderData
 			createRootParamSRV(D3D12_SHADER_VISIBILITY_VERTEX, 0, 0),  // CloudData list
 			createRootParamCBV(D3D12_SHADER_VISIBILITY_VERTEX, 1, 0),  // CloudRenderData
+			createRootParamSRV(D3D12_SHADER_VISIBILITY_VERTEX, 1, 0),  // Cloud instances
 		};
 
 		D3D12_ROOT_SIGNATURE_DESC rootDesc = {};
@@ -1512,6 +2748,44 @@ namespace Okay
 
 		DX_CHECK(m_pDevice->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&m_pCloudsPSO)));
 
+		pipelineDesc.VS = compileShader(SHADER_PATH / "CloudsMeshVS.hlsl", "vs_5_1", &pShaderBlobs[shaderBlobIdx++]);
+		DX_CHECK(m_pDevice->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&m_pCloudsMeshPSO)));
+
+		for (ID3DBlob*& pBlob : pShaderBlobs)
+			D3D12_RELEASE(pBlob);
+	}
+
+	void Renderer::createFarTerrainRenderPass()
+	{
+		ID3DBlob* pShaderBlobs[5] = {};
+		uint32_t shaderBlobIdx = 0;
+
+		D3D12_ROOT_PARAMETER rootParams[] =
+		{
+			createRootParamCBV(D3D12_SHADER_VISIBILITY_ALL, 0, 0),          // FarTerrainRenderData
+			createRootParamConstants(D3D12_SHADER_VISIBILITY_VERTEX, 1, 0, 1), // Level index
+			createRootParamSRV(D3D12_SHADER_VISIBILITY_VERTEX, 0, 0),         // Heights
+			createRootParamSRV(D3D12_SHADER_VISIBILITY_VERTEX, 1, 0),         // Levels
+		};
+
+		D3D12_ROOT_SIGNATURE_DESC rootDesc = {};
+		rootDesc.NumParameters = _countof(rootParams);
+		rootDesc.pParameters = rootParams;
+		rootDesc.NumStaticSamplers = 0;
+		rootDesc.pStaticSamplers = nullptr;
+		rootDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+		m_pFarTerrainRootSignature = createRootSignature(&rootDesc, L"FarTerrainRootSignature");
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc = createDefaultGraphicsPipelineStateDesc();
+		pipelineDesc.pRootSignature = m_pFarTerrainRootSignature;
+		pipelineDesc.VS = compileShader(SHADER_PATH / "FarTerrainVS.hlsl", "vs_5_1", &pShaderBlobs[shaderBlobIdx++]);
+		pipelineDesc.PS = compileShader(SHADER_PATH / "FarTerrainPS.hlsl", "ps_5_1", &pShaderBlobs[shaderBlobIdx++]);
+		pipelineDesc.NumRenderTargets = 1;
+		pipelineDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+		pipelineDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+
+		DX_CHECK(m_pDevice->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&m_pFarTerrainPSO)));
+
 		for (ID3DBlob*& pBlob : pShaderBlobs)
 			D3D12_RELEASE(pBlob);
 	}
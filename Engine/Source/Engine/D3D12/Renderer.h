@@ -1,21 +1,45 @@
 #pragma once
 #include "RingBuffer.h"
 #include "ResourceArena.h"
+#include "VoxelDrawList.h"
 #include "Engine/World/Chunk.h"
+#include "Engine/World/FarTerrain.h"
+#include "Engine/World/CloudField.h"
+#include "Engine/World/TextureSheet.h"
 #include "Engine/Utilities/ThreadPool.h"
+#include "Engine/Utilities/UploadScheduler.h"
+#include "Engine/Utilities/Collision.h"
+#include "Engine/Utilities/OcclusionBuffer.h"
+#include "Engine/Utilities/SlotMap.h"
 
 #include <atomic>
+#include <unordered_set>
 
 namespace Okay
 {
-	constexpr uint32_t TEXTURE_SHEET_TILE_SIZE = 16;
-	constexpr uint32_t TEXTURE_SHEET_PADDING = 8;
+	// Chunks are split into cells of columns for occlusion culling, each cell stores how high it's solid all the way from the bottom
+	constexpr uint32_t OCCLUDER_CELL_WIDTH = 4;
+	constexpr uint32_t OCCLUDER_CELLS_PER_SIDE = CHUNK_WIDTH / OCCLUDER_CELL_WIDTH;
+
+	// Chunks are split vertically into sections for cave culling. A section's connectivity has bit (sideA * 6 + sideB) set
+	// if the two sides can see each other through non solid blocks, sides are in the same order as the vertex sideIdx
+	constexpr uint32_t SECTION_HEIGHT = 16;
+	constexpr uint32_t NUM_CHUNK_SECTIONS = WORLD_HEIGHT / SECTION_HEIGHT;
+	constexpr uint64_t SECTION_FULLY_CONNECTED = (1ull << 36) - 1;
 
 	class Window;
 	class World;
 	struct Chunk;
 	struct Camera;
 
+	struct DrawRecordingData
+	{
+		static const uint32_t NUM_THREADS = 4; // The render thread records the first partition, worker threads record the rest into bundles
+		static const uint32_t MIN_DRAWS_PER_THREAD = 256; // Fewer draws aren't worth handing to another thread
+
+		bool multithreaded = false;
+	};
+
 	struct FrameResources
 	{
 		uint64_t fenceValue = INVALID_UINT64;
@@ -24,14 +48,20 @@ namespace Okay
 		ID3D12CommandAllocator* pCommandAllocator = nullptr;
 		ID3D12GraphicsCommandList* pCommandList = nullptr;
 
+		// Only used when uploading on the copy queue
+		ID3D12CommandAllocator* pCopyCommandAllocator = nullptr;
+		ID3D12GraphicsCommandList* pCopyCommandList = nullptr;
+
+		// Voxel draws recorded by the worker threads, executed in order from pCommandList
+		ID3D12CommandAllocator* pBundleAllocators[DrawRecordingData::NUM_THREADS - 1] = {};
+		ID3D12GraphicsCommandList* pBundles[DrawRecordingData::NUM_THREADS - 1] = {};
+
 		ID3D12Resource* pBackBuffer = nullptr;
 		D3D12_CPU_DESCRIPTOR_HANDLE cpuBackBufferRTV = {};
 
 		ID3D12Resource* pDepthTexture = nullptr;
 		D3D12_CPU_DESCRIPTOR_HANDLE cpuDepthTextureDSV = {};
 
-		RingBuffer ringBuffer;
-
 		// do these need to be frame specific ? I don't think soooo :thonk:
 		D3D12_VIEWPORT viewport = {};
 		D3D12_RECT scissorRect = {};
@@ -47,6 +77,17 @@ namespace Okay
 		ResourceSlot indicesDataSlot;
 	};
 
+	struct ChunkMeshingInfo
+	{
+		uint32_t lodLevel = 0;
+
+		// LOD of the adjacent chunks per side (same order as the vertex sideIdx), only filled in for lower detail meshes.
+		// Their border faces are checked against the neighbour's cells at its own size, so the two levels never leave a crack between them
+		uint32_t adjacentLODLevels[6] = {};
+
+		bool operator==(const ChunkMeshingInfo& other) const = default;
+	};
+
 	struct DXChunk
 	{
 		ChunkID chunkID = INVALID_CHUNK_ID;
@@ -54,8 +95,81 @@ namespace Okay
 		GPUMeshInfo blockGPUMeshInfo;
 		GPUMeshInfo waterGPUMeshInfo;
 
-		// Set during rendering
-		D3D12_GPU_VIRTUAL_ADDRESS drawDataGVA = INVALID_UINT64;
+		ChunkMeshingInfo meshingInfo; // What the uploaded mesh was generated with
+
+		// Vertical range covered by the block & water meshes, keeps the culling box tight since most of the chunk height is air
+		float meshMinY = 0.f;
+		float meshMaxY = (float)WORLD_HEIGHT;
+
+		// Only filled in for LOD 0, lower detail meshes don't match the blocks closely enough to hide things
+		uint16_t occluderHeights[OCCLUDER_CELLS_PER_SIDE * OCCLUDER_CELLS_PER_SIDE] = {};
+
+		uint64_t sectionConnectivity[NUM_CHUNK_SECTIONS] = {};
+
+		uint8_t batchedPasses = 0; // Bit per VoxelPass, set if the mesh is small enough to be drawn through its DrawRegion
+		uint8_t mergedPasses = 0; // Bit per VoxelPass, set while the pass is drawn from its DrawRegion's merged mesh instead of its own allocation
+	};
+
+	struct RenderStatistics
+	{
+		uint32_t numVisibleChunks = 0;
+		uint32_t numCulledChunks = 0;
+
+		uint32_t numCaveCulledChunks = 0; // Included in numCulledChunks
+		uint32_t numOccludedChunks = 0; // Included in numCulledChunks
+		uint32_t numOccluders = 0;
+		uint32_t numRasterizedOccluders = 0;
+
+		uint32_t numDraws = 0;
+		uint32_t numDrawCalls = 0; // API calls, an ExecuteIndirect counts as one
+		uint32_t numDrawnRegions = 0;
+		uint32_t numRecordingThreads = 0;
+		float submitTimeMS = 0.f; // Building & recording the voxel draws
+		float sortTimeMS = 0.f; // Included in submitTimeMS
+	};
+
+	struct CaveCullingNode
+	{
+		ChunkID chunkID = INVALID_CHUNK_ID;
+		uint32_t dxChunkIdx = INVALID_UINT32; // INVALID_UINT32 for chunks without a mesh yet, they're treated as fully open
+		uint32_t sectionIdx = 0;
+		uint8_t entrySide = INVALID_UINT8; // INVALID_UINT8 for the camera's section, which can be left through any side
+		uint8_t travelledSides = 0; // Bit per side moved through so far, the flood never turns back towards the camera
+	};
+
+	struct OccluderBox
+	{
+		glm::vec3 boxMin = glm::vec3(0.f);
+		glm::vec3 boxMax = glm::vec3(0.f);
+		uint32_t trianglesEnd = 0; // Its triangles in the OcclusionBuffer end here & start where the previous occluder's end
+	};
+
+	struct OcclusionCullingData
+	{
+		static const uint32_t BUFFER_WIDTH = 256;
+		static const uint32_t BUFFER_HEIGHT = 128;
+		static const uint32_t NUM_BANDS = 4; // The render thread fills one band, worker threads the rest
+
+		bool enabled = true;
+
+		// Rasterizing stops halfway through so there's time left for testing, chunks not tested in time are drawn
+		float timeBudgetMS = 1.f;
+	};
+
+	struct RegionBatchingData
+	{
+		static const uint32_t REGION_CHUNK_WIDTH = 4;
+		static const uint32_t MAX_BATCHED_VERTICES = 2048; // Bigger meshes are always drawn on their own
+
+		bool enabled = false;
+	};
+
+	// GPU copy of one of the CloudField lists, kept up to date through its dirty ranges
+	struct CloudBuffer
+	{
+		ID3D12Resource* pElements = nullptr;
+		ID3D12Resource* pInstances = nullptr;
+		uint32_t numInstances = 0;
 	};
 
 	struct FrameGarbage
@@ -69,6 +183,46 @@ namespace Okay
 		IUnknown* pDxUnknown = nullptr; // Base class containing Release()
 	};
 
+	// Arena slots that can still be read by frames in flight
+	struct FrameSlotGarbage
+	{
+		FrameSlotGarbage(uint32_t frameIdx, ResourceArena* pArena, const ResourceSlot& slot)
+			:frameIdx(frameIdx), pArena(pArena), slot(slot)
+		{
+		}
+
+		uint32_t frameIdx = INVALID_UINT32;
+		ResourceArena* pArena = nullptr;
+		ResourceSlot slot;
+	};
+
+	struct ArenaRelocation
+	{
+		uint32_t srcPageIdx = INVALID_UINT32;
+		uint32_t dstPageIdx = INVALID_UINT32;
+		uint64_t srcOffset = 0;
+		uint64_t dstOffset = 0;
+		uint64_t scratchOffset = 0;
+		uint64_t size = 0;
+	};
+
+	struct DefragmentationData
+	{
+		static const uint64_t SCRATCH_BUFFER_SIZE = 4'000'000;
+
+		bool enabled = true;
+		uint32_t bytesPerFrame = 1'000'000; // Clamped to SCRATCH_BUFFER_SIZE
+
+		// Compaction only runs while the share of free memory outside each page's largest free block is above this
+		float minFragmentation = 0.25f;
+	};
+
+	struct UploadSchedulerData
+	{
+		uint32_t bytesPerFrame = 4'000'000; // 0 means no limit, always clamped to half the ring buffer
+		bool useCopyQueue = false;
+	};
+
 	struct Vertex
 	{
 		Vertex() = default;
@@ -107,6 +261,11 @@ namespace Okay
 			data |= value << (32 - (bitPos + numBits));
 		}
 
+		uint32_t readBits(uint32_t bitPos, uint32_t numBits) const
+		{
+			return (data >> (32 - (bitPos + numBits))) & ((1u << numBits) - 1);
+		}
+
 		bool operator==(Vertex other) const
 		{
 			return data == other.data;
@@ -125,6 +284,28 @@ namespace Okay
 	{
 		MeshData blockMesh;
 		MeshData waterMesh;
+		ChunkMeshingInfo meshingInfo;
+		uint16_t occluderHeights[OCCLUDER_CELLS_PER_SIDE * OCCLUDER_CELLS_PER_SIDE] = {};
+		uint64_t sectionConnectivity[NUM_CHUNK_SECTIONS] = {};
+	};
+
+	// REGION_CHUNK_WIDTH^2 chunks whose small meshes are merged into one mesh per pass, so they're drawn with one draw
+	struct DrawRegion
+	{
+		// CPU copies of the members' small meshes, kept even while batching is disabled so it can be switched on without remeshing.
+		// While batching is enabled they're only on the GPU in the merged mesh, switching it off writes them back to their chunks
+		std::unordered_map<ChunkID, MeshData> memberMeshes[(uint32_t)VoxelPass::NUM_PASSES];
+
+		GPUMeshInfo mergedMeshes[(uint32_t)VoxelPass::NUM_PASSES];
+		std::vector<GPUDrawCallData> mergedMembers[(uint32_t)VoxelPass::NUM_PASSES]; // In the order they were merged
+	};
+
+	struct LevelOfDetailData
+	{
+		static const uint32_t NUM_LEVELS = 4; // 1x, 2x, 4x & 8x block size
+
+		// Chunk distance from the camera where level i + 1 starts
+		uint32_t levelDistances[NUM_LEVELS - 1] = { 16, 32, 64 };
 	};
 
 	struct ThreadSafeChunkMesh
@@ -152,6 +333,8 @@ namespace Okay
 	{
 	public:
 		static const uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+		static const uint64_t MESH_ARENA_PAGE_SIZE = 4 * 1024 * 1024;
+		static const uint64_t UPLOAD_RING_BUFFER_SIZE = 64 * 1024 * 1024;
 
 	public:
 		Renderer() = default;
@@ -165,14 +348,37 @@ namespace Okay
 
 		void render(const World& world, const Camera& camera);
 
+		ResourceArenaStatistics getVertexArenaStatistics() const;
+		ResourceArenaStatistics getIndexArenaStatistics() const;
+		uint64_t getNumDefragmentedBytes() const;
+
+		uint32_t getNumPendingUploads() const;
+		uint64_t getNumPendingUploadBytes() const;
+		uint64_t getNumUploadedBytes() const;
+		const RingBuffer& getRingBuffer() const;
+		const RenderStatistics& getRenderStatistics() const;
+
+		LevelOfDetailData m_lodData;
+		DefragmentationData m_defragData;
+		UploadSchedulerData m_uploadData;
+		bool m_frustumCulling = true;
+		bool m_caveCulling = true;
+		OcclusionCullingData m_occlusionData;
+		bool m_indirectDrawing = true;
+		RegionBatchingData m_regionBatching;
+		DrawRecordingData m_drawRecordingData;
+		bool m_sortDraws = true;
+		bool m_meshedClouds = true;
+
 	private:
 		void updateBuffers(const World& world, const Camera& camera);
 		void preRender();
 		void renderWorld(const World& world);
 		void postRender();
 
-		void drawGPUMeshInfo(const DXChunk& dxChunk, const GPUMeshInfo& gpuMeshInfo);
+		void recordVoxelDraws(ID3D12GraphicsCommandList* pCommandList, uint32_t partitionIdx, const uint64_t* pArgumentOffsets);
 		void drawSkyBox();
+		void drawFarTerrain(const World& world);
 		void drawClouds(const World& world);
 
 		void signal(ID3D12Fence* pFence, uint64_t& fenceValue);
@@ -182,28 +388,56 @@ namespace Okay
 		void flush(ID3D12GraphicsCommandList* pCommandList, ID3D12CommandAllocator* pCommandAlloator, ID3D12Fence* pFence, uint64_t& fenceValue);
 
 		void addToFrameGarbage(IUnknown* pDxUnknown);
+		void addToFrameGarbage(ResourceArena& arena, const ResourceSlot& slot);
+		void removeMeshAllocation(ResourceArena& arena, const ResourceSlot& slot);
 		void clearFrameGarbage();
 
 		void transitionResource(ID3D12GraphicsCommandList* pCommandList, ID3D12Resource* pResource, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES newState, uint32_t subResource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
-		void updateDefaultHeapResource(ID3D12Resource* pTarget, uint64_t targetOffset, const void* pData, uint64_t dataSize);
+		void updateDefaultHeapResource(ID3D12Resource* pTarget, uint64_t targetOffset, const void* pData, uint64_t dataSize, ID3D12GraphicsCommandList* pCommandList = nullptr);
+
+		// The frame's direct command list, or the copy command list if uploads are done on the copy queue
+		ID3D12GraphicsCommandList* getUploadCommandList();
+		void submitUploads();
+
+		void updateFarTerrain(const World& world, const Camera& camera);
+		void updateClouds(const World& world);
+		void updateCloudBuffer(CloudBuffer& buffer, const void* pElements, uint32_t elementSize, uint32_t numElements, const std::vector<uint32_t>& instances,
+			const std::vector<CloudDirtyRange>& dirtyRanges, bool recreate, std::wstring_view name);
+		void cullChunks(const glm::mat4& viewProjMatrix, const glm::vec3& cameraPos);
+		void cullCaveChunks(const glm::vec3& cameraPos);
+		void cullOccludedChunks(const glm::mat4& viewProjMatrix, const glm::vec3& cameraPos);
 
 		void updateChunks(const World& world);
 		void processAddedChunks(const World& world);
 		void processLoadingChunkMeshes(const World& world);
+		void updateChunkLODs(const World& world);
 
-		void writeMeshData(GPUMeshInfo& gpuMeshInfo, const MeshData& meshData);
+		void queueChunkMesh(const World& world, ChunkID chunkID);
+		uint32_t findChunkLOD(ChunkID chunkID) const;
+		ChunkMeshingInfo findChunkMeshingInfo(ChunkID chunkID) const;
+		bool isChunkMeshLatest(ChunkID chunkID, uint32_t chunkGenID);
+
+		void writeMeshData(ID3D12GraphicsCommandList* pCommandList, D3D12_RESOURCE_STATES pageState, GPUMeshInfo& gpuMeshInfo, const MeshData& meshData);
+		void defragmentMeshArenas();
+		bool relocateAllocation(ResourceArena& arena, ResourceSlot& slot, std::vector<ArenaRelocation>& relocations, uint64_t& scratchOffset, uint64_t byteBudget);
+		void copyArenaRelocations(ID3D12GraphicsCommandList* pCommandList, ResourceArena& arena, const std::vector<ArenaRelocation>& relocations, bool toScratchBuffer);
 		void findAndDeleteDXChunk(ChunkID chunkID);
 
-		void generateChunkMesh(const World* pWorld, ChunkID chunkID, uint32_t chunkGenID, ChunkMeshData& outMeshData);
-		void addBlockMeshData(const World* pWorld, BlockType block, const glm::ivec3& chunkBlockCoord, const glm::ivec3& worldBlockCoord, MeshData& outMeshData);
-		void addWaterMeshData(const World* pWorld, const glm::ivec3& chunkBlockCoord, const glm::ivec3& worldBlockCoord, MeshData& outMeshData);
+		void addChunkToDrawRegion(DXChunk& dxChunk, ChunkMeshData& meshData);
+		void removeChunkFromDrawRegion(const DXChunk& dxChunk);
+		uint64_t getDrawRegionUploadSize(uint64_t regionID) const;
+		void rebuildDrawRegions(ID3D12GraphicsCommandList* pCommandList, D3D12_RESOURCE_STATES pageState, const std::vector<uint64_t>& regionIDs);
+
+		void generateChunkMesh(const World* pWorld, ChunkID chunkID, uint32_t chunkGenID, const ChunkMeshingInfo& meshingInfo, ChunkMeshData& outMeshData);
+		void generateChunkLODMesh(const World* pWorld, ChunkID chunkID, uint32_t chunkGenID, const ChunkMeshingInfo& meshingInfo, ChunkMeshData& outMeshData);
+		void addBlockMeshData(BlockType block, const glm::ivec3& chunkBlockCoord, int scale, uint8_t visibleSides, MeshData& outMeshData);
+		void addWaterMeshData(const glm::ivec3& chunkBlockCoord, int scale, MeshData& outMeshData);
 
 		D3D12_CPU_DESCRIPTOR_HANDLE createRTVDescriptor(ID3D12DescriptorHeap* pDescriptorHeap, uint32_t slotIdx, ID3D12Resource* pResource, const D3D12_RENDER_TARGET_VIEW_DESC* pDesc);
 		D3D12_CPU_DESCRIPTOR_HANDLE createDSVDescriptor(ID3D12DescriptorHeap* pDescriptorHeap, uint32_t slotIdx, ID3D12Resource* pResource, const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc);
 		D3D12_GPU_DESCRIPTOR_HANDLE createSRVDescriptor(ID3D12DescriptorHeap* pDescriptorHeap, uint32_t slotIdx, ID3D12Resource* pResource, const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc);
 		D3D12_GPU_DESCRIPTOR_HANDLE createUAVDescriptor(ID3D12DescriptorHeap* pDescriptorHeap, uint32_t slotIdx, ID3D12Resource* pResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc);
 
-		D3D12_GPU_VIRTUAL_ADDRESS allocateIntoResourceArena(ResourceArena& arena, ResourceSlot* pOutSlot, const void* pData, uint64_t dataSize);
 
 		FrameResources& getCurrentFrameResorces();
 
@@ -215,7 +449,7 @@ namespace Okay
 		void createCommandQueue();
 		void createSwapChain(IDXGIFactory* pFactory, const Window& window);
 		
-		void initializeFrameResources(FrameResources& frame, uint64_t ringBufferSize);
+		void initializeFrameResources(FrameResources& frame);
 		void shutdowFrameResources(FrameResources& frame);
 		void updateBackBufferTextures();
 
@@ -224,24 +458,33 @@ namespace Okay
 		ID3D12DescriptorHeap* createDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors, bool shaderVisible, std::wstring_view name);
 		ID3D12Resource* createCommittedBuffer(uint64_t size, D3D12_RESOURCE_STATES initialState, D3D12_HEAP_TYPE heapType, std::wstring_view name);
 
-		ID3D12Resource* createTextureSheet(FrameResources& frame);
-		void uploadTextureSheetData(ID3D12Resource* pTarget, FrameResources& frame, const std::unordered_map<std::string, uint32_t>& textureIds);
-		void generateTextureSheetMipMaps(ID3D12Resource* pTextureSheet, uint32_t tileSize);
+		ID3D12Resource* createTextureSheet(FrameResources& frame, const TextureSheet& textureSheet);
 		uint32_t getTextureID(BlockType blockType, BlockSide blockSide);
 
 		void createVoxelRenderPass();
 		void createSkyboxRenderPass();
 		void createCloudsRenderPass();
+		void createFarTerrainRenderPass();
 
 	private:
 		ThreadPool m_threadPool;
+		ThreadPool m_occlusionThreadPool; // Separate from meshing so culling never waits behind meshing jobs
+		ThreadPool m_drawRecordingThreadPool;
 
 		ID3D12Device* m_pDevice = nullptr;
 		ID3D12CommandQueue* m_pCommandQueue = nullptr;
+
+		ID3D12CommandQueue* m_pCopyQueue = nullptr;
+		ID3D12Fence* m_pCopyFence = nullptr;
+		uint64_t m_copyFenceValue = 0;
+		bool m_uploadsOnCopyQueue = false; // m_uploadData.useCopyQueue latched at the start of the frame
+		bool m_copyListRecorded = false;
 		IDXGISwapChain3* m_pSwapChain = nullptr;
 
 		FrameResources m_frames[MAX_FRAMES_IN_FLIGHT] = {};
+		RingBuffer m_ringBuffer;
 		std::vector<FrameGarbage> m_frameGarbage;
+		std::vector<FrameSlotGarbage> m_frameSlotGarbage;
 
 		ID3D12DescriptorHeap* m_pRTVDescHeap = nullptr;
 		ID3D12DescriptorHeap* m_pDSVDescHeap = nullptr;
@@ -250,21 +493,65 @@ namespace Okay
 		ID3D12RootSignature* m_pVoxelRootSignature = nullptr;
 		ID3D12PipelineState* m_pVoxelPSO = nullptr;
 		ID3D12PipelineState* m_pWaterPSO = nullptr;
+		ID3D12CommandSignature* m_pVoxelCommandSignature = nullptr;
+		VoxelDrawList m_voxelDrawList;
+		std::vector<VoxelDrawRange> m_voxelDrawRanges;
 
 		ID3D12RootSignature* m_pSkyBoxRootSignature = nullptr;
 		ID3D12PipelineState* m_pSkyBoxPSO = nullptr;
 
 		ID3D12RootSignature* m_pCloudsRootSignature = nullptr;
 		ID3D12PipelineState* m_pCloudsPSO = nullptr;
+		ID3D12PipelineState* m_pCloudsMeshPSO = nullptr;
+		CloudBuffer m_cloudPoints;
+		CloudBuffer m_cloudQuads;
+		uint32_t m_cloudLayoutVersion = INVALID_UINT32;
+		uint32_t m_cloudVersion = INVALID_UINT32;
+
+		ID3D12RootSignature* m_pFarTerrainRootSignature = nullptr;
+		ID3D12PipelineState* m_pFarTerrainPSO = nullptr;
+		ID3D12Resource* m_pFarTerrainHeights = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS m_farTerrainRenderDataGVA = INVALID_UINT64;
+		D3D12_GPU_VIRTUAL_ADDRESS m_farTerrainLevelsGVA = INVALID_UINT64;
+		uint32_t m_farTerrainLevelVersions[FarTerrain::NUM_LEVELS] = {};
 
 		D3D12_GPU_VIRTUAL_ADDRESS m_renderDataGVA = INVALID_UINT64;
 
-		std::vector<DXChunk> m_dxChunks;
+		SlotMap<DXChunk> m_dxChunks;
+		std::unordered_map<ChunkID, SlotHandle> m_dxChunkHandles;
+		std::vector<uint8_t> m_dxChunkVisibility; // Same order as m_dxChunks dense storage
+		Collision::AABBList m_dxChunkAABBs;
+		RenderStatistics m_renderStats;
+		std::vector<uint8_t> m_caveVisitedSections; // NUM_CHUNK_SECTIONS per DXChunk, followed by the ones of m_caveOpenChunks
+		std::unordered_map<ChunkID, uint32_t> m_caveOpenChunks; // Chunks without a mesh the flood went through, value is their offset in m_caveVisitedSections
+		std::vector<CaveCullingNode> m_caveCullingQueue;
+		OcclusionBuffer m_occlusionBuffer;
+		std::vector<OccluderBox> m_occluders; // Nearest first
+		std::vector<uint32_t> m_occlusionCandidates; // m_dxChunks dense indices that passed the earlier culling
+		std::unordered_map<uint64_t, DrawRegion> m_drawRegions;
+		std::unordered_set<uint64_t> m_dirtyDrawRegions; // Queued in m_uploadScheduler
+		bool m_drawRegionsMerged = false; // m_regionBatching.enabled as of the last upload, every region is rebuilt when it changes
+		std::unordered_set<uint64_t> m_visibleDrawRegions;
+		MeshData m_mergedMeshScratch;
 		std::unordered_map<ChunkID, ThreadSafeChunkMesh> m_loadingChunkMesh;
 
+		glm::vec3 m_cameraPos = glm::vec3(0.f);
+		glm::ivec2 m_currentCamChunkCoord = glm::ivec2(0, 0);
+		glm::ivec2 m_lodCamChunkCoord = glm::ivec2(INT_MAX);
+		LevelOfDetailData m_appliedLodData;
+
+		// Kept in COMMON outside of uploads, draws rely on implicit promotion so both queues can access them
 		ResourceArena m_gpuVertexData;
 		ResourceArena m_gpuIndicesData;
 
+		UploadScheduler m_uploadScheduler;
+		uint64_t m_numUploadedBytes = 0;
+
+		ID3D12Resource* m_pDefragScratchBuffer = nullptr;
+		uint32_t m_defragCursor = 0;
+		uint32_t m_numIdleDefragChunks = 0; // Visited in a row without moving anything, a full cycle of them pauses compaction until something is freed
+		uint64_t m_numDefragmentedBytes = 0;
+
 		ID3D12Resource* m_pTextureSheet = nullptr;
 		D3D12_GPU_DESCRIPTOR_HANDLE m_textureHandle = {};
 
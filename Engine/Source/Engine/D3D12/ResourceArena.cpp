@@ -2,167 +2,137 @@
 
 namespace Okay
 {
-	void ResourceArena::initialize(ID3D12Device* pDevice, uint64_t resourceSize, D3D12_RESOURCE_STATES initialState)
+	void ResourceArena::initialize(ID3D12Device* pDevice, uint64_t pageSize, D3D12_RESOURCE_STATES initialState)
 	{
 		m_pDevice = pDevice;
-		m_pDXResource = createResource(resourceSize, initialState);
-		m_slots.emplace_back(0, m_pDXResource->GetDesc().Width);
+		m_allocator.initialize(alignUint64(pageSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+
+		addPage(0, initialState);
 	}
 
 	void ResourceArena::shutdown()
 	{
-		D3D12_RELEASE(m_pDXResource);
-		m_slots.clear();
-		m_slots.shrink_to_fit();
+		for (ID3D12Resource*& pPage : m_pages)
+			D3D12_RELEASE(pPage);
+
+		m_pages.clear();
+		m_allocator.shutdown();
 	}
 
-	void ResourceArena::resize(ID3D12GraphicsCommandList* pCommandList, uint64_t newSize, D3D12_RESOURCE_STATES currentState)
+	void ResourceArena::clear()
 	{
-		uint64_t oldSize = m_pDXResource->GetDesc().Width;
-
-		ID3D12Resource* newResource = createResource(newSize, D3D12_RESOURCE_STATE_COPY_DEST);
-
-		D3D12_RESOURCE_BARRIER barriers[2] = {};
-		barriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-		barriers[0].Transition.pResource = m_pDXResource;
-		barriers[0].Transition.StateBefore = currentState;
-		barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
-		barriers[0].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-		barriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-		pCommandList->ResourceBarrier(1, barriers);
-		
-		pCommandList->CopyBufferRegion(newResource, 0, m_pDXResource, 0, oldSize);
-
-		uint32_t numBarriers = 1;
-		barriers[0].Transition.pResource = m_pDXResource;
-		barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_SOURCE;
-		barriers[0].Transition.StateAfter = currentState;
-		if (currentState != D3D12_RESOURCE_STATE_COPY_DEST)
+		m_allocator.clear();
+	}
+
+	D3D12_GPU_VIRTUAL_ADDRESS ResourceArena::allocate(uint64_t allocationSize, D3D12_RESOURCE_STATES currentState, ResourceSlot* pOutSlot)
+	{
+		ResourceSlot freeSlot;
+		if (!findAllocationSlot(allocationSize, &freeSlot))
 		{
-			barriers[1].Transition.pResource = newResource;
-			barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-			barriers[1].Transition.StateAfter = currentState;
-			numBarriers++;
+			// A new page is always big enough since oversized allocations get a page of their own
+			addPage(allocationSize, currentState);
+			findAllocationSlot(allocationSize, &freeSlot);
 		}
-		pCommandList->ResourceBarrier(numBarriers, barriers);
-
 
-		m_pDXResource = newResource;
-
-		// Handles potential slot merging
-		removeAllocation(ResourceSlot(oldSize, newSize - oldSize));
+		return claimAllocationSlot(allocationSize, freeSlot, pOutSlot);
 	}
 
-	void ResourceArena::clear()
+	bool ResourceArena::findAllocationSlot(uint64_t allocationSize, ResourceSlot* pOutFreeSlot) const
 	{
-		m_slots.clear();
-		m_slots.emplace_back(0, m_pDXResource->GetDesc().Width);
+		PagedAllocation freeBlock;
+		if (!m_allocator.findFreeBlock(allocationSize, &freeBlock))
+			return false;
+
+		pOutFreeSlot->offset = freeBlock.offset;
+		pOutFreeSlot->size = freeBlock.size;
+		pOutFreeSlot->allocationHandle = freeBlock.allocationHandle;
+		pOutFreeSlot->pageIdx = freeBlock.pageIdx;
+
+		return true;
 	}
 
-	D3D12_GPU_VIRTUAL_ADDRESS ResourceArena::claimAllocationSlot(uint64_t allocationSize, uint32_t allocationHandle, ResourceSlot* pOutSlot)
+	D3D12_GPU_VIRTUAL_ADDRESS ResourceArena::claimAllocationSlot(uint64_t allocationSize, const ResourceSlot& freeSlot, ResourceSlot* pOutSlot)
 	{
-		OKAY_ASSERT(allocationHandle < m_slots.size());
-		D3D12_GPU_VIRTUAL_ADDRESS allocationGVA = m_pDXResource->GetGPUVirtualAddress() + m_slots[allocationHandle].offset;
+		PagedAllocation freeBlock;
+		freeBlock.pageIdx = freeSlot.pageIdx;
+		freeBlock.allocationHandle = freeSlot.allocationHandle;
 
-		if (pOutSlot)
-		{
-			pOutSlot->offset = m_slots[allocationHandle].offset;
-			pOutSlot->size = allocationSize;
-		}
+		PagedAllocation allocation = m_allocator.claimFreeBlock(freeBlock, allocationSize);
 
-		if (allocationSize == m_slots[allocationHandle].size)
-		{
-			m_slots.erase(m_slots.begin() + allocationHandle);
-		}
-		else
-		{
-			m_slots[allocationHandle].offset += allocationSize;
-			m_slots[allocationHandle].size -= allocationSize;
-		}
+		ResourceSlot slot(allocation.offset, allocation.size);
+		slot.allocationHandle = allocation.allocationHandle;
+		slot.pageIdx = allocation.pageIdx;
+
+		if (pOutSlot)
+			*pOutSlot = slot;
 
-		return allocationGVA;
+		return getGVA(slot);
 	}
 
 	void ResourceArena::removeAllocation(const ResourceSlot& removedSlot)
 	{
-		if (removedSlot.offset == INVALID_UINT64 || removedSlot.size == INVALID_UINT64)
+		if (removedSlot.allocationHandle == INVALID_UINT32)
 			return;
 
-		// Search for slot we can merge with
-		uint64_t removedSlotEnd = removedSlot.offset + removedSlot.size;
-		for (uint64_t i = 0; i < m_slots.size(); i++)
+		PagedAllocation allocation;
+		allocation.pageIdx = removedSlot.pageIdx;
+		allocation.allocationHandle = removedSlot.allocationHandle;
+
+		m_allocator.free(allocation);
+	}
+
+	void ResourceArena::transitionPages(ID3D12GraphicsCommandList* pCommandList, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES newState)
+	{
+		std::vector<D3D12_RESOURCE_BARRIER> barriers(m_pages.size());
+		for (uint64_t i = 0; i < m_pages.size(); i++)
 		{
-			ResourceSlot& slot = m_slots[i];
-			if (removedSlotEnd == slot.offset)
-			{
-				slot.offset = removedSlot.offset;
-				slot.size += removedSlot.size;
-
-				// Check if we expanded the slot into another slot
-				for (uint64_t j = 0; j < m_slots.size(); j++)
-				{
-					ResourceSlot& otherSlot = m_slots[j];
-					if (slot.offset != otherSlot.offset + otherSlot.size)
-						continue;
-
-					slot.offset = otherSlot.offset;
-					slot.size += otherSlot.size;
-					m_slots.erase(m_slots.begin() + j);
-					break;
-				}
-
-				return;
-			}
-
-			if (slot.offset + slot.size == removedSlot.offset)
-			{
-				slot.size += removedSlot.size;
-				
-				// Check if we expanded the slot into another slot
-				uint64_t slotEnd = slot.offset + slot.size;
-				for (uint64_t j = 0; j < m_slots.size(); j++)
-				{
-					ResourceSlot& otherSlot = m_slots[j];
-					if (slotEnd != otherSlot.offset)
-						continue;
-
-					slot.size += otherSlot.size;
-					m_slots.erase(m_slots.begin() + j);
-					break;
-				}
-
-				return;
-			}
+			barriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+			barriers[i].Transition.pResource = m_pages[i];
+			barriers[i].Transition.StateBefore = beforeState;
+			barriers[i].Transition.StateAfter = newState;
+			barriers[i].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+			barriers[i].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
 		}
 
-		// Can't merge into any slots, add new
-		m_slots.emplace_back(removedSlot);
+		pCommandList->ResourceBarrier((uint32_t)barriers.size(), barriers.data());
 	}
 
-	ID3D12Resource* ResourceArena::getDXResource() const
+	ResourceArenaStatistics ResourceArena::getStatistics() const
 	{
-		return m_pDXResource;
+		ResourceArenaStatistics stats;
+		stats.size = m_allocator.getTotalSize();
+		stats.totalFreeSize = m_allocator.getTotalFreeSize();
+		stats.largestFreeSize = m_allocator.getLargestFreeBlockSize();
+		stats.numAllocations = m_allocator.getNumAllocations();
+		stats.numPages = m_allocator.getNumPages();
+		stats.fragmentation = m_allocator.getFragmentation();
+
+		return stats;
 	}
 
-	bool ResourceArena::findAllocationSlot(uint64_t allocationSize, uint32_t* pOutAllocationHandle)
+	D3D12_GPU_VIRTUAL_ADDRESS ResourceArena::getGVA(const ResourceSlot& slot) const
 	{
-		*pOutAllocationHandle = INVALID_UINT32;
-		uint64_t smallestSlotSize = UINT64_MAX;
+		return getDXResource(slot.pageIdx)->GetGPUVirtualAddress() + slot.offset;
+	}
 
-		// Find tightest fit
-		for (uint64_t i = 0; i < m_slots.size(); i++)
-		{
-			ResourceSlot& slot = m_slots[i];
-			if (allocationSize <= slot.size && slot.size < smallestSlotSize)
-			{
-				*pOutAllocationHandle = (uint32_t)i;
-				smallestSlotSize = slot.size;
-
-				// Can technically stop searching if slot.size == alocationSize but I feel like that would be a rare occurence :3
-			}
-		}
+	ID3D12Resource* ResourceArena::getDXResource(uint32_t pageIdx) const
+	{
+		OKAY_ASSERT(pageIdx < (uint32_t)m_pages.size());
+		return m_pages[pageIdx];
+	}
+
+	uint32_t ResourceArena::getNumPages() const
+	{
+		return (uint32_t)m_pages.size();
+	}
+
+	uint32_t ResourceArena::addPage(uint64_t minSize, D3D12_RESOURCE_STATES initialState)
+	{
+		ID3D12Resource* pPage = createResource(glm::max(m_allocator.getPageSize(), minSize), initialState);
+		m_pages.emplace_back(pPage);
 
-		return *pOutAllocationHandle != INVALID_UINT32;
+		// The resource width is aligned, so the page can use all of it
+		return m_allocator.addPage(pPage->GetDesc().Width);
 	}
 
 	ID3D12Resource* ResourceArena::createResource(uint64_t resourceSize, D3D12_RESOURCE_STATES initialState)
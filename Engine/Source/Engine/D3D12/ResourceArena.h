@@ -1,5 +1,8 @@
 #pragma once
 #include "OkayD3D12.h"
+#include "Engine/Utilities/PagedAllocator.h"
+
+#include <vector>
 
 namespace Okay
 {
@@ -10,37 +13,62 @@ namespace Okay
 			:offset(offset), size(size)
 		{ }
 
-		uint64_t offset = INVALID_UINT64;
+		uint64_t offset = INVALID_UINT64; // Relative to the start of the page
 		uint64_t size = INVALID_UINT64;
+		uint32_t allocationHandle = INVALID_UINT32;
+		uint32_t pageIdx = INVALID_UINT32;
+	};
+
+	struct ResourceArenaStatistics
+	{
+		uint64_t size = 0;
+		uint64_t totalFreeSize = 0;
+		uint64_t largestFreeSize = 0;
+		uint32_t numAllocations = 0;
+		uint32_t numPages = 0;
+
+		// 0 when every page has its free memory in one block, approaches 1 the more it's split up within the pages
+		float fragmentation = 0.f;
 	};
 
+	// Made up of fixed size buffer pages, growing only adds a page so existing allocations (and their GVAs) never change
 	class ResourceArena
 	{
 	public:
 		ResourceArena() = default;
 		~ResourceArena() = default;
 
-		void initialize(ID3D12Device* pDevice, uint64_t resourceSize, D3D12_RESOURCE_STATES initialState);
+		void initialize(ID3D12Device* pDevice, uint64_t pageSize, D3D12_RESOURCE_STATES initialState);
 		void shutdown();
 
-		// Assumes the release of the dxResource is handled by the caller after the function call
-		void resize(ID3D12GraphicsCommandList* pCommandList, uint64_t newSize, D3D12_RESOURCE_STATES currentState);
+		// Frees all allocations, the pages are kept
 		void clear();
 
-		bool findAllocationSlot(uint64_t allocationSize, uint32_t* pOutAllocationHandle);
-		D3D12_GPU_VIRTUAL_ADDRESS claimAllocationSlot(uint64_t allocationSize, uint32_t allocationHandle, ResourceSlot* pOutSlot);
+		// Adds a new page if needed, which is created in currentState as all pages are expected to share state
+		D3D12_GPU_VIRTUAL_ADDRESS allocate(uint64_t allocationSize, D3D12_RESOURCE_STATES currentState, ResourceSlot* pOutSlot);
+
+		// Only searches the existing pages, the found free slot is passed to claimAllocationSlot
+		bool findAllocationSlot(uint64_t allocationSize, ResourceSlot* pOutFreeSlot) const;
+		D3D12_GPU_VIRTUAL_ADDRESS claimAllocationSlot(uint64_t allocationSize, const ResourceSlot& freeSlot, ResourceSlot* pOutSlot);
 		void removeAllocation(const ResourceSlot& removedSlot);
 
-		ID3D12Resource* getDXResource() const;
+		void transitionPages(ID3D12GraphicsCommandList* pCommandList, D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES newState);
+
+		ResourceArenaStatistics getStatistics() const;
+
+		D3D12_GPU_VIRTUAL_ADDRESS getGVA(const ResourceSlot& slot) const;
+		ID3D12Resource* getDXResource(uint32_t pageIdx) const;
+		uint32_t getNumPages() const;
 
 	private:
 		ID3D12Resource* createResource(uint64_t resourceSize, D3D12_RESOURCE_STATES initialState);
+		uint32_t addPage(uint64_t minSize, D3D12_RESOURCE_STATES initialState);
 
 	private:
 		ID3D12Device* m_pDevice = nullptr;
-		ID3D12Resource* m_pDXResource = nullptr;
+		std::vector<ID3D12Resource*> m_pages;
 
-		std::vector<ResourceSlot> m_slots;
+		PagedAllocator m_allocator;
 
 	};
 }
@@ -6,104 +6,94 @@ namespace Okay
 	{
 		m_pDevice = pDevice;
 		createBuffer(alignUint64(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+
+		DX_CHECK(m_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_pFence)));
+		m_fenceValue = 0;
 	}
 	
 	void RingBuffer::shutdown()
 	{
 		if (m_pMappedPtr)
-			unmap();
+		{
+			D3D12_RANGE writeRange = { 0, 0 };
+			m_pRingBuffer->Unmap(0, &writeRange);
+			m_pMappedPtr = nullptr;
+		}
 
 		D3D12_RELEASE(m_pRingBuffer);
+		D3D12_RELEASE(m_pFence);
+		m_allocator.shutdown();
 	}
 
-	D3D12_GPU_VIRTUAL_ADDRESS RingBuffer::allocate(const void* pData, uint64_t byteWidth)
+	D3D12_GPU_VIRTUAL_ADDRESS RingBuffer::allocate(const void* pData, uint64_t byteWidth, uint32_t alignment)
 	{
-		OKAY_ASSERT(m_bufferOffset + byteWidth <= m_maxSize);
-
-		D3D12_GPU_VIRTUAL_ADDRESS allocationGpuAddress = getGPUAddress();
-		memcpy(getMappedPtr(), pData, byteWidth);
+		uint64_t offset = reserve(byteWidth, alignment);
+		memcpy(getMappedPtr(offset), pData, byteWidth);
 
-		m_bufferOffset += byteWidth;
-		alignOffset();
-
-		return allocationGpuAddress;
+		return getGPUAddress(offset);
 	}
 
-	uint8_t* RingBuffer::getMappedPtr()
+	uint64_t RingBuffer::reserve(uint64_t byteWidth, uint32_t alignment)
 	{
-		return m_pMappedPtr + m_bufferOffset;
-	}
+		// Zero sized allocations (like empty lists) still get a valid address
+		byteWidth = glm::max(byteWidth, (uint64_t)1);
 
-	void RingBuffer::offsetMappedPtr(uint64_t offset)
-	{
-		OKAY_ASSERT(m_bufferOffset + offset <= m_maxSize);
-		m_bufferOffset += offset;
+		m_allocator.releaseCompleted(m_pFence->GetCompletedValue());
+
+		uint64_t offset = m_allocator.allocate(byteWidth, alignment);
+		while (offset == INVALID_UINT64)
+		{
+			// If no older frame is left to wait for, this frame alone needs more than the whole buffer
+			uint64_t oldestFenceValue = m_allocator.getOldestFenceValue();
+			OKAY_ASSERT(oldestFenceValue != INVALID_UINT64);
+
+			HANDLE eventHandle = CreateEventEx(nullptr, 0, 0, EVENT_ALL_ACCESS);
+			DX_CHECK(m_pFence->SetEventOnCompletion(oldestFenceValue, eventHandle));
+			WaitForSingleObject(eventHandle, INFINITE);
+			CloseHandle(eventHandle);
+
+			m_numStalls++;
+			m_allocator.releaseCompleted(m_pFence->GetCompletedValue());
+			offset = m_allocator.allocate(byteWidth, alignment);
+		}
+
+		return offset;
 	}
 
-	uint64_t RingBuffer::getOffset() const
+	void RingBuffer::endFrame(ID3D12CommandQueue* pCommandQueue)
 	{
-		return m_bufferOffset;
+		DX_CHECK(pCommandQueue->Signal(m_pFence, ++m_fenceValue));
+		m_allocator.endFrame(m_fenceValue);
 	}
 
-	void RingBuffer::alignOffset(uint32_t alignment)
+	uint8_t* RingBuffer::getMappedPtr(uint64_t offset) const
 	{
-		m_bufferOffset = alignUint64(m_bufferOffset, alignment);
-
-		// maybe ok if offset is aligned to value >= maxSize as long as nothing else is allocated after?
-		OKAY_ASSERT(m_bufferOffset <= m_maxSize);
+		return m_pMappedPtr + offset;
 	}
 
-	D3D12_GPU_VIRTUAL_ADDRESS RingBuffer::getGPUAddress() const
+	D3D12_GPU_VIRTUAL_ADDRESS RingBuffer::getGPUAddress(uint64_t offset) const
 	{
-		return m_pRingBuffer->GetGPUVirtualAddress() + m_bufferOffset;
+		return m_pRingBuffer->GetGPUVirtualAddress() + offset;
 	}
 
 	ID3D12Resource* RingBuffer::getDXResource() const
 	{
 		return m_pRingBuffer;
 	}
-	
-	uint8_t* RingBuffer::map()
-	{
-		OKAY_ASSERT(!m_pMappedPtr);
 
-		D3D12_RANGE mapRange = { 0, 0 };
-		DX_CHECK(m_pRingBuffer->Map(0, &mapRange, (void**)&m_pMappedPtr));
-
-		return m_pMappedPtr;
-	}
-
-	void RingBuffer::unmap()
+	uint64_t RingBuffer::getSize() const
 	{
-		OKAY_ASSERT(m_pMappedPtr);
-
-		D3D12_RANGE writeRange = { 0, 0 };
-		m_pRingBuffer->Unmap(0, &writeRange);
-
-		m_pMappedPtr = nullptr;
-		m_bufferOffset = 0;
+		return m_allocator.getSize();
 	}
 
-	void RingBuffer::jumpToStart()
+	uint64_t RingBuffer::getUsedSize() const
 	{
-		m_bufferOffset = 0;
+		return m_allocator.getUsedSize();
 	}
 
-	void RingBuffer::resize(uint64_t size)
+	uint32_t RingBuffer::getNumStalls() const
 	{
-		bool wasMapped = m_pRingBuffer;
-		if (wasMapped)
-		{
-			unmap();
-		}
-
-		shutdown();
-		createBuffer(alignUint64(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
-
-		if (wasMapped)
-		{
-			map();
-		}
+		return m_numStalls;
 	}
 
 	void RingBuffer::createBuffer(uint64_t size)
@@ -134,7 +124,10 @@ namespace Okay
 		DX_CHECK(m_pDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
 			D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_pRingBuffer)));
 
-		m_bufferOffset = 0;
-		m_maxSize = size;
+		// Upload heaps can stay mapped for their whole lifetime
+		D3D12_RANGE mapRange = { 0, 0 };
+		DX_CHECK(m_pRingBuffer->Map(0, &mapRange, (void**)&m_pMappedPtr));
+
+		m_allocator.initialize(size);
 	}
 }
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "OkayD3D12.h"
+#include "Engine/Utilities/RingAllocator.h"
 
 namespace Okay
 {
+	// Upload heap buffer shared by all frames in flight, memory is reclaimed as the GPU finishes the frames that used it
 	class RingBuffer
 	{
 	public:
@@ -13,23 +15,23 @@ namespace Okay
 		void initialize(ID3D12Device* pDevice, uint64_t size);
 		void shutdown();
 
-		D3D12_GPU_VIRTUAL_ADDRESS allocate(const void* pData, uint64_t byteWidth);
+		// Waits for the GPU to finish older frames if there isn't enough space
+		D3D12_GPU_VIRTUAL_ADDRESS allocate(const void* pData, uint64_t byteWidth, uint32_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 
-		uint8_t* getMappedPtr();
-		D3D12_GPU_VIRTUAL_ADDRESS getGPUAddress() const;
+		// Same as allocate but returns the offset, the data is written through getMappedPtr
+		uint64_t reserve(uint64_t byteWidth, uint32_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 
-		uint8_t* map();
-		void unmap();
-
-		void offsetMappedPtr(uint64_t offset);
-		uint64_t getOffset() const;
-
-		void alignOffset(uint32_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+		// Signals the buffers fence on the queue, call after the command lists using the allocations are executed.
+		// Everything allocated since the last call is freed once the GPU reaches the signal
+		void endFrame(ID3D12CommandQueue* pCommandQueue);
 
+		uint8_t* getMappedPtr(uint64_t offset) const;
+		D3D12_GPU_VIRTUAL_ADDRESS getGPUAddress(uint64_t offset) const;
 		ID3D12Resource* getDXResource() const;
-		void jumpToStart();
 
-		void resize(uint64_t size);
+		uint64_t getSize() const;
+		uint64_t getUsedSize() const;
+		uint32_t getNumStalls() const; // Times the CPU had to wait for the GPU to free up space
 
 	private:
 		void createBuffer(uint64_t size);
@@ -39,8 +41,11 @@ namespace Okay
 		ID3D12Resource* m_pRingBuffer = nullptr;
 		uint8_t* m_pMappedPtr = nullptr;
 
-		uint64_t m_bufferOffset = INVALID_UINT64;
-		uint64_t m_maxSize = INVALID_UINT64;
+		ID3D12Fence* m_pFence = nullptr;
+		uint64_t m_fenceValue = 0;
+
+		RingAllocator m_allocator;
+		uint32_t m_numStalls = 0;
 
 	};
 }
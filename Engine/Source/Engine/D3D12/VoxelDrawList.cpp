@@ -0,0 +1,139 @@
+#include "VoxelDrawList.h"
+
+namespace Okay
+{
+	void VoxelDrawList::clear()
+	{
+		m_drawData.clear();
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+		{
+			m_draws[pass].clear();
+			m_drawDepths[pass].clear();
+		}
+	}
+
+	uint32_t VoxelDrawList::addDrawData(const glm::vec3& chunkWorldPos, uint32_t vertexEnd)
+	{
+		GPUDrawCallData& drawData = m_drawData.emplace_back();
+		drawData.chunkWorldPos = chunkWorldPos;
+		drawData.vertexEnd = vertexEnd;
+
+		return (uint32_t)m_drawData.size() - 1;
+	}
+
+	void VoxelDrawList::addDraw(VoxelPass pass, uint32_t drawIdx, D3D12_GPU_VIRTUAL_ADDRESS vertexDataGVA, const D3D12_INDEX_BUFFER_VIEW& indicesView, uint32_t indicesCount, float depth, uint32_t numDrawData)
+	{
+		OKAY_ASSERT(pass < VoxelPass::NUM_PASSES);
+		OKAY_ASSERT(numDrawData > 0 && drawIdx + numDrawData <= (uint32_t)m_drawData.size());
+
+		if (indicesCount == 0 || indicesCount == INVALID_UINT32)
+			return;
+
+		IndirectDrawArguments& draw = m_draws[(uint32_t)pass].emplace_back();
+		draw.drawIdx = drawIdx;
+		draw.numDrawData = numDrawData;
+		draw.vertexDataGVA = vertexDataGVA;
+		draw.indicesView = indicesView;
+		draw.drawArguments.IndexCountPerInstance = indicesCount;
+		draw.drawArguments.InstanceCount = 1;
+
+		m_drawDepths[(uint32_t)pass].emplace_back(depth);
+	}
+
+	void VoxelDrawList::sortDraws()
+	{
+		// One queue for every pass so they share the sort
+		m_renderQueue.clear();
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+		{
+			bool backToFront = pass == (uint32_t)VoxelPass::WATER;
+			for (uint32_t i = 0; i < (uint32_t)m_draws[pass].size(); i++)
+				m_renderQueue.push(RenderQueue::makeSortKey(pass, m_drawDepths[pass][i], backToFront), i);
+		}
+
+		m_renderQueue.sort();
+
+		// The pass is the top bits of the key, so each pass' items are next to each other
+		const std::vector<RenderQueueItem>& items = m_renderQueue.getItems();
+		uint32_t itemIdx = 0;
+
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+		{
+			m_sortedDraws.clear();
+			m_sortedDepths.clear();
+
+			for (uint32_t i = 0; i < (uint32_t)m_draws[pass].size(); i++)
+			{
+				uint32_t drawIdx = items[itemIdx++].itemIdx;
+				m_sortedDraws.emplace_back(m_draws[pass][drawIdx]);
+				m_sortedDepths.emplace_back(m_drawDepths[pass][drawIdx]);
+			}
+
+			m_draws[pass].swap(m_sortedDraws);
+			m_drawDepths[pass].swap(m_sortedDepths);
+		}
+	}
+
+	const std::vector<GPUDrawCallData>& VoxelDrawList::getDrawData() const
+	{
+		return m_drawData;
+	}
+
+	const std::vector<IndirectDrawArguments>& VoxelDrawList::getDraws(VoxelPass pass) const
+	{
+		OKAY_ASSERT(pass < VoxelPass::NUM_PASSES);
+		return m_draws[(uint32_t)pass];
+	}
+
+	uint32_t VoxelDrawList::getNumDraws() const
+	{
+		uint32_t numDraws = 0;
+		for (const std::vector<IndirectDrawArguments>& draws : m_draws)
+			numDraws += (uint32_t)draws.size();
+
+		return numDraws;
+	}
+
+	uint32_t VoxelDrawList::partitionDraws(uint32_t maxPartitions, uint32_t minDrawsPerPartition, std::vector<VoxelDrawRange>& outRanges) const
+	{
+		OKAY_ASSERT(maxPartitions > 0);
+
+		outRanges.clear();
+
+		uint32_t numDraws = getNumDraws();
+		if (!numDraws)
+			return 0;
+
+		uint32_t drawsPerPartition = glm::max((numDraws + maxPartitions - 1) / maxPartitions, glm::max(minDrawsPerPartition, 1u));
+
+		uint32_t partitionIdx = 0;
+		uint32_t numPartitionDraws = 0;
+
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+		{
+			uint32_t numPassDraws = (uint32_t)m_draws[pass].size();
+			uint32_t firstDraw = 0;
+
+			// A partition crossing into the next pass gets one range per pass
+			while (firstDraw < numPassDraws)
+			{
+				if (numPartitionDraws == drawsPerPartition)
+				{
+					partitionIdx++;
+					numPartitionDraws = 0;
+				}
+
+				VoxelDrawRange& range = outRanges.emplace_back();
+				range.partitionIdx = partitionIdx;
+				range.pass = (VoxelPass)pass;
+				range.firstDraw = firstDraw;
+				range.numDraws = glm::min(numPassDraws - firstDraw, drawsPerPartition - numPartitionDraws);
+
+				firstDraw += range.numDraws;
+				numPartitionDraws += range.numDraws;
+			}
+		}
+
+		return partitionIdx + 1;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "OkayD3D12.h"
+#include "Engine/Utilities/RenderQueue.h"
+
+#include <vector>
+
+namespace Okay
+{
+	// Fetched in the voxel shaders with the drawIdx root constant, matches DrawCallData in GPUShared.hlsli.
+	// Merged draws use one per member chunk in a row, a vertex belongs to the first member whose vertexEnd is above its index
+	struct GPUDrawCallData
+	{
+		glm::vec3 chunkWorldPos = glm::vec3(0.f);
+		uint32_t vertexEnd = INVALID_UINT32;
+	};
+
+	// One record of the voxel command signature. The same records are used to issue the draws one by one when not drawing indirectly
+	struct IndirectDrawArguments
+	{
+		uint32_t drawIdx = 0; // Root constants (b1), 2 values keeps the SRV address 8 byte aligned
+		uint32_t numDrawData = 1;
+		D3D12_GPU_VIRTUAL_ADDRESS vertexDataGVA = 0; // Root SRV (t0)
+		D3D12_INDEX_BUFFER_VIEW indicesView = {};
+		D3D12_DRAW_INDEXED_ARGUMENTS drawArguments = {};
+	};
+
+	static_assert(sizeof(IndirectDrawArguments) == 56);
+
+	enum struct VoxelPass : uint32_t
+	{
+		BLOCKS = 0,
+		WATER,
+		NUM_PASSES,
+	};
+
+	// Contiguous draws of one pass, recorded by the thread owning partitionIdx
+	struct VoxelDrawRange
+	{
+		uint32_t partitionIdx = 0;
+		VoxelPass pass = VoxelPass::BLOCKS;
+		uint32_t firstDraw = 0;
+		uint32_t numDraws = 0;
+	};
+
+	// Collects the frame's voxel draws on the CPU, doesn't touch any D3D12 objects
+	class VoxelDrawList
+	{
+	public:
+		VoxelDrawList() = default;
+		~VoxelDrawList() = default;
+
+		void clear();
+
+		// Returns the drawIdx to use for the chunk's draws
+		uint32_t addDrawData(const glm::vec3& chunkWorldPos, uint32_t vertexEnd = INVALID_UINT32);
+
+		// Meshes without indices are skipped, numDrawData is the number of members for merged draws.
+		// depth is the distance from the camera, only used for sorting
+		void addDraw(VoxelPass pass, uint32_t drawIdx, D3D12_GPU_VIRTUAL_ADDRESS vertexDataGVA, const D3D12_INDEX_BUFFER_VIEW& indicesView, uint32_t indicesCount, float depth, uint32_t numDrawData = 1);
+
+		// Blocks front to back so early depth testing rejects hidden pixels, water back to front since it's blended
+		void sortDraws();
+
+		const std::vector<GPUDrawCallData>& getDrawData() const;
+		const std::vector<IndirectDrawArguments>& getDraws(VoxelPass pass) const;
+		uint32_t getNumDraws() const; // All passes
+
+		/*
+			Splits the draws of all passes into at most maxPartitions partitions, each recorded separately & executed in partitionIdx order.
+			Ranges come out in draw order and grouped by partition, so running the partitions in order draws exactly what recording
+			everything in one go would. Every partition but the last gets at least minDrawsPerPartition draws.
+			Returns the number of partitions used
+		*/
+		uint32_t partitionDraws(uint32_t maxPartitions, uint32_t minDrawsPerPartition, std::vector<VoxelDrawRange>& outRanges) const;
+
+	private:
+		std::vector<GPUDrawCallData> m_drawData;
+		std::vector<IndirectDrawArguments> m_draws[(uint32_t)VoxelPass::NUM_PASSES];
+		std::vector<float> m_drawDepths[(uint32_t)VoxelPass::NUM_PASSES];
+
+		RenderQueue m_renderQueue;
+		std::vector<IndirectDrawArguments> m_sortedDraws;
+		std::vector<float> m_sortedDepths;
+
+	};
+}
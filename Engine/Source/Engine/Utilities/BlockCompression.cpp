@@ -0,0 +1,507 @@
+#include "BlockCompression.h"
+
+#include <cfloat>
+#include <cstring>
+
+namespace Okay
+{
+	// Colours are handled as floats in 0-255 while searching, alpha is ignored by the colour part
+	struct ColourBlock
+	{
+		glm::vec3 colours[16] = {};
+		bool visible[16] = {};
+		uint32_t numVisible = 0;
+	};
+
+	static uint16_t packRGB565(const glm::vec3& colour)
+	{
+		glm::vec3 clamped = glm::clamp(colour, glm::vec3(0.f), glm::vec3(255.f));
+
+		uint16_t r = (uint16_t)glm::round(clamped.r * 31.f / 255.f);
+		uint16_t g = (uint16_t)glm::round(clamped.g * 63.f / 255.f);
+		uint16_t b = (uint16_t)glm::round(clamped.b * 31.f / 255.f);
+
+		return (r << 11) | (g << 5) | b;
+	}
+
+	// Bit replication, the same expansion the hardware does
+	static glm::vec3 unpackRGB565(uint16_t packed)
+	{
+		uint32_t r = (packed >> 11) & 31;
+		uint32_t g = (packed >> 5) & 63;
+		uint32_t b = packed & 31;
+
+		return glm::vec3((float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2)));
+	}
+
+	static void getColourPalette(uint16_t colour0, uint16_t colour1, bool fourColours, glm::vec3* pOutPalette)
+	{
+		pOutPalette[0] = unpackRGB565(colour0);
+		pOutPalette[1] = unpackRGB565(colour1);
+
+		if (fourColours)
+		{
+			pOutPalette[2] = (pOutPalette[0] * 2.f + pOutPalette[1]) / 3.f;
+			pOutPalette[3] = (pOutPalette[0] + pOutPalette[1] * 2.f) / 3.f;
+		}
+		else
+		{
+			pOutPalette[2] = (pOutPalette[0] + pOutPalette[1]) * 0.5f;
+			pOutPalette[3] = glm::vec3(0.f);
+		}
+	}
+
+	static float distanceSquared(const glm::vec3& a, const glm::vec3& b)
+	{
+		glm::vec3 diff = a - b;
+		return glm::dot(diff, diff);
+	}
+
+	// Picks the closest palette entry for every visible pixel, invisible pixels get index 3 in 3 colour mode.
+	// Returns the total squared error
+	static float findColourIndices(const ColourBlock& block, uint16_t colour0, uint16_t colour1, bool fourColours, uint32_t& outIndices)
+	{
+		glm::vec3 palette[4] = {};
+		getColourPalette(colour0, colour1, fourColours, palette);
+
+		uint32_t numEntries = fourColours ? 4 : 3;
+		float totalError = 0.f;
+		outIndices = 0;
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t bestIdx = 3;
+			if (block.visible[i] || fourColours)
+			{
+				float bestError = FLT_MAX;
+				for (uint32_t k = 0; k < numEntries; k++)
+				{
+					float error = distanceSquared(block.colours[i], palette[k]);
+					if (error < bestError)
+					{
+						bestError = error;
+						bestIdx = k;
+					}
+				}
+
+				totalError += block.visible[i] ? bestError : 0.f;
+			}
+
+			outIndices |= bestIdx << (i * 2);
+		}
+
+		return totalError;
+	}
+
+	static void findBoundingBoxEndpoints(const ColourBlock& block, glm::vec3& outA, glm::vec3& outB)
+	{
+		outA = glm::vec3(FLT_MAX);
+		outB = glm::vec3(-FLT_MAX);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (!block.visible[i])
+				continue;
+
+			outA = glm::min(outA, block.colours[i]);
+			outB = glm::max(outB, block.colours[i]);
+		}
+
+		// The box has 4 diagonals, channels moving against the one with the largest range have their ends swapped
+		glm::vec3 range = outB - outA;
+		uint32_t dominantChannel = range.x >= range.y && range.x >= range.z ? 0 : (range.y >= range.z ? 1 : 2);
+
+		glm::vec3 mean = glm::vec3(0.f);
+		for (uint32_t i = 0; i < 16; i++)
+			mean += block.visible[i] ? block.colours[i] : glm::vec3(0.f);
+
+		mean /= (float)block.numVisible;
+
+		glm::vec3 covariance = glm::vec3(0.f);
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (block.visible[i])
+				covariance += (block.colours[i] - mean) * (block.colours[i][dominantChannel] - mean[dominantChannel]);
+		}
+
+		for (uint32_t channel = 0; channel < 3; channel++)
+		{
+			if (covariance[channel] < 0.f)
+				std::swap(outA[channel], outB[channel]);
+		}
+
+		// Pulling the ends in a bit lowers the average error, the extremes are rarely the most common colours
+		glm::vec3 inset = (outB - outA) / 16.f;
+		outA += inset;
+		outB -= inset;
+	}
+
+	static void findPrincipalAxisEndpoints(const ColourBlock& block, glm::vec3& outMin, glm::vec3& outMax)
+	{
+		glm::vec3 mean = glm::vec3(0.f);
+		for (uint32_t i = 0; i < 16; i++)
+			mean += block.visible[i] ? block.colours[i] : glm::vec3(0.f);
+
+		mean /= (float)block.numVisible;
+
+		glm::mat3 covariance = glm::mat3(0.f);
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (!block.visible[i])
+				continue;
+
+			glm::vec3 offset = block.colours[i] - mean;
+			covariance += glm::outerProduct(offset, offset);
+		}
+
+		// Power iteration towards the largest eigenvector, starting from the diagonal works for nearly every block
+		glm::vec3 axis = glm::vec3(1.f);
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			glm::vec3 nextAxis = covariance * axis;
+			float length = glm::length(nextAxis);
+			if (length < 1e-6f)
+				break;
+
+			axis = nextAxis / length;
+		}
+
+		float minProjection = FLT_MAX;
+		float maxProjection = -FLT_MAX;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (!block.visible[i])
+				continue;
+
+			float projection = glm::dot(block.colours[i] - mean, axis);
+			minProjection = glm::min(minProjection, projection);
+			maxProjection = glm::max(maxProjection, projection);
+		}
+
+		outMin = mean + axis * minProjection;
+		outMax = mean + axis * maxProjection;
+	}
+
+	// Best endpoints for the current indices, solving the least squares system of colour = a * (1 - t) + b * t
+	static bool refineEndpoints(const ColourBlock& block, uint32_t indices, bool fourColours, glm::vec3& outA, glm::vec3& outB)
+	{
+		static const float FOUR_COLOUR_WEIGHTS[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+		static const float THREE_COLOUR_WEIGHTS[4] = { 0.f, 1.f, 0.5f, 0.f };
+		const float* pWeights = fourColours ? FOUR_COLOUR_WEIGHTS : THREE_COLOUR_WEIGHTS;
+
+		float aa = 0.f, ab = 0.f, bb = 0.f;
+		glm::vec3 ax = glm::vec3(0.f), bx = glm::vec3(0.f);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			if (!block.visible[i])
+				continue;
+
+			float t = pWeights[(indices >> (i * 2)) & 3];
+			float s = 1.f - t;
+
+			aa += s * s;
+			ab += s * t;
+			bb += t * t;
+			ax += block.colours[i] * s;
+			bx += block.colours[i] * t;
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (glm::abs(determinant) < 1e-6f)
+			return false;
+
+		outA = (ax * bb - bx * ab) / determinant;
+		outB = (bx * aa - ax * ab) / determinant;
+		return true;
+	}
+
+	// colour0 > colour1 selects 4 colour mode, otherwise it's 3 colours + transparent
+	static void orderEndpoints(uint16_t& colour0, uint16_t& colour1, bool fourColours)
+	{
+		if (fourColours ? colour0 < colour1 : colour0 > colour1)
+			std::swap(colour0, colour1);
+	}
+
+	static float encodeColourEndpoints(const ColourBlock& block, const glm::vec3& a, const glm::vec3& b, bool fourColours, uint8_t* pOutBlock)
+	{
+		uint16_t colour0 = packRGB565(a);
+		uint16_t colour1 = packRGB565(b);
+		orderEndpoints(colour0, colour1, fourColours);
+
+		// Equal endpoints can't be ordered for 4 colour mode, but every entry is the same colour anyway
+		if (fourColours && colour0 == colour1)
+			fourColours = false;
+
+		uint32_t indices = 0;
+		float error = findColourIndices(block, colour0, colour1, fourColours, indices);
+
+		memcpy(pOutBlock + 0, &colour0, 2);
+		memcpy(pOutBlock + 2, &colour1, 2);
+		memcpy(pOutBlock + 4, &indices, 4);
+
+		return error;
+	}
+
+	static void compressColourBlock(const uint8_t* pPixels, BCQuality quality, bool allowTransparency, uint8_t* pOutBlock)
+	{
+		ColourBlock block;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			const uint8_t* pPixel = pPixels + i * 4;
+			block.colours[i] = glm::vec3(pPixel[0], pPixel[1], pPixel[2]);
+			block.visible[i] = !allowTransparency || pPixel[3] >= 128;
+			block.numVisible += block.visible[i];
+		}
+
+		if (!block.numVisible)
+		{
+			// 3 colour mode with every index on transparent
+			uint16_t colour0 = 0;
+			uint16_t colour1 = 0;
+			uint32_t indices = UINT32_MAX;
+
+			memcpy(pOutBlock + 0, &colour0, 2);
+			memcpy(pOutBlock + 2, &colour1, 2);
+			memcpy(pOutBlock + 4, &indices, 4);
+			return;
+		}
+
+		bool fourColours = block.numVisible == 16;
+
+		glm::vec3 endpointA, endpointB;
+		findBoundingBoxEndpoints(block, endpointA, endpointB);
+		float bestError = encodeColourEndpoints(block, endpointA, endpointB, fourColours, pOutBlock);
+
+		if (quality == BCQuality::FAST)
+			return;
+
+		uint8_t candidateBlock[8] = {};
+		findPrincipalAxisEndpoints(block, endpointA, endpointB);
+
+		for (uint32_t iteration = 0; iteration < 3; iteration++)
+		{
+			float error = encodeColourEndpoints(block, endpointA, endpointB, fourColours, candidateBlock);
+			if (error < bestError)
+			{
+				bestError = error;
+				memcpy(pOutBlock, candidateBlock, 8);
+			}
+
+			uint16_t colour0, colour1;
+			uint32_t indices;
+			memcpy(&colour0, candidateBlock + 0, 2);
+			memcpy(&colour1, candidateBlock + 2, 2);
+			memcpy(&indices, candidateBlock + 4, 4);
+
+			if (bestError == 0.f || !refineEndpoints(block, indices, colour0 > colour1, endpointA, endpointB))
+				break;
+		}
+	}
+
+	static void decompressColourBlock(const uint8_t* pBlock, bool alwaysFourColours, uint8_t* pOutPixels)
+	{
+		uint16_t colour0, colour1;
+		uint32_t indices;
+		memcpy(&colour0, pBlock + 0, 2);
+		memcpy(&colour1, pBlock + 2, 2);
+		memcpy(&indices, pBlock + 4, 4);
+
+		bool fourColours = alwaysFourColours || colour0 > colour1;
+
+		glm::vec3 palette[4] = {};
+		getColourPalette(colour0, colour1, fourColours, palette);
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t idx = (indices >> (i * 2)) & 3;
+			uint8_t* pPixel = pOutPixels + i * 4;
+
+			pPixel[0] = (uint8_t)glm::round(palette[idx].r);
+			pPixel[1] = (uint8_t)glm::round(palette[idx].g);
+			pPixel[2] = (uint8_t)glm::round(palette[idx].b);
+			pPixel[3] = (!fourColours && idx == 3) ? 0 : UINT8_MAX;
+		}
+	}
+
+	static void getAlphaPalette(uint8_t alpha0, uint8_t alpha1, uint8_t* pOutPalette)
+	{
+		pOutPalette[0] = alpha0;
+		pOutPalette[1] = alpha1;
+
+		if (alpha0 > alpha1)
+		{
+			for (uint32_t i = 1; i < 7; i++)
+				pOutPalette[i + 1] = (uint8_t)(((7 - i) * alpha0 + i * alpha1 + 3) / 7);
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; i++)
+				pOutPalette[i + 1] = (uint8_t)(((5 - i) * alpha0 + i * alpha1 + 2) / 5);
+
+			pOutPalette[6] = 0;
+			pOutPalette[7] = UINT8_MAX;
+		}
+	}
+
+	// Always uses the 8 alpha mode, fully transparent & opaque pixels are still matched exactly by the endpoints
+	static void compressAlphaBlock(const uint8_t* pPixels, uint8_t* pOutBlock)
+	{
+		uint8_t minAlpha = UINT8_MAX;
+		uint8_t maxAlpha = 0;
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			minAlpha = glm::min(minAlpha, pPixels[i * 4 + 3]);
+			maxAlpha = glm::max(maxAlpha, pPixels[i * 4 + 3]);
+		}
+
+		uint8_t palette[8] = {};
+		uint64_t indices = 0;
+
+		if (minAlpha != maxAlpha)
+		{
+			getAlphaPalette(maxAlpha, minAlpha, palette);
+
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				int alpha = pPixels[i * 4 + 3];
+				uint64_t bestIdx = 0;
+				for (uint32_t k = 1; k < 8; k++)
+				{
+					if (glm::abs(alpha - palette[k]) < glm::abs(alpha - palette[bestIdx]))
+						bestIdx = k;
+				}
+
+				indices |= bestIdx << (i * 3);
+			}
+		}
+
+		pOutBlock[0] = maxAlpha;
+		pOutBlock[1] = minAlpha;
+		for (uint32_t i = 0; i < 6; i++)
+			pOutBlock[2 + i] = (uint8_t)(indices >> (i * 8));
+	}
+
+	static void decompressAlphaBlock(const uint8_t* pBlock, uint8_t* pOutPixels)
+	{
+		uint8_t palette[8] = {};
+		getAlphaPalette(pBlock[0], pBlock[1], palette);
+
+		uint64_t indices = 0;
+		for (uint32_t i = 0; i < 6; i++)
+			indices |= (uint64_t)pBlock[2 + i] << (i * 8);
+
+		for (uint32_t i = 0; i < 16; i++)
+			pOutPixels[i * 4 + 3] = palette[(indices >> (i * 3)) & 7];
+	}
+
+	namespace BlockCompression
+	{
+		uint32_t getBlockSize(BCFormat format)
+		{
+			return format == BCFormat::BC1 ? 8 : 16;
+		}
+
+		uint32_t getNumBlocksX(uint32_t width)
+		{
+			return glm::max((width + 3) / 4, 1u);
+		}
+
+		uint32_t getNumBlocksY(uint32_t height)
+		{
+			return glm::max((height + 3) / 4, 1u);
+		}
+
+		uint64_t getCompressedSize(BCFormat format, uint32_t width, uint32_t height)
+		{
+			return (uint64_t)getNumBlocksX(width) * getNumBlocksY(height) * getBlockSize(format);
+		}
+
+		void compressImage(BCFormat format, BCQuality quality, const uint8_t* pPixels, uint32_t width, uint32_t height, uint8_t* pOutBlocks)
+		{
+			uint32_t blockSize = getBlockSize(format);
+			uint8_t blockPixels[16 * 4] = {};
+
+			for (uint32_t blockY = 0; blockY < getNumBlocksY(height); blockY++)
+			{
+				for (uint32_t blockX = 0; blockX < getNumBlocksX(width); blockX++)
+				{
+					for (uint32_t i = 0; i < 16; i++)
+					{
+						uint32_t x = glm::min(blockX * 4 + i % 4, width - 1);
+						uint32_t y = glm::min(blockY * 4 + i / 4, height - 1);
+						memcpy(blockPixels + i * 4, pPixels + (x + y * (uint64_t)width) * 4, 4);
+					}
+
+					uint8_t* pBlock = pOutBlocks + (blockX + blockY * (uint64_t)getNumBlocksX(width)) * blockSize;
+					if (format == BCFormat::BC1)
+					{
+						compressColourBlock(blockPixels, quality, true, pBlock);
+					}
+					else
+					{
+						compressAlphaBlock(blockPixels, pBlock);
+						compressColourBlock(blockPixels, quality, false, pBlock + 8);
+					}
+				}
+			}
+		}
+
+		void decompressImage(BCFormat format, const uint8_t* pBlocks, uint32_t width, uint32_t height, uint8_t* pOutPixels)
+		{
+			uint32_t blockSize = getBlockSize(format);
+			uint8_t blockPixels[16 * 4] = {};
+
+			for (uint32_t blockY = 0; blockY < getNumBlocksY(height); blockY++)
+			{
+				for (uint32_t blockX = 0; blockX < getNumBlocksX(width); blockX++)
+				{
+					const uint8_t* pBlock = pBlocks + (blockX + blockY * (uint64_t)getNumBlocksX(width)) * blockSize;
+					if (format == BCFormat::BC1)
+					{
+						decompressColourBlock(pBlock, false, blockPixels);
+					}
+					else
+					{
+						decompressColourBlock(pBlock + 8, true, blockPixels);
+						decompressAlphaBlock(pBlock, blockPixels);
+					}
+
+					for (uint32_t i = 0; i < 16; i++)
+					{
+						uint32_t x = blockX * 4 + i % 4;
+						uint32_t y = blockY * 4 + i / 4;
+						if (x < width && y < height)
+							memcpy(pOutPixels + (x + y * (uint64_t)width) * 4, blockPixels + i * 4, 4);
+					}
+				}
+			}
+		}
+
+		float computePSNR(const uint8_t* pSourcePixels, const uint8_t* pDecodedPixels, uint32_t numPixels)
+		{
+			double squaredError = 0.0;
+			uint32_t numSamples = 0;
+
+			for (uint32_t i = 0; i < numPixels; i++)
+			{
+				if (pSourcePixels[i * 4 + 3] < 128)
+					continue;
+
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					double diff = (double)pSourcePixels[i * 4 + c] - (double)pDecodedPixels[i * 4 + c];
+					squaredError += diff * diff;
+				}
+
+				numSamples += 3;
+			}
+
+			if (!numSamples || squaredError == 0.0)
+				return FLT_MAX;
+
+			double meanSquaredError = squaredError / numSamples;
+			return (float)(10.0 * glm::log(255.0 * 255.0 / meanSquaredError) / glm::log(10.0));
+		}
+	}
+}
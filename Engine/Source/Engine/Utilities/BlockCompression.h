@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+namespace Okay
+{
+	enum struct BCFormat : uint32_t
+	{
+		BC1 = 0, // 8 bytes per block, alpha is only on or off (cut at 128)
+		BC3,     // 16 bytes per block, BC1 colours with interpolated alpha
+	};
+
+	enum struct BCQuality : uint32_t
+	{
+		FAST = 0, // Endpoints from the colour bounding box
+		HIGH,     // Endpoints along the principal axis, refined with least squares
+	};
+
+	/*
+		CPU encoder & decoder for the BC1 & BC3 block formats. Images are split into 4x4 blocks stored row by row,
+		blocks hanging over the edge repeat the edge pixels. Pixels are tightly packed RGBA8
+	*/
+
+	namespace BlockCompression
+	{
+		uint32_t getBlockSize(BCFormat format);
+		uint32_t getNumBlocksX(uint32_t width);
+		uint32_t getNumBlocksY(uint32_t height);
+		uint64_t getCompressedSize(BCFormat format, uint32_t width, uint32_t height);
+
+		void compressImage(BCFormat format, BCQuality quality, const uint8_t* pPixels, uint32_t width, uint32_t height, uint8_t* pOutBlocks);
+		void decompressImage(BCFormat format, const uint8_t* pBlocks, uint32_t width, uint32_t height, uint8_t* pOutPixels);
+
+		// RGB over pixels visible in the source (alpha >= 128), alpha-tested pixels don't care about colour where they're cut.
+		// Returns FLT_MAX if the pixels match exactly
+		float computePSNR(const uint8_t* pSourcePixels, const uint8_t* pDecodedPixels, uint32_t numPixels);
+	}
+}
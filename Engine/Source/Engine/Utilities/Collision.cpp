@@ -3,6 +3,8 @@
 
 #include "glm/gtc/type_ptr.hpp"
 
+#include <xmmintrin.h>
+
 namespace Okay
 {
     namespace Collision
@@ -46,5 +48,134 @@ namespace Okay
         {
             return frustum.Intersects(aabb);
         }
+
+        void AABBList::clear()
+        {
+            centerX.clear();
+            centerY.clear();
+            centerZ.clear();
+            extentsX.clear();
+            extentsY.clear();
+            extentsZ.clear();
+        }
+
+        void AABBList::add(const glm::vec3& center, const glm::vec3& extents)
+        {
+            centerX.emplace_back(center.x);
+            centerY.emplace_back(center.y);
+            centerZ.emplace_back(center.z);
+            extentsX.emplace_back(extents.x);
+            extentsY.emplace_back(extents.y);
+            extentsZ.emplace_back(extents.z);
+        }
+
+        uint32_t AABBList::size() const
+        {
+            return (uint32_t)centerX.size();
+        }
+
+        FrustumPlanes createFrustumPlanes(const glm::mat4& viewProjMatrix)
+        {
+            // Gribb & Hartmann, glm is column major so the rows are gathered from each column
+            glm::vec4 rows[4] = {};
+            for (int i = 0; i < 4; i++)
+                rows[i] = glm::vec4(viewProjMatrix[0][i], viewProjMatrix[1][i], viewProjMatrix[2][i], viewProjMatrix[3][i]);
+
+            FrustumPlanes frustum;
+            frustum.planes[0] = rows[3] + rows[0]; // Left
+            frustum.planes[1] = rows[3] - rows[0]; // Right
+            frustum.planes[2] = rows[3] + rows[1]; // Bottom
+            frustum.planes[3] = rows[3] - rows[1]; // Top
+            frustum.planes[4] = rows[2];           // Near (0-1 depth)
+            frustum.planes[5] = rows[3] - rows[2]; // Far
+
+            for (glm::vec4& plane : frustum.planes)
+                plane /= glm::length(glm::vec3(plane));
+
+            return frustum;
+        }
+
+        static bool isAABBOutsidePlane(const glm::vec4& plane, const glm::vec3& center, const glm::vec3& extents)
+        {
+            float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            float radius = glm::dot(glm::abs(glm::vec3(plane)), extents);
+            return distance + radius < 0.f;
+        }
+
+        uint32_t frustumAABBBatch(const FrustumPlanes& frustum, const AABBList& aabbs, std::vector<uint8_t>& outVisible)
+        {
+            const uint32_t numBoxes = aabbs.size();
+            outVisible.resize(numBoxes);
+
+            const __m128 signMask = _mm_set1_ps(-0.f);
+            const __m128 zero = _mm_setzero_ps();
+
+            __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+            __m128 absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+            for (uint32_t p = 0; p < 6; p++)
+            {
+                planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+                planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+                planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+                planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+
+                absPlaneX[p] = _mm_andnot_ps(signMask, planeX[p]);
+                absPlaneY[p] = _mm_andnot_ps(signMask, planeY[p]);
+                absPlaneZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+            }
+
+            uint32_t numVisible = 0;
+            uint32_t i = 0;
+
+            // 4 boxes at a time, a box is culled if it's fully behind any plane
+            for (; i + 4 <= numBoxes; i += 4)
+            {
+                __m128 centerX = _mm_loadu_ps(aabbs.centerX.data() + i);
+                __m128 centerY = _mm_loadu_ps(aabbs.centerY.data() + i);
+                __m128 centerZ = _mm_loadu_ps(aabbs.centerZ.data() + i);
+                __m128 extentsX = _mm_loadu_ps(aabbs.extentsX.data() + i);
+                __m128 extentsY = _mm_loadu_ps(aabbs.extentsY.data() + i);
+                __m128 extentsZ = _mm_loadu_ps(aabbs.extentsZ.data() + i);
+
+                __m128 outside = _mm_setzero_ps();
+                for (uint32_t p = 0; p < 6; p++)
+                {
+                    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)),
+                        _mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), planeW[p]));
+
+                    __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absPlaneX[p], extentsX), _mm_mul_ps(absPlaneY[p], extentsY)),
+                        _mm_mul_ps(absPlaneZ[p], extentsZ));
+
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+                }
+
+                int outsideMask = _mm_movemask_ps(outside);
+                for (uint32_t j = 0; j < 4; j++)
+                {
+                    outVisible[i + j] = (outsideMask >> j) & 1 ? 0 : 1;
+                    numVisible += outVisible[i + j];
+                }
+            }
+
+            for (; i < numBoxes; i++)
+            {
+                glm::vec3 center = glm::vec3(aabbs.centerX[i], aabbs.centerY[i], aabbs.centerZ[i]);
+                glm::vec3 extents = glm::vec3(aabbs.extentsX[i], aabbs.extentsY[i], aabbs.extentsZ[i]);
+
+                outVisible[i] = 1;
+                for (const glm::vec4& plane : frustum.planes)
+                {
+                    if (isAABBOutsidePlane(plane, center, extents))
+                    {
+                        outVisible[i] = 0;
+                        break;
+                    }
+                }
+
+                numVisible += outVisible[i];
+            }
+
+            return numVisible;
+        }
     }
 }
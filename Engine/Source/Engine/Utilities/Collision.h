@@ -5,6 +5,8 @@
 #include <DirectXMath.h>
 #include <DirectXCollision.h>
 
+#include <vector>
+
 namespace Okay
 {
     struct Camera;
@@ -18,5 +20,28 @@ namespace Okay
         AABB createAABB(const glm::vec3& center, const glm::vec3& extents);
 
         bool frustumAABB(const Frustum& frustum, const AABB& aabb);
+
+        // World space planes (xyz = normal pointing inwards, w = distance), extracted from a view projection matrix with 0-1 depth
+        struct FrustumPlanes
+        {
+            glm::vec4 planes[6] = {};
+        };
+
+        // Structure of arrays so the batch test can load 4 boxes per SIMD register
+        struct AABBList
+        {
+            std::vector<float> centerX, centerY, centerZ;
+            std::vector<float> extentsX, extentsY, extentsZ;
+
+            void clear();
+            void add(const glm::vec3& center, const glm::vec3& extents);
+            uint32_t size() const;
+        };
+
+        FrustumPlanes createFrustumPlanes(const glm::mat4& viewProjMatrix);
+
+        // outVisible[i] is set to 1 if box i intersects or is inside the frustum, returns the number of visible boxes.
+        // Conservative, boxes near frustum corners can be reported as visible
+        uint32_t frustumAABBBatch(const FrustumPlanes& frustum, const AABBList& aabbs, std::vector<uint8_t>& outVisible);
     }
 }
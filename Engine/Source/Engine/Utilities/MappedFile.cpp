@@ -0,0 +1,73 @@
+#include "MappedFile.h"
+
+#include <windows.h>
+
+namespace Okay
+{
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const FilePath& path)
+	{
+		close();
+
+		HANDLE fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+			return false;
+
+		m_fileHandle = fileHandle;
+
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		m_mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_mappingHandle)
+		{
+			close();
+			return false;
+		}
+
+		m_pData = (const uint8_t*)MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (!m_pData)
+		{
+			close();
+			return false;
+		}
+
+		m_size = (uint64_t)fileSize.QuadPart;
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (m_pData)
+			UnmapViewOfFile(m_pData);
+
+		if (m_mappingHandle)
+			CloseHandle(m_mappingHandle);
+
+		if (m_fileHandle)
+			CloseHandle(m_fileHandle);
+
+		m_fileHandle = nullptr;
+		m_mappingHandle = nullptr;
+		m_pData = nullptr;
+		m_size = 0;
+	}
+
+	const uint8_t* MappedFile::getData() const
+	{
+		return m_pData;
+	}
+
+	uint64_t MappedFile::getSize() const
+	{
+		return m_size;
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+namespace Okay
+{
+	// Read only view of a whole file, the OS pages it in on demand instead of it being copied into memory
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Fails for missing & empty files
+		bool open(const FilePath& path);
+		void close();
+
+		const uint8_t* getData() const;
+		uint64_t getSize() const;
+
+	private:
+		void* m_fileHandle = nullptr;
+		void* m_mappingHandle = nullptr;
+		const uint8_t* m_pData = nullptr;
+		uint64_t m_size = 0;
+
+	};
+}
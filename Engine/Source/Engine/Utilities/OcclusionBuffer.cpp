@@ -0,0 +1,250 @@
+#include "OcclusionBuffer.h"
+
+#include <cfloat>
+
+namespace Okay
+{
+	// Corner i of a box has x from bit 0, y from bit 1 & z from bit 2 (0 = min, 1 = max)
+	static const uint32_t BOX_FACE_CORNERS[6][4] =
+	{
+		{ 0, 2, 6, 4 }, { 1, 3, 7, 5 }, // -X, +X
+		{ 0, 1, 5, 4 }, { 2, 3, 7, 6 }, // -Y, +Y
+		{ 0, 1, 3, 2 }, { 4, 5, 7, 6 }, // -Z, +Z
+	};
+
+	static glm::vec3 getBoxCorner(const glm::vec3& boxMin, const glm::vec3& boxMax, uint32_t cornerIdx)
+	{
+		return glm::vec3(
+			cornerIdx & 1 ? boxMax.x : boxMin.x,
+			cornerIdx & 2 ? boxMax.y : boxMin.y,
+			cornerIdx & 4 ? boxMax.z : boxMin.z);
+	}
+
+	void OcclusionBuffer::initialize(uint32_t width, uint32_t height)
+	{
+		OKAY_ASSERT(width > 0 && height > 0);
+
+		m_width = width;
+		m_height = height;
+		m_depth.resize((size_t)width * height);
+		clear();
+	}
+
+	void OcclusionBuffer::shutdown()
+	{
+		m_width = 0;
+		m_height = 0;
+		m_depth.clear();
+		m_depth.shrink_to_fit();
+		m_triangles.clear();
+		m_triangles.shrink_to_fit();
+	}
+
+	void OcclusionBuffer::clear()
+	{
+		std::fill(m_depth.begin(), m_depth.end(), 1.f);
+		m_triangles.clear();
+	}
+
+	void OcclusionBuffer::setViewProjection(const glm::mat4& viewProjMatrix, const glm::vec3& cameraPos)
+	{
+		m_viewProjMatrix = viewProjMatrix;
+		m_cameraPos = cameraPos;
+	}
+
+	void OcclusionBuffer::addOccluder(const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		glm::vec4 clipCorners[8] = {};
+		for (uint32_t i = 0; i < 8; i++)
+			clipCorners[i] = m_viewProjMatrix * glm::vec4(getBoxCorner(boxMin, boxMax, i), 1.f);
+
+		// Only the faces pointing towards the camera are needed, the back faces are always behind them
+		bool faceVisible[6] =
+		{
+			m_cameraPos.x < boxMin.x, m_cameraPos.x > boxMax.x,
+			m_cameraPos.y < boxMin.y, m_cameraPos.y > boxMax.y,
+			m_cameraPos.z < boxMin.z, m_cameraPos.z > boxMax.z,
+		};
+
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			if (!faceVisible[face])
+				continue;
+
+			// Clip the quad against the near plane (z >= 0), which can add one corner
+			glm::vec3 polygon[5] = {};
+			uint32_t numPolygonCorners = 0;
+
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				const glm::vec4& current = clipCorners[BOX_FACE_CORNERS[face][i]];
+				const glm::vec4& next = clipCorners[BOX_FACE_CORNERS[face][(i + 1) % 4]];
+
+				if (current.z >= 0.f)
+					polygon[numPolygonCorners++] = clipToScreen(current);
+
+				if ((current.z >= 0.f) != (next.z >= 0.f))
+				{
+					float t = current.z / (current.z - next.z);
+					polygon[numPolygonCorners++] = clipToScreen(current + (next - current) * t);
+				}
+			}
+
+			for (uint32_t i = 2; i < numPolygonCorners; i++)
+				addTriangle(polygon[0], polygon[i - 1], polygon[i]);
+		}
+	}
+
+	uint32_t OcclusionBuffer::getNumTriangles() const
+	{
+		return (uint32_t)m_triangles.size();
+	}
+
+	void OcclusionBuffer::rasterizeTriangles(uint32_t triangleBegin, uint32_t triangleEnd, uint32_t rowBegin, uint32_t rowEnd)
+	{
+		OKAY_ASSERT(triangleEnd <= (uint32_t)m_triangles.size());
+
+		for (uint32_t triangleIdx = triangleBegin; triangleIdx < triangleEnd; triangleIdx++)
+		{
+			const ScreenTriangle& triangle = m_triangles[triangleIdx];
+
+			int32_t yBegin = glm::max(triangle.yBegin, (int32_t)rowBegin);
+			int32_t yEnd = glm::min(triangle.yEnd, (int32_t)rowEnd);
+
+			for (int32_t y = yBegin; y < yEnd; y++)
+			{
+				float pixelY = (float)y + 0.5f;
+				float* pRow = m_depth.data() + (size_t)y * m_width;
+
+				for (int32_t x = triangle.xBegin; x < triangle.xEnd; x++)
+				{
+					float pixelX = (float)x + 0.5f;
+
+					bool inside = true;
+					for (uint32_t i = 0; i < 3 && inside; i++)
+					{
+						const glm::vec2& origin = triangle.edgeOrigins[i];
+						const glm::vec2& direction = triangle.edgeDirections[i];
+						inside = direction.x * (pixelY - origin.y) - direction.y * (pixelX - origin.x) >= 0.f;
+					}
+
+					if (!inside)
+						continue;
+
+					float depth = triangle.v0.z + triangle.depthDX * (pixelX - triangle.v0.x) + triangle.depthDY * (pixelY - triangle.v0.y);
+					depth = glm::min(depth + triangle.pixelDepthOffset, triangle.maxDepth);
+
+					pRow[x] = glm::min(pRow[x], depth);
+				}
+			}
+		}
+	}
+
+	bool OcclusionBuffer::testAABB(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+	{
+		glm::vec2 screenMin = glm::vec2(FLT_MAX);
+		glm::vec2 screenMax = glm::vec2(-FLT_MAX);
+		float nearestDepth = FLT_MAX;
+
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			glm::vec4 clipPos = m_viewProjMatrix * glm::vec4(getBoxCorner(boxMin, boxMax, i), 1.f);
+			if (clipPos.z < 0.f)
+				return true;
+
+			glm::vec3 screenPos = clipToScreen(clipPos);
+			screenMin = glm::min(screenMin, glm::vec2(screenPos));
+			screenMax = glm::max(screenMax, glm::vec2(screenPos));
+			nearestDepth = glm::min(nearestDepth, screenPos.z);
+		}
+
+		if (screenMax.x < 0.f || screenMax.y < 0.f || screenMin.x >= (float)m_width || screenMin.y >= (float)m_height)
+			return true;
+
+		// Every touched pixel plus one around it
+		int32_t xBegin = glm::max((int32_t)glm::floor(glm::max(screenMin.x, 0.f)) - 1, 0);
+		int32_t yBegin = glm::max((int32_t)glm::floor(glm::max(screenMin.y, 0.f)) - 1, 0);
+		int32_t xEnd = glm::min((int32_t)glm::floor(glm::min(screenMax.x, (float)m_width)) + 2, (int32_t)m_width);
+		int32_t yEnd = glm::min((int32_t)glm::floor(glm::min(screenMax.y, (float)m_height)) + 2, (int32_t)m_height);
+
+		for (int32_t y = yBegin; y < yEnd; y++)
+		{
+			const float* pRow = m_depth.data() + (size_t)y * m_width;
+			for (int32_t x = xBegin; x < xEnd; x++)
+			{
+				if (pRow[x] >= nearestDepth)
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	uint32_t OcclusionBuffer::getWidth() const
+	{
+		return m_width;
+	}
+
+	uint32_t OcclusionBuffer::getHeight() const
+	{
+		return m_height;
+	}
+
+	float OcclusionBuffer::getDepth(uint32_t x, uint32_t y) const
+	{
+		OKAY_ASSERT(x < m_width && y < m_height);
+		return m_depth[(size_t)y * m_width + x];
+	}
+
+	void OcclusionBuffer::addTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+	{
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (glm::abs(area) < 1e-6f)
+			return;
+
+		if (area < 0.f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		// Pixel centers inside the bounds
+		float minX = glm::min(glm::min(v0.x, v1.x), v2.x);
+		float maxX = glm::max(glm::max(v0.x, v1.x), v2.x);
+		float minY = glm::min(glm::min(v0.y, v1.y), v2.y);
+		float maxY = glm::max(glm::max(v0.y, v1.y), v2.y);
+
+		ScreenTriangle triangle;
+		triangle.xBegin = (int32_t)glm::ceil(glm::clamp(minX, 0.f, (float)m_width) - 0.5f);
+		triangle.xEnd = (int32_t)glm::floor(glm::clamp(maxX, 0.f, (float)m_width) - 0.5f) + 1;
+		triangle.yBegin = (int32_t)glm::ceil(glm::clamp(minY, 0.f, (float)m_height) - 0.5f);
+		triangle.yEnd = (int32_t)glm::floor(glm::clamp(maxY, 0.f, (float)m_height) - 0.5f) + 1;
+
+		if (triangle.xBegin >= triangle.xEnd || triangle.yBegin >= triangle.yEnd)
+			return;
+
+		// Depth is linear in screen space after the perspective divide
+		triangle.depthDX = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+		triangle.depthDY = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+
+		// Farthest the plane gets within a pixel, never past the farthest corner
+		triangle.pixelDepthOffset = 0.5f * (glm::abs(triangle.depthDX) + glm::abs(triangle.depthDY));
+		triangle.maxDepth = glm::max(glm::max(v0.z, v1.z), v2.z);
+		triangle.v0 = v0;
+
+		const glm::vec3* edges[3][2] = { { &v0, &v1 }, { &v1, &v2 }, { &v2, &v0 } };
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			triangle.edgeOrigins[i] = glm::vec2(*edges[i][0]);
+			triangle.edgeDirections[i] = glm::vec2(*edges[i][1]) - glm::vec2(*edges[i][0]);
+		}
+
+		m_triangles.emplace_back(triangle);
+	}
+
+	glm::vec3 OcclusionBuffer::clipToScreen(const glm::vec4& clipPos) const
+	{
+		glm::vec3 ndc = glm::vec3(clipPos) / clipPos.w;
+		return glm::vec3((ndc.x * 0.5f + 0.5f) * m_width, (0.5f - ndc.y * 0.5f) * m_height, ndc.z);
+	}
+}
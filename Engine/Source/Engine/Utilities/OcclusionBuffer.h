@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+namespace Okay
+{
+	/*
+		Low resolution depth buffer filled on the CPU with boxes known to be completely solid, used to skip drawing things hidden behind them.
+		Expects a left handed view projection with 0-1 depth, row 0 is the top of the screen.
+
+		Both sides are conservative:
+		- Occluders only cover pixels whose center is inside them and write the farthest depth their plane reaches within the pixel
+		- Tested boxes cover every pixel they touch plus one pixel around, which hides the pixels that are only partially covered at occluder edges
+		Gaps between occluders narrower than a pixel can still end up covered, so it's only conservative at its own resolution
+
+		Filling is split in two so the projection & clipping is only done once when several threads fill the buffer:
+		addOccluder turns a box into screen space triangles, rasterizeTriangles then writes them to a band of rows
+	*/
+
+	class OcclusionBuffer
+	{
+	public:
+		OcclusionBuffer() = default;
+		~OcclusionBuffer() = default;
+
+		void initialize(uint32_t width, uint32_t height);
+		void shutdown();
+
+		// Resets every pixel to the far plane & removes the added triangles
+		void clear();
+		void setViewProjection(const glm::mat4& viewProjMatrix, const glm::vec3& cameraPos);
+
+		// Adds the triangles of the box faces pointing towards the camera, skipping the ones that can't cover a pixel center
+		void addOccluder(const glm::vec3& boxMin, const glm::vec3& boxMax);
+		uint32_t getNumTriangles() const;
+
+		// Only rows [rowBegin, rowEnd) are written, so separate threads can fill separate bands of the same buffer
+		void rasterizeTriangles(uint32_t triangleBegin, uint32_t triangleEnd, uint32_t rowBegin, uint32_t rowEnd);
+
+		// False only if the box is completely hidden behind occluders. Boxes crossing the near plane or outside the screen are always visible
+		bool testAABB(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+		uint32_t getWidth() const;
+		uint32_t getHeight() const;
+		float getDepth(uint32_t x, uint32_t y) const;
+
+	private:
+		// Everything that doesn't depend on the rows being written
+		struct ScreenTriangle
+		{
+			glm::vec2 edgeOrigins[3] = {};
+			glm::vec2 edgeDirections[3] = {};
+
+			glm::vec3 v0 = glm::vec3(0.f);
+			float depthDX = 0.f;
+			float depthDY = 0.f;
+			float pixelDepthOffset = 0.f;
+			float maxDepth = 0.f;
+
+			int32_t xBegin = 0;
+			int32_t xEnd = 0;
+			int32_t yBegin = 0;
+			int32_t yEnd = 0;
+		};
+
+		// xy in pixels, z in 0-1 depth
+		void addTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2);
+		glm::vec3 clipToScreen(const glm::vec4& clipPos) const;
+
+		uint32_t m_width = 0;
+		uint32_t m_height = 0;
+		std::vector<float> m_depth;
+		std::vector<ScreenTriangle> m_triangles;
+
+		glm::mat4 m_viewProjMatrix = glm::mat4(1.f);
+		glm::vec3 m_cameraPos = glm::vec3(0.f);
+
+	};
+}
@@ -0,0 +1,161 @@
+#include "PagedAllocator.h"
+
+namespace Okay
+{
+	void PagedAllocator::initialize(uint64_t pageSize)
+	{
+		OKAY_ASSERT(pageSize > 0);
+
+		m_pageSize = pageSize;
+		m_pages.clear();
+		m_largestFreeSizes.clear();
+	}
+
+	void PagedAllocator::shutdown()
+	{
+		m_pages.clear();
+		m_pages.shrink_to_fit();
+		m_largestFreeSizes.clear();
+		m_largestFreeSizes.shrink_to_fit();
+	}
+
+	void PagedAllocator::clear()
+	{
+		for (uint32_t i = 0; i < (uint32_t)m_pages.size(); i++)
+		{
+			m_pages[i].clear();
+			updateLargestFreeSize(i);
+		}
+	}
+
+	uint32_t PagedAllocator::addPage(uint64_t minSize)
+	{
+		TLSFAllocator& page = m_pages.emplace_back();
+		page.initialize(glm::max(m_pageSize, minSize));
+		m_largestFreeSizes.emplace_back(page.getSize());
+
+		return (uint32_t)m_pages.size() - 1;
+	}
+
+	bool PagedAllocator::findFreeBlock(uint64_t size, PagedAllocation* pOutFreeBlock) const
+	{
+		for (uint32_t i = 0; i < (uint32_t)m_pages.size(); i++)
+		{
+			if (m_largestFreeSizes[i] < size)
+				continue;
+
+			uint32_t freeHandle = m_pages[i].findFreeBlock(size);
+			if (freeHandle == INVALID_UINT32)
+				continue;
+
+			pOutFreeBlock->pageIdx = i;
+			pOutFreeBlock->allocationHandle = freeHandle;
+			pOutFreeBlock->offset = m_pages[i].getOffset(freeHandle);
+			pOutFreeBlock->size = m_pages[i].getAllocationSize(freeHandle);
+			return true;
+		}
+
+		return false;
+	}
+
+	PagedAllocation PagedAllocator::claimFreeBlock(const PagedAllocation& freeBlock, uint64_t size)
+	{
+		OKAY_ASSERT(freeBlock.pageIdx < (uint32_t)m_pages.size());
+
+		PagedAllocation allocation;
+		allocation.pageIdx = freeBlock.pageIdx;
+		allocation.size = size;
+		allocation.allocationHandle = m_pages[freeBlock.pageIdx].claimFreeBlock(freeBlock.allocationHandle, size, 1, &allocation.offset);
+		updateLargestFreeSize(freeBlock.pageIdx);
+
+		return allocation;
+	}
+
+	bool PagedAllocator::allocate(uint64_t size, PagedAllocation* pOutAllocation)
+	{
+		PagedAllocation freeBlock;
+		if (!findFreeBlock(size, &freeBlock))
+			return false;
+
+		*pOutAllocation = claimFreeBlock(freeBlock, size);
+		return true;
+	}
+
+	void PagedAllocator::free(const PagedAllocation& allocation)
+	{
+		OKAY_ASSERT(allocation.pageIdx < (uint32_t)m_pages.size());
+		m_pages[allocation.pageIdx].free(allocation.allocationHandle);
+		updateLargestFreeSize(allocation.pageIdx);
+	}
+
+	uint64_t PagedAllocator::getPageSize() const
+	{
+		return m_pageSize;
+	}
+
+	uint64_t PagedAllocator::getPageSize(uint32_t pageIdx) const
+	{
+		OKAY_ASSERT(pageIdx < (uint32_t)m_pages.size());
+		return m_pages[pageIdx].getSize();
+	}
+
+	uint32_t PagedAllocator::getNumPages() const
+	{
+		return (uint32_t)m_pages.size();
+	}
+
+	uint64_t PagedAllocator::getTotalSize() const
+	{
+		uint64_t totalSize = 0;
+		for (const TLSFAllocator& page : m_pages)
+			totalSize += page.getSize();
+
+		return totalSize;
+	}
+
+	uint64_t PagedAllocator::getTotalFreeSize() const
+	{
+		uint64_t totalFreeSize = 0;
+		for (const TLSFAllocator& page : m_pages)
+			totalFreeSize += page.getTotalFreeSize();
+
+		return totalFreeSize;
+	}
+
+	uint64_t PagedAllocator::getLargestFreeBlockSize() const
+	{
+		uint64_t largestFreeSize = 0;
+		for (uint64_t pageLargestFreeSize : m_largestFreeSizes)
+			largestFreeSize = glm::max(largestFreeSize, pageLargestFreeSize);
+
+		return largestFreeSize;
+	}
+
+	uint32_t PagedAllocator::getNumAllocations() const
+	{
+		uint32_t numAllocations = 0;
+		for (const TLSFAllocator& page : m_pages)
+			numAllocations += page.getNumAllocations();
+
+		return numAllocations;
+	}
+
+	float PagedAllocator::getFragmentation() const
+	{
+		uint64_t totalFreeSize = 0;
+		uint64_t splitFreeSize = 0;
+		for (uint32_t i = 0; i < (uint32_t)m_pages.size(); i++)
+		{
+			uint64_t pageFreeSize = m_pages[i].getTotalFreeSize();
+			totalFreeSize += pageFreeSize;
+			splitFreeSize += pageFreeSize - m_largestFreeSizes[i];
+		}
+
+		return totalFreeSize ? splitFreeSize / (float)totalFreeSize : 0.f;
+	}
+
+	void PagedAllocator::updateLargestFreeSize(uint32_t pageIdx)
+	{
+		m_largestFreeSizes[pageIdx] = m_pages[pageIdx].getLargestFreeBlockSize();
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Engine/Utilities/TLSFAllocator.h"
+
+namespace Okay
+{
+	struct PagedAllocation
+	{
+		uint32_t pageIdx = INVALID_UINT32;
+		uint32_t allocationHandle = INVALID_UINT32; // Handle inside the page's TLSFAllocator
+		uint64_t offset = INVALID_UINT64; // Relative to the start of the page
+		uint64_t size = INVALID_UINT64;
+	};
+
+	/*
+		Offset bookkeeping for memory made up of separate pages (like one GPU buffer per page).
+		Growing only adds pages, so existing allocations never move.
+		Pages are normally pageSize big, but allocations bigger than that get a page of their own.
+	*/
+
+	class PagedAllocator
+	{
+	public:
+		PagedAllocator() = default;
+		~PagedAllocator() = default;
+
+		void initialize(uint64_t pageSize);
+		void shutdown();
+
+		// Frees all allocations but keeps the pages, handles from before the call are invalid after
+		void clear();
+
+		// Returns the index of the new page, which is max(pageSize, minSize) big
+		uint32_t addPage(uint64_t minSize = 0);
+
+		// Fills pOutFreeBlock with the page, free block handle & offset of a block that can hold the allocation.
+		// Pages are searched in order so lower pages fill up first, pages whose largest free block is too small are skipped
+		bool findFreeBlock(uint64_t size, PagedAllocation* pOutFreeBlock) const;
+
+		// Allocates from a block returned by findFreeBlock (using the same size)
+		PagedAllocation claimFreeBlock(const PagedAllocation& freeBlock, uint64_t size);
+
+		// Returns false if no page has enough contiguous free memory, call addPage and try again
+		bool allocate(uint64_t size, PagedAllocation* pOutAllocation);
+		void free(const PagedAllocation& allocation);
+
+		uint64_t getPageSize() const;
+		uint64_t getPageSize(uint32_t pageIdx) const;
+		uint32_t getNumPages() const;
+
+		uint64_t getTotalSize() const;
+		uint64_t getTotalFreeSize() const;
+		uint64_t getLargestFreeBlockSize() const;
+		uint32_t getNumAllocations() const;
+
+		// Share of the free memory outside the largest free block of its page, allocations can't span pages
+		// so free space at the end of several pages doesn't count
+		float getFragmentation() const;
+
+	private:
+		void updateLargestFreeSize(uint32_t pageIdx);
+
+	private:
+		std::vector<TLSFAllocator> m_pages;
+		std::vector<uint64_t> m_largestFreeSizes; // Per page, kept up to date so searches don't have to ask every page
+		uint64_t m_pageSize = 0;
+
+	};
+}
@@ -0,0 +1,71 @@
+#include "RenderQueue.h"
+
+#include <bit>
+
+namespace Okay
+{
+	uint64_t RenderQueue::makeSortKey(uint32_t pass, float depth, bool backToFront)
+	{
+		OKAY_ASSERT(pass < 16);
+
+		// Sign, exponent & 11 bits of mantissa, within 0.05% of the real depth
+		uint32_t depthBits = std::bit_cast<uint32_t>(glm::max(depth, 0.f)) >> 12;
+		if (backToFront)
+			depthBits = ~depthBits & 0xFFFFF;
+
+		return (uint64_t)pass << 60 | (uint64_t)depthBits << 40;
+	}
+
+	void RenderQueue::clear()
+	{
+		m_items.clear();
+	}
+
+	void RenderQueue::push(uint64_t sortKey, uint32_t itemIdx)
+	{
+		RenderQueueItem& item = m_items.emplace_back();
+		item.sortKey = sortKey;
+		item.itemIdx = itemIdx;
+	}
+
+	void RenderQueue::sort()
+	{
+		if (m_items.size() < 2)
+			return;
+
+		m_scratchItems.resize(m_items.size());
+
+		// Bits that differ between any two keys, bytes without any can't change the order
+		uint64_t differingBits = 0;
+		for (const RenderQueueItem& item : m_items)
+			differingBits |= item.sortKey ^ m_items[0].sortKey;
+
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			if (!((differingBits >> shift) & 0xFF))
+				continue;
+
+			uint32_t offsets[256] = {};
+			for (const RenderQueueItem& item : m_items)
+				offsets[(item.sortKey >> shift) & 0xFF]++;
+
+			uint32_t itemOffset = 0;
+			for (uint32_t& offset : offsets)
+			{
+				uint32_t count = offset;
+				offset = itemOffset;
+				itemOffset += count;
+			}
+
+			for (const RenderQueueItem& item : m_items)
+				m_scratchItems[offsets[(item.sortKey >> shift) & 0xFF]++] = item;
+
+			m_items.swap(m_scratchItems);
+		}
+	}
+
+	const std::vector<RenderQueueItem>& RenderQueue::getItems() const
+	{
+		return m_items;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+namespace Okay
+{
+	struct RenderQueueItem
+	{
+		uint64_t sortKey = 0;
+		uint32_t itemIdx = INVALID_UINT32;
+	};
+
+	/*
+		Items sorted by a 64 bit key with an LSD radix sort, 8 bits per pass. Passes where every key has the same byte are skipped,
+		so keys only using a few of their bits are cheap to sort. The sort is stable & doesn't know what the items are.
+
+		Key layout from the highest bit: render pass (4 bits), depth (20 bits), rest unused so a full sort is 3 passes.
+		There's no pipeline field, the draws of a render pass share one PSO so the pass already groups them.
+		Depth is the top bits of the float, which order the same as the floats since distances are never negative
+	*/
+
+	class RenderQueue
+	{
+	public:
+		RenderQueue() = default;
+		~RenderQueue() = default;
+
+		static uint64_t makeSortKey(uint32_t pass, float depth, bool backToFront);
+
+		void clear();
+		void push(uint64_t sortKey, uint32_t itemIdx);
+		void sort();
+
+		const std::vector<RenderQueueItem>& getItems() const;
+
+	private:
+		std::vector<RenderQueueItem> m_items;
+		std::vector<RenderQueueItem> m_scratchItems;
+
+	};
+}
@@ -0,0 +1,115 @@
+#include "RingAllocator.h"
+
+namespace Okay
+{
+	void RingAllocator::initialize(uint64_t size)
+	{
+		m_size = size;
+		m_head = 0;
+		m_tail = 0;
+		m_usedSize = 0;
+		m_currentFrameSize = 0;
+		m_frames.clear();
+	}
+
+	void RingAllocator::shutdown()
+	{
+		initialize(0);
+	}
+
+	uint64_t RingAllocator::allocate(uint64_t size, uint64_t alignment)
+	{
+		OKAY_ASSERT(size > 0 && alignment > 0);
+
+		// Everything is free, starting over from 0 keeps the whole buffer contiguous
+		if (m_usedSize == 0)
+		{
+			m_head = 0;
+			m_tail = 0;
+		}
+		else if (m_usedSize == m_size)
+		{
+			return INVALID_UINT64;
+		}
+
+		uint64_t alignedHead = (m_head + alignment - 1) / alignment * alignment;
+		uint64_t allocatedSize = INVALID_UINT64;
+		uint64_t offset = INVALID_UINT64;
+
+		if (m_head >= m_tail)
+		{
+			// Free space is [head, size) & [0, tail)
+			if (alignedHead + size <= m_size)
+			{
+				offset = alignedHead;
+				allocatedSize = alignedHead - m_head + size;
+			}
+			else if (size <= m_tail)
+			{
+				// The skipped space at the end counts as used by this frame so it's freed together with it
+				offset = 0;
+				allocatedSize = m_size - m_head + size;
+			}
+		}
+		else if (alignedHead + size <= m_tail)
+		{
+			// Free space is [head, tail)
+			offset = alignedHead;
+			allocatedSize = alignedHead - m_head + size;
+		}
+
+		if (offset == INVALID_UINT64)
+			return INVALID_UINT64;
+
+		m_head = offset + size;
+		m_usedSize += allocatedSize;
+		m_currentFrameSize += allocatedSize;
+
+		return offset;
+	}
+
+	void RingAllocator::endFrame(uint64_t fenceValue)
+	{
+		OKAY_ASSERT(m_frames.empty() || m_frames.back().fenceValue < fenceValue);
+
+		if (m_currentFrameSize == 0)
+			return;
+
+		FrameRange& frame = m_frames.emplace_back();
+		frame.fenceValue = fenceValue;
+		frame.endOffset = m_head;
+		frame.size = m_currentFrameSize;
+
+		m_currentFrameSize = 0;
+	}
+
+	void RingAllocator::releaseCompleted(uint64_t completedFenceValue)
+	{
+		while (!m_frames.empty() && m_frames.front().fenceValue <= completedFenceValue)
+		{
+			m_tail = m_frames.front().endOffset;
+			m_usedSize -= m_frames.front().size;
+			m_frames.pop_front();
+		}
+	}
+
+	uint64_t RingAllocator::getOldestFenceValue() const
+	{
+		return m_frames.empty() ? INVALID_UINT64 : m_frames.front().fenceValue;
+	}
+
+	uint64_t RingAllocator::getSize() const
+	{
+		return m_size;
+	}
+
+	uint64_t RingAllocator::getUsedSize() const
+	{
+		return m_usedSize;
+	}
+
+	uint64_t RingAllocator::getCurrentFrameSize() const
+	{
+		return m_currentFrameSize;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <deque>
+
+namespace Okay
+{
+	/*
+		Offset bookkeeping for a ring buffer shared by all frames in flight, only the head & tail are tracked so it can manage any linear memory.
+		Allocations are made at the head and are grouped per frame, once a frame's fence value is reached the tail moves past them.
+		Allocations are always contiguous, if one doesn't fit at the end of the buffer the end is skipped and it's placed at the start.
+	*/
+
+	class RingAllocator
+	{
+	public:
+		RingAllocator() = default;
+		~RingAllocator() = default;
+
+		void initialize(uint64_t size);
+		void shutdown();
+
+		// Returns INVALID_UINT64 if there isn't enough space, releaseCompleted needs to free up older frames before trying again
+		uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+		// Everything allocated since the last call is freed once completedFenceValue in releaseCompleted reaches fenceValue.
+		// Fence values need to increase between calls
+		void endFrame(uint64_t fenceValue);
+		void releaseCompleted(uint64_t completedFenceValue);
+
+		// INVALID_UINT64 if no ended frame is waiting to be released
+		uint64_t getOldestFenceValue() const;
+
+		uint64_t getSize() const;
+		uint64_t getUsedSize() const; // Includes alignment padding & skipped space at the end
+		uint64_t getCurrentFrameSize() const;
+
+	private:
+		struct FrameRange
+		{
+			uint64_t fenceValue = INVALID_UINT64;
+			uint64_t endOffset = 0; // The head when the frame ended, becomes the tail once the frame is released
+			uint64_t size = 0;
+		};
+
+		std::deque<FrameRange> m_frames;
+
+		uint64_t m_size = 0;
+		uint64_t m_head = 0;
+		uint64_t m_tail = 0;
+		uint64_t m_usedSize = 0;
+		uint64_t m_currentFrameSize = 0;
+
+	};
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+namespace Okay
+{
+	// A handle stays valid until its element is removed, after that the slot's generation no longer matches
+	struct SlotHandle
+	{
+		uint32_t slotIdx = INVALID_UINT32;
+		uint32_t generation = 0;
+
+		bool operator==(const SlotHandle& other) const = default;
+	};
+
+	/*
+		Elements are stored densely for fast iteration, removing swaps the last element into the hole.
+		Handles go through a slot which tracks where its element currently is, so they aren't affected by the swaps.
+		Insert, remove & lookup are all O(1)
+	*/
+
+	template<typename T>
+	class SlotMap
+	{
+	public:
+		SlotMap() = default;
+		~SlotMap() = default;
+
+		SlotHandle insert(T&& value)
+		{
+			uint32_t slotIdx = INVALID_UINT32;
+			if (!m_freeSlots.empty())
+			{
+				slotIdx = m_freeSlots.back();
+				m_freeSlots.pop_back();
+			}
+			else
+			{
+				slotIdx = (uint32_t)m_slots.size();
+				m_slots.emplace_back();
+			}
+
+			Slot& slot = m_slots[slotIdx];
+			slot.denseIdx = (uint32_t)m_dense.size();
+
+			m_dense.emplace_back(std::move(value));
+			m_denseToSlot.emplace_back(slotIdx);
+
+			return SlotHandle{ slotIdx, slot.generation };
+		}
+
+		SlotHandle insert(const T& value)
+		{
+			return insert(T(value));
+		}
+
+		// Returns false if the handle was already stale
+		bool remove(SlotHandle handle)
+		{
+			if (!contains(handle))
+				return false;
+
+			Slot& slot = m_slots[handle.slotIdx];
+			uint32_t lastDenseIdx = (uint32_t)m_dense.size() - 1;
+
+			if (slot.denseIdx != lastDenseIdx)
+			{
+				m_dense[slot.denseIdx] = std::move(m_dense[lastDenseIdx]);
+				m_denseToSlot[slot.denseIdx] = m_denseToSlot[lastDenseIdx];
+				m_slots[m_denseToSlot[slot.denseIdx]].denseIdx = slot.denseIdx;
+			}
+
+			m_dense.pop_back();
+			m_denseToSlot.pop_back();
+
+			slot.denseIdx = INVALID_UINT32;
+			slot.generation++;
+			m_freeSlots.emplace_back(handle.slotIdx);
+
+			return true;
+		}
+
+		// Invalidates all handles
+		void clear()
+		{
+			m_freeSlots.clear();
+			for (uint32_t i = 0; i < (uint32_t)m_slots.size(); i++)
+			{
+				if (m_slots[i].denseIdx != INVALID_UINT32)
+				{
+					m_slots[i].denseIdx = INVALID_UINT32;
+					m_slots[i].generation++;
+				}
+
+				m_freeSlots.emplace_back(i);
+			}
+
+			m_dense.clear();
+			m_denseToSlot.clear();
+		}
+
+		bool contains(SlotHandle handle) const
+		{
+			return handle.slotIdx < (uint32_t)m_slots.size() && m_slots[handle.slotIdx].generation == handle.generation &&
+				m_slots[handle.slotIdx].denseIdx != INVALID_UINT32;
+		}
+
+		T* tryGet(SlotHandle handle)
+		{
+			return contains(handle) ? &m_dense[m_slots[handle.slotIdx].denseIdx] : nullptr;
+		}
+
+		const T* tryGet(SlotHandle handle) const
+		{
+			return contains(handle) ? &m_dense[m_slots[handle.slotIdx].denseIdx] : nullptr;
+		}
+
+		T& get(SlotHandle handle)
+		{
+			OKAY_ASSERT(contains(handle));
+			return m_dense[m_slots[handle.slotIdx].denseIdx];
+		}
+
+		const T& get(SlotHandle handle) const
+		{
+			OKAY_ASSERT(contains(handle));
+			return m_dense[m_slots[handle.slotIdx].denseIdx];
+		}
+
+		// Dense indices change when elements are removed, only hold on to them while nothing is removed
+		uint32_t getDenseIdx(SlotHandle handle) const
+		{
+			return contains(handle) ? m_slots[handle.slotIdx].denseIdx : INVALID_UINT32;
+		}
+
+		SlotHandle getHandle(uint32_t denseIdx) const
+		{
+			OKAY_ASSERT(denseIdx < (uint32_t)m_dense.size());
+
+			uint32_t slotIdx = m_denseToSlot[denseIdx];
+			return SlotHandle{ slotIdx, m_slots[slotIdx].generation };
+		}
+
+		T& operator[](uint32_t denseIdx)
+		{
+			return m_dense[denseIdx];
+		}
+
+		const T& operator[](uint32_t denseIdx) const
+		{
+			return m_dense[denseIdx];
+		}
+
+		uint32_t size() const
+		{
+			return (uint32_t)m_dense.size();
+		}
+
+		bool empty() const
+		{
+			return m_dense.empty();
+		}
+
+		typename std::vector<T>::iterator begin()
+		{
+			return m_dense.begin();
+		}
+
+		typename std::vector<T>::iterator end()
+		{
+			return m_dense.end();
+		}
+
+		typename std::vector<T>::const_iterator begin() const
+		{
+			return m_dense.begin();
+		}
+
+		typename std::vector<T>::const_iterator end() const
+		{
+			return m_dense.end();
+		}
+
+	private:
+		struct Slot
+		{
+			uint32_t denseIdx = INVALID_UINT32;
+			uint32_t generation = 0;
+		};
+
+		std::vector<T> m_dense;
+		std::vector<uint32_t> m_denseToSlot;
+		std::vector<Slot> m_slots;
+		std::vector<uint32_t> m_freeSlots;
+
+	};
+}
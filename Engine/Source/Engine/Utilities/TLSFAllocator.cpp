@@ -0,0 +1,380 @@
+#include "TLSFAllocator.h"
+
+#include <bit>
+
+namespace Okay
+{
+	void TLSFAllocator::initialize(uint64_t size)
+	{
+		m_size = size;
+		clear();
+	}
+
+	void TLSFAllocator::shutdown()
+	{
+		m_blocks.clear();
+		m_blocks.shrink_to_fit();
+		m_unusedBlocks.clear();
+		m_unusedBlocks.shrink_to_fit();
+	}
+
+	void TLSFAllocator::clear()
+	{
+		m_blocks.clear();
+		m_unusedBlocks.clear();
+
+		m_firstLevelBitmap = 0;
+		for (uint32_t fl = 0; fl < NUM_FIRST_LEVELS; fl++)
+		{
+			m_secondLevelBitmaps[fl] = 0;
+			for (uint32_t sl = 0; sl < NUM_SECOND_LEVELS; sl++)
+				m_freeHeads[fl][sl] = INVALID_UINT32;
+		}
+
+		m_lastPhysical = INVALID_UINT32;
+		m_totalFreeSize = 0;
+		m_numAllocations = 0;
+
+		uint64_t size = m_size;
+		m_size = 0;
+		grow(size);
+	}
+
+	void TLSFAllocator::grow(uint64_t newSize)
+	{
+		OKAY_ASSERT(newSize >= m_size);
+		if (newSize == m_size)
+			return;
+
+		uint64_t addedSize = newSize - m_size;
+
+		if (m_lastPhysical != INVALID_UINT32 && m_blocks[m_lastPhysical].free)
+		{
+			uint32_t lastBlock = m_lastPhysical;
+			removeFreeBlock(lastBlock);
+			m_blocks[lastBlock].size += addedSize;
+			insertFreeBlock(lastBlock);
+		}
+		else
+		{
+			uint32_t newBlock = createBlock(m_size, addedSize);
+			m_blocks[newBlock].prevPhysical = m_lastPhysical;
+
+			if (m_lastPhysical != INVALID_UINT32)
+				m_blocks[m_lastPhysical].nextPhysical = newBlock;
+
+			m_lastPhysical = newBlock;
+			insertFreeBlock(newBlock);
+		}
+
+		m_size = newSize;
+	}
+
+	uint32_t TLSFAllocator::findFreeBlock(uint64_t size, uint64_t alignment) const
+	{
+		OKAY_ASSERT(size > 0 && alignment > 0);
+
+		uint64_t searchSize = size + alignment - 1;
+
+		uint32_t firstLevel = 0, secondLevel = 0;
+		mapSearch(searchSize, &firstLevel, &secondLevel);
+
+		// Any block in the found list is big enough, so there is no need to look at the blocks themselves
+		if (firstLevel < NUM_FIRST_LEVELS)
+		{
+			uint32_t secondLevelMap = m_secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+			if (!secondLevelMap)
+			{
+				uint64_t firstLevelMap = firstLevel + 1 < 64 ? m_firstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+				firstLevel = firstLevelMap ? (uint32_t)std::countr_zero(firstLevelMap) : NUM_FIRST_LEVELS;
+				secondLevelMap = firstLevelMap ? m_secondLevelBitmaps[firstLevel] : 0;
+			}
+
+			if (secondLevelMap)
+			{
+				secondLevel = (uint32_t)std::countr_zero(secondLevelMap);
+				return m_freeHeads[firstLevel][secondLevel];
+			}
+		}
+
+		// The rounding skips the list the size itself maps to, which can still hold a big enough block.
+		// Only searched when nothing else fits (like when the arena is almost full), so the O(n) walk is rare
+		mapInsert(searchSize, &firstLevel, &secondLevel);
+		for (uint32_t blockIdx = m_freeHeads[firstLevel][secondLevel]; blockIdx != INVALID_UINT32; blockIdx = m_blocks[blockIdx].nextFree)
+		{
+			const Block& block = m_blocks[blockIdx];
+			uint64_t padding = (alignment - block.offset % alignment) % alignment;
+			if (block.size >= size + padding)
+				return blockIdx;
+		}
+
+		return INVALID_UINT32;
+	}
+
+	uint32_t TLSFAllocator::claimFreeBlock(uint32_t freeBlockHandle, uint64_t size, uint64_t alignment, uint64_t* pOutOffset)
+	{
+		OKAY_ASSERT(freeBlockHandle < m_blocks.size() && m_blocks[freeBlockHandle].free);
+
+		uint32_t blockIdx = freeBlockHandle;
+		removeFreeBlock(blockIdx);
+
+		uint64_t alignedOffset = (m_blocks[blockIdx].offset + alignment - 1) / alignment * alignment;
+		uint64_t padding = alignedOffset - m_blocks[blockIdx].offset;
+		OKAY_ASSERT(padding + size <= m_blocks[blockIdx].size);
+
+		// The padding stays free, the neighbours of a free block are never free so it doesn't need merging
+		if (padding)
+		{
+			uint32_t alignedBlock = splitBlock(blockIdx, padding);
+			insertFreeBlock(blockIdx);
+			blockIdx = alignedBlock;
+		}
+
+		if (m_blocks[blockIdx].size > size)
+		{
+			uint32_t remainingBlock = splitBlock(blockIdx, size);
+			insertFreeBlock(remainingBlock);
+		}
+
+		m_numAllocations++;
+
+		if (pOutOffset)
+			*pOutOffset = m_blocks[blockIdx].offset;
+
+		return blockIdx;
+	}
+
+	uint32_t TLSFAllocator::allocate(uint64_t size, uint64_t alignment, uint64_t* pOutOffset)
+	{
+		uint32_t freeBlock = findFreeBlock(size, alignment);
+		if (freeBlock == INVALID_UINT32)
+			return INVALID_UINT32;
+
+		return claimFreeBlock(freeBlock, size, alignment, pOutOffset);
+	}
+
+	void TLSFAllocator::free(uint32_t allocationHandle)
+	{
+		OKAY_ASSERT(allocationHandle < m_blocks.size() && m_blocks[allocationHandle].inUse && !m_blocks[allocationHandle].free);
+
+		uint32_t blockIdx = allocationHandle;
+		m_numAllocations--;
+
+		uint32_t nextBlock = m_blocks[blockIdx].nextPhysical;
+		if (nextBlock != INVALID_UINT32 && m_blocks[nextBlock].free)
+		{
+			removeFreeBlock(nextBlock);
+			mergeWithNext(blockIdx);
+		}
+
+		uint32_t prevBlock = m_blocks[blockIdx].prevPhysical;
+		if (prevBlock != INVALID_UINT32 && m_blocks[prevBlock].free)
+		{
+			removeFreeBlock(prevBlock);
+			blockIdx = mergeWithNext(prevBlock);
+		}
+
+		insertFreeBlock(blockIdx);
+	}
+
+	uint64_t TLSFAllocator::getOffset(uint32_t allocationHandle) const
+	{
+		OKAY_ASSERT(allocationHandle < m_blocks.size() && m_blocks[allocationHandle].inUse);
+		return m_blocks[allocationHandle].offset;
+	}
+
+	uint64_t TLSFAllocator::getAllocationSize(uint32_t allocationHandle) const
+	{
+		OKAY_ASSERT(allocationHandle < m_blocks.size() && m_blocks[allocationHandle].inUse);
+		return m_blocks[allocationHandle].size;
+	}
+
+	uint64_t TLSFAllocator::getSize() const
+	{
+		return m_size;
+	}
+
+	uint64_t TLSFAllocator::getTotalFreeSize() const
+	{
+		return m_totalFreeSize;
+	}
+
+	uint64_t TLSFAllocator::getLargestFreeBlockSize() const
+	{
+		if (!m_firstLevelBitmap)
+			return 0;
+
+		// The highest non-empty list holds the largest block, but the blocks within it have different sizes
+		uint32_t firstLevel = (uint32_t)std::bit_width(m_firstLevelBitmap) - 1;
+		uint32_t secondLevel = (uint32_t)std::bit_width(m_secondLevelBitmaps[firstLevel]) - 1;
+
+		uint64_t largestSize = 0;
+		for (uint32_t blockIdx = m_freeHeads[firstLevel][secondLevel]; blockIdx != INVALID_UINT32; blockIdx = m_blocks[blockIdx].nextFree)
+			largestSize = glm::max(largestSize, m_blocks[blockIdx].size);
+
+		return largestSize;
+	}
+
+	uint32_t TLSFAllocator::getNumAllocations() const
+	{
+		return m_numAllocations;
+	}
+
+	void TLSFAllocator::mapInsert(uint64_t size, uint32_t* pOutFirstLevel, uint32_t* pOutSecondLevel)
+	{
+		// Small sizes get a linear mapping in the first level, every other first level covers one power of two
+		if (size < NUM_SECOND_LEVELS)
+		{
+			*pOutFirstLevel = 0;
+			*pOutSecondLevel = (uint32_t)size;
+			return;
+		}
+
+		uint32_t log2Size = (uint32_t)std::bit_width(size) - 1;
+		*pOutFirstLevel = log2Size - SECOND_LEVEL_BITS + 1;
+		*pOutSecondLevel = (uint32_t)(size >> (log2Size - SECOND_LEVEL_BITS)) - NUM_SECOND_LEVELS;
+	}
+
+	void TLSFAllocator::mapSearch(uint64_t size, uint32_t* pOutFirstLevel, uint32_t* pOutSecondLevel)
+	{
+		// Rounding up to the next list so every block in the found list is big enough
+		if (size >= NUM_SECOND_LEVELS)
+		{
+			uint32_t log2Size = (uint32_t)std::bit_width(size) - 1;
+			uint64_t roundedSize = size + (1ull << (log2Size - SECOND_LEVEL_BITS)) - 1;
+
+			if (roundedSize < size) // Overflowed
+			{
+				*pOutFirstLevel = NUM_FIRST_LEVELS;
+				*pOutSecondLevel = 0;
+				return;
+			}
+
+			size = roundedSize;
+		}
+
+		mapInsert(size, pOutFirstLevel, pOutSecondLevel);
+	}
+
+	uint32_t TLSFAllocator::createBlock(uint64_t offset, uint64_t size)
+	{
+		uint32_t blockIdx = INVALID_UINT32;
+		if (m_unusedBlocks.size())
+		{
+			blockIdx = m_unusedBlocks.back();
+			m_unusedBlocks.pop_back();
+		}
+		else
+		{
+			blockIdx = (uint32_t)m_blocks.size();
+			m_blocks.emplace_back();
+		}
+
+		Block& block = m_blocks[blockIdx];
+		block = Block();
+		block.offset = offset;
+		block.size = size;
+		block.inUse = true;
+
+		return blockIdx;
+	}
+
+	void TLSFAllocator::destroyBlock(uint32_t blockIdx)
+	{
+		m_blocks[blockIdx].inUse = false;
+		m_blocks[blockIdx].free = false;
+		m_unusedBlocks.emplace_back(blockIdx);
+	}
+
+	void TLSFAllocator::insertFreeBlock(uint32_t blockIdx)
+	{
+		Block& block = m_blocks[blockIdx];
+
+		uint32_t firstLevel = 0, secondLevel = 0;
+		mapInsert(block.size, &firstLevel, &secondLevel);
+
+		uint32_t& listHead = m_freeHeads[firstLevel][secondLevel];
+		block.free = true;
+		block.prevFree = INVALID_UINT32;
+		block.nextFree = listHead;
+
+		if (listHead != INVALID_UINT32)
+			m_blocks[listHead].prevFree = blockIdx;
+
+		listHead = blockIdx;
+
+		m_firstLevelBitmap |= 1ull << firstLevel;
+		m_secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+		m_totalFreeSize += block.size;
+	}
+
+	void TLSFAllocator::removeFreeBlock(uint32_t blockIdx)
+	{
+		Block& block = m_blocks[blockIdx];
+		OKAY_ASSERT(block.free);
+
+		uint32_t firstLevel = 0, secondLevel = 0;
+		mapInsert(block.size, &firstLevel, &secondLevel);
+
+		if (block.prevFree != INVALID_UINT32)
+			m_blocks[block.prevFree].nextFree = block.nextFree;
+
+		if (block.nextFree != INVALID_UINT32)
+			m_blocks[block.nextFree].prevFree = block.prevFree;
+
+		uint32_t& listHead = m_freeHeads[firstLevel][secondLevel];
+		if (listHead == blockIdx)
+			listHead = block.nextFree;
+
+		if (listHead == INVALID_UINT32)
+		{
+			m_secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+			if (!m_secondLevelBitmaps[firstLevel])
+				m_firstLevelBitmap &= ~(1ull << firstLevel);
+		}
+
+		block.free = false;
+		block.prevFree = INVALID_UINT32;
+		block.nextFree = INVALID_UINT32;
+		m_totalFreeSize -= block.size;
+	}
+
+	uint32_t TLSFAllocator::splitBlock(uint32_t blockIdx, uint64_t size)
+	{
+		OKAY_ASSERT(size < m_blocks[blockIdx].size);
+
+		// createBlock can reallocate m_blocks, so no references are held over the call
+		uint32_t newBlock = createBlock(m_blocks[blockIdx].offset + size, m_blocks[blockIdx].size - size);
+		m_blocks[blockIdx].size = size;
+
+		uint32_t nextBlock = m_blocks[blockIdx].nextPhysical;
+		m_blocks[newBlock].prevPhysical = blockIdx;
+		m_blocks[newBlock].nextPhysical = nextBlock;
+		m_blocks[blockIdx].nextPhysical = newBlock;
+
+		if (nextBlock != INVALID_UINT32)
+			m_blocks[nextBlock].prevPhysical = newBlock;
+		else
+			m_lastPhysical = newBlock;
+
+		return newBlock;
+	}
+
+	uint32_t TLSFAllocator::mergeWithNext(uint32_t blockIdx)
+	{
+		uint32_t nextBlock = m_blocks[blockIdx].nextPhysical;
+		OKAY_ASSERT(nextBlock != INVALID_UINT32);
+
+		uint32_t nextNextBlock = m_blocks[nextBlock].nextPhysical;
+		m_blocks[blockIdx].size += m_blocks[nextBlock].size;
+		m_blocks[blockIdx].nextPhysical = nextNextBlock;
+
+		if (nextNextBlock != INVALID_UINT32)
+			m_blocks[nextNextBlock].prevPhysical = blockIdx;
+		else
+			m_lastPhysical = blockIdx;
+
+		destroyBlock(nextBlock);
+		return blockIdx;
+	}
+}
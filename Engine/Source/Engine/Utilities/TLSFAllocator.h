@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+namespace Okay
+{
+	/*
+		Two-Level Segregated Fit allocator, only does the offset bookkeeping so it can manage any linear memory (like a GPU buffer).
+		Allocating & freeing are O(1) and adjacent free blocks are always merged.
+
+		Source:
+		http://www.gii.upv.es/tlsf/files/papers/ecrts04_tlsf.pdf
+	*/
+
+	class TLSFAllocator
+	{
+	public:
+		static const uint32_t SECOND_LEVEL_BITS = 4;
+		static const uint32_t NUM_SECOND_LEVELS = 1 << SECOND_LEVEL_BITS;
+		static const uint32_t NUM_FIRST_LEVELS = 64 - SECOND_LEVEL_BITS + 1;
+
+	public:
+		TLSFAllocator() = default;
+		~TLSFAllocator() = default;
+
+		void initialize(uint64_t size);
+		void shutdown();
+
+		// Frees all allocations, handles from before the call are invalid after
+		void clear();
+
+		// Adds [currentSize, newSize) as free memory, merging it with the last block if it's free
+		void grow(uint64_t newSize);
+
+		// Returns the handle of a free block that can hold the allocation, or INVALID_UINT32 if there is none
+		uint32_t findFreeBlock(uint64_t size, uint64_t alignment = 1) const;
+
+		// Allocates from a block returned by findFreeBlock (using the same size & alignment), returns the allocation handle
+		uint32_t claimFreeBlock(uint32_t freeBlockHandle, uint64_t size, uint64_t alignment, uint64_t* pOutOffset);
+
+		// Returns INVALID_UINT32 if there is not enough contiguous free memory
+		uint32_t allocate(uint64_t size, uint64_t alignment, uint64_t* pOutOffset);
+		void free(uint32_t allocationHandle);
+
+		// Works for both allocations & free blocks returned by findFreeBlock
+		uint64_t getOffset(uint32_t allocationHandle) const;
+		uint64_t getAllocationSize(uint32_t allocationHandle) const;
+
+		uint64_t getSize() const;
+		uint64_t getTotalFreeSize() const;
+		uint64_t getLargestFreeBlockSize() const;
+		uint32_t getNumAllocations() const;
+
+	private:
+		struct Block
+		{
+			uint64_t offset = 0;
+			uint64_t size = 0;
+
+			uint32_t prevPhysical = INVALID_UINT32;
+			uint32_t nextPhysical = INVALID_UINT32;
+
+			uint32_t prevFree = INVALID_UINT32;
+			uint32_t nextFree = INVALID_UINT32;
+
+			bool free = false;
+			bool inUse = false; // False when the block is in the unused pool
+		};
+
+		static void mapInsert(uint64_t size, uint32_t* pOutFirstLevel, uint32_t* pOutSecondLevel);
+		static void mapSearch(uint64_t size, uint32_t* pOutFirstLevel, uint32_t* pOutSecondLevel);
+
+		uint32_t createBlock(uint64_t offset, uint64_t size);
+		void destroyBlock(uint32_t blockIdx);
+
+		void insertFreeBlock(uint32_t blockIdx);
+		void removeFreeBlock(uint32_t blockIdx);
+
+		// Splits the block so it's 'size' big, the remainder is returned as a new free block (INVALID_UINT32 if there was none)
+		uint32_t splitBlock(uint32_t blockIdx, uint64_t size);
+		uint32_t mergeWithNext(uint32_t blockIdx);
+
+	private:
+		std::vector<Block> m_blocks;
+		std::vector<uint32_t> m_unusedBlocks;
+
+		uint64_t m_firstLevelBitmap = 0;
+		uint32_t m_secondLevelBitmaps[NUM_FIRST_LEVELS] = {};
+		uint32_t m_freeHeads[NUM_FIRST_LEVELS][NUM_SECOND_LEVELS] = {};
+
+		uint32_t m_lastPhysical = INVALID_UINT32;
+		uint64_t m_size = 0;
+		uint64_t m_totalFreeSize = 0;
+		uint32_t m_numAllocations = 0;
+
+	};
+}
@@ -0,0 +1,109 @@
+#include "UploadScheduler.h"
+
+#include <algorithm>
+
+namespace Okay
+{
+	void UploadScheduler::push(uint64_t key, uint64_t numBytes)
+	{
+		auto keyIterator = m_keyToPendingIdx.find(key);
+		if (keyIterator != m_keyToPendingIdx.end())
+		{
+			PendingUpload& upload = m_pending[keyIterator->second];
+			m_numPendingBytes = m_numPendingBytes - upload.numBytes + numBytes;
+			upload.numBytes = numBytes;
+			return;
+		}
+
+		m_keyToPendingIdx[key] = (uint32_t)m_pending.size();
+
+		PendingUpload& upload = m_pending.emplace_back();
+		upload.key = key;
+		upload.numBytes = numBytes;
+
+		m_numPendingBytes += numBytes;
+	}
+
+	void UploadScheduler::remove(uint64_t key)
+	{
+		auto keyIterator = m_keyToPendingIdx.find(key);
+		if (keyIterator == m_keyToPendingIdx.end())
+			return;
+
+		uint32_t pendingIdx = keyIterator->second;
+		m_numPendingBytes -= m_pending[pendingIdx].numBytes;
+		m_keyToPendingIdx.erase(keyIterator);
+
+		// Swap & pop, the moved upload needs its index updated
+		if (pendingIdx != (uint32_t)m_pending.size() - 1)
+		{
+			m_pending[pendingIdx] = m_pending.back();
+			m_keyToPendingIdx[m_pending[pendingIdx].key] = pendingIdx;
+		}
+
+		m_pending.pop_back();
+	}
+
+	void UploadScheduler::clear()
+	{
+		m_pending.clear();
+		m_keyToPendingIdx.clear();
+
+		m_numPendingBytes = 0;
+		m_numScheduledBytes = 0;
+	}
+
+	bool UploadScheduler::isQueued(uint64_t key) const
+	{
+		return m_keyToPendingIdx.contains(key);
+	}
+
+	void UploadScheduler::schedule(uint64_t byteBudget, const std::function<float(uint64_t key)>& getPriority, std::vector<uint64_t>& outKeys)
+	{
+		m_numScheduledBytes = 0;
+
+		if (m_pending.empty())
+			return;
+
+		for (PendingUpload& upload : m_pending)
+			upload.priority = getPriority(upload.key);
+
+		std::sort(m_pending.begin(), m_pending.end(), [](const PendingUpload& a, const PendingUpload& b)
+			{
+				return a.priority < b.priority;
+			});
+
+		uint32_t numScheduled = 0;
+		for (const PendingUpload& upload : m_pending)
+		{
+			if (numScheduled && byteBudget && m_numScheduledBytes + upload.numBytes > byteBudget)
+				break;
+
+			outKeys.emplace_back(upload.key);
+			m_numScheduledBytes += upload.numBytes;
+			numScheduled++;
+		}
+
+		m_pending.erase(m_pending.begin(), m_pending.begin() + numScheduled);
+		m_numPendingBytes -= m_numScheduledBytes;
+
+		m_keyToPendingIdx.clear();
+		for (uint32_t i = 0; i < (uint32_t)m_pending.size(); i++)
+			m_keyToPendingIdx[m_pending[i].key] = i;
+	}
+
+	uint32_t UploadScheduler::getNumPending() const
+	{
+		return (uint32_t)m_pending.size();
+	}
+
+	uint64_t UploadScheduler::getNumPendingBytes() const
+	{
+		return m_numPendingBytes;
+	}
+
+	uint64_t UploadScheduler::getNumScheduledBytes() const
+	{
+		return m_numScheduledBytes;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+namespace Okay
+{
+	struct PendingUpload
+	{
+		uint64_t key = INVALID_UINT64;
+		uint64_t numBytes = 0;
+		float priority = 0.f;
+	};
+
+	// Queues uploads by key and hands out as many as fit within a byte budget each frame, most important first.
+	// Doesn't know anything about the GPU, the keys are only passed back to the caller who does the actual uploading
+	class UploadScheduler
+	{
+	public:
+		UploadScheduler() = default;
+		~UploadScheduler() = default;
+
+		// Updates the size if the key is already queued
+		void push(uint64_t key, uint64_t numBytes);
+		void remove(uint64_t key);
+		void clear();
+
+		bool isQueued(uint64_t key) const;
+
+		// Lower priority values are scheduled first, getPriority is called once per queued upload.
+		// Stops at the first upload that doesn't fit so big uploads can't be starved by smaller ones,
+		// but always schedules at least one upload. A byteBudget of 0 means no limit
+		void schedule(uint64_t byteBudget, const std::function<float(uint64_t key)>& getPriority, std::vector<uint64_t>& outKeys);
+
+		uint32_t getNumPending() const;
+		uint64_t getNumPendingBytes() const;
+		uint64_t getNumScheduledBytes() const; // From the last schedule call
+
+	private:
+		std::vector<PendingUpload> m_pending;
+		std::unordered_map<uint64_t, uint32_t> m_keyToPendingIdx;
+
+		uint64_t m_numPendingBytes = 0;
+		uint64_t m_numScheduledBytes = 0;
+
+	};
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include "Chunk.h"
+
+#include <bit>
+#include <vector>
+
+namespace Okay
+{
+	/*
+		Maps ChunkIDs to values for the chunks around the camera without allocating per chunk.
+		Values are stored densely (removing swaps the last one into the hole), lookups go through two flat tables:
+		- A toroidal grid, chunk (x, z) uses cell (x mod width, z mod width). Chunks in a window narrower than the grid never share a cell,
+		  so finding one is a single array read
+		- An open addressing hash table with linear probing for chunks whose cell was already taken, normally empty
+
+		Dense indices change when values are removed, iterate with getID() & getValue() and don't advance after removing the current one.
+		Not thread safe, same rules as the std::unordered_map it replaced
+	*/
+
+	template<typename T>
+	class ChunkIndex
+	{
+	public:
+		ChunkIndex() = default;
+		~ChunkIndex() = default;
+
+		// Rounded up to a power of two, chunks further apart than this can end up in the fallback table. Re-inserts everything
+		void setWindowWidth(uint32_t width)
+		{
+			width = std::bit_ceil(glm::max(width, 1u));
+			if (width == m_windowWidth)
+				return;
+
+			m_windowWidth = width;
+			m_cells.assign((size_t)width * width, Entry());
+			m_fallback.assign(m_fallback.size(), Entry());
+			m_numFallback = 0;
+
+			for (uint32_t i = 0; i < (uint32_t)m_ids.size(); i++)
+				addEntry(m_ids[i], i);
+		}
+
+		uint32_t getWindowWidth() const
+		{
+			return m_windowWidth;
+		}
+
+		// Returns the existing value if the chunk is already in the index
+		T& getOrInsert(ChunkID chunkID)
+		{
+			uint32_t denseIdx = findDenseIdx(chunkID);
+			if (denseIdx != INVALID_UINT32)
+				return m_values[denseIdx];
+
+			denseIdx = (uint32_t)m_values.size();
+			m_values.emplace_back();
+			m_ids.emplace_back(chunkID);
+			addEntry(chunkID, denseIdx);
+
+			return m_values[denseIdx];
+		}
+
+		// Returns false if the chunk wasn't in the index
+		bool remove(ChunkID chunkID)
+		{
+			Entry* pEntry = findEntry(chunkID);
+			if (!pEntry)
+				return false;
+
+			uint32_t denseIdx = pEntry->denseIdx;
+			removeEntry(pEntry);
+
+			uint32_t lastDenseIdx = (uint32_t)m_values.size() - 1;
+			if (denseIdx != lastDenseIdx)
+			{
+				m_values[denseIdx] = std::move(m_values[lastDenseIdx]);
+				m_ids[denseIdx] = m_ids[lastDenseIdx];
+				findEntry(m_ids[denseIdx])->denseIdx = denseIdx;
+			}
+
+			m_values.pop_back();
+			m_ids.pop_back();
+
+			return true;
+		}
+
+		void clear()
+		{
+			m_values.clear();
+			m_ids.clear();
+			m_cells.assign(m_cells.size(), Entry());
+			m_fallback.assign(m_fallback.size(), Entry());
+			m_numFallback = 0;
+		}
+
+		bool contains(ChunkID chunkID) const
+		{
+			return findDenseIdx(chunkID) != INVALID_UINT32;
+		}
+
+		T* tryGet(ChunkID chunkID)
+		{
+			uint32_t denseIdx = findDenseIdx(chunkID);
+			return denseIdx != INVALID_UINT32 ? &m_values[denseIdx] : nullptr;
+		}
+
+		const T* tryGet(ChunkID chunkID) const
+		{
+			uint32_t denseIdx = findDenseIdx(chunkID);
+			return denseIdx != INVALID_UINT32 ? &m_values[denseIdx] : nullptr;
+		}
+
+		T& get(ChunkID chunkID)
+		{
+			uint32_t denseIdx = findDenseIdx(chunkID);
+			OKAY_ASSERT(denseIdx != INVALID_UINT32);
+			return m_values[denseIdx];
+		}
+
+		const T& get(ChunkID chunkID) const
+		{
+			uint32_t denseIdx = findDenseIdx(chunkID);
+			OKAY_ASSERT(denseIdx != INVALID_UINT32);
+			return m_values[denseIdx];
+		}
+
+		ChunkID getID(uint32_t denseIdx) const
+		{
+			OKAY_ASSERT(denseIdx < (uint32_t)m_ids.size());
+			return m_ids[denseIdx];
+		}
+
+		T& getValue(uint32_t denseIdx)
+		{
+			OKAY_ASSERT(denseIdx < (uint32_t)m_values.size());
+			return m_values[denseIdx];
+		}
+
+		const T& getValue(uint32_t denseIdx) const
+		{
+			OKAY_ASSERT(denseIdx < (uint32_t)m_values.size());
+			return m_values[denseIdx];
+		}
+
+		uint32_t size() const
+		{
+			return (uint32_t)m_values.size();
+		}
+
+		bool empty() const
+		{
+			return m_values.empty();
+		}
+
+		// Chunks that didn't get a cell of their own, a lot of these means the window is too narrow
+		uint32_t getNumFallbackEntries() const
+		{
+			return m_numFallback;
+		}
+
+	private:
+		struct Entry
+		{
+			ChunkID chunkID = INVALID_CHUNK_ID;
+			uint32_t denseIdx = INVALID_UINT32;
+		};
+
+		uint32_t findDenseIdx(ChunkID chunkID) const
+		{
+			const Entry* pEntry = const_cast<ChunkIndex*>(this)->findEntry(chunkID);
+			return pEntry ? pEntry->denseIdx : INVALID_UINT32;
+		}
+
+		Entry* findEntry(ChunkID chunkID)
+		{
+			if (!m_cells.empty())
+			{
+				Entry& cell = m_cells[getCellIdx(chunkID)];
+				if (cell.chunkID == chunkID)
+					return &cell;
+			}
+
+			if (!m_numFallback)
+				return nullptr;
+
+			uint32_t mask = (uint32_t)m_fallback.size() - 1;
+			for (uint32_t slotIdx = getFallbackSlot(chunkID); m_fallback[slotIdx].chunkID != INVALID_CHUNK_ID; slotIdx = (slotIdx + 1) & mask)
+			{
+				if (m_fallback[slotIdx].chunkID == chunkID)
+					return &m_fallback[slotIdx];
+			}
+
+			return nullptr;
+		}
+
+		void addEntry(ChunkID chunkID, uint32_t denseIdx)
+		{
+			if (!m_cells.empty())
+			{
+				Entry& cell = m_cells[getCellIdx(chunkID)];
+				if (cell.chunkID == INVALID_CHUNK_ID)
+				{
+					cell.chunkID = chunkID;
+					cell.denseIdx = denseIdx;
+					return;
+				}
+			}
+
+			// Kept at most half full so probing stays short
+			if ((m_numFallback + 1) * 2 > (uint32_t)m_fallback.size())
+				growFallback();
+
+			uint32_t mask = (uint32_t)m_fallback.size() - 1;
+			uint32_t slotIdx = getFallbackSlot(chunkID);
+			while (m_fallback[slotIdx].chunkID != INVALID_CHUNK_ID)
+				slotIdx = (slotIdx + 1) & mask;
+
+			m_fallback[slotIdx].chunkID = chunkID;
+			m_fallback[slotIdx].denseIdx = denseIdx;
+			m_numFallback++;
+		}
+
+		void removeEntry(Entry* pEntry)
+		{
+			if (pEntry < m_fallback.data() || pEntry >= m_fallback.data() + m_fallback.size())
+			{
+				*pEntry = Entry();
+				return;
+			}
+
+			// Backward shift deletion, moves later entries of the probe sequence into the hole so lookups never stop early
+			uint32_t mask = (uint32_t)m_fallback.size() - 1;
+			uint32_t holeIdx = (uint32_t)(pEntry - m_fallback.data());
+			uint32_t slotIdx = (holeIdx + 1) & mask;
+
+			while (m_fallback[slotIdx].chunkID != INVALID_CHUNK_ID)
+			{
+				uint32_t homeIdx = getFallbackSlot(m_fallback[slotIdx].chunkID);
+
+				// Only entries whose home isn't cyclically within (hole, slot] can move back
+				if (((slotIdx - homeIdx) & mask) >= ((slotIdx - holeIdx) & mask))
+				{
+					m_fallback[holeIdx] = m_fallback[slotIdx];
+					holeIdx = slotIdx;
+				}
+
+				slotIdx = (slotIdx + 1) & mask;
+			}
+
+			m_fallback[holeIdx] = Entry();
+			m_numFallback--;
+		}
+
+		void growFallback()
+		{
+			std::vector<Entry> oldFallback = std::move(m_fallback);
+			m_fallback.assign(glm::max((uint32_t)oldFallback.size() * 2, 16u), Entry());
+
+			uint32_t mask = (uint32_t)m_fallback.size() - 1;
+			for (const Entry& entry : oldFallback)
+			{
+				if (entry.chunkID == INVALID_CHUNK_ID)
+					continue;
+
+				uint32_t slotIdx = getFallbackSlot(entry.chunkID);
+				while (m_fallback[slotIdx].chunkID != INVALID_CHUNK_ID)
+					slotIdx = (slotIdx + 1) & mask;
+
+				m_fallback[slotIdx] = entry;
+			}
+		}
+
+		uint32_t getCellIdx(ChunkID chunkID) const
+		{
+			// Same split as chunkIDToChunkCoord, the world middle offset only shifts which cell a chunk gets
+			uint32_t mask = m_windowWidth - 1;
+			uint32_t cellX = uint32_t(chunkID % WORLD_CHUNK_WIDTH) & mask;
+			uint32_t cellZ = uint32_t(chunkID / WORLD_CHUNK_WIDTH) & mask;
+
+			return cellX + cellZ * m_windowWidth;
+		}
+
+		uint32_t getFallbackSlot(ChunkID chunkID) const
+		{
+			// Fibonacci hashing, neighbouring IDs end up far apart
+			uint32_t numBits = (uint32_t)std::countr_zero(m_fallback.size());
+			return numBits ? uint32_t((chunkID * 0x9E3779B97F4A7C15ull) >> (64 - numBits)) : 0;
+		}
+
+		std::vector<T> m_values;
+		std::vector<ChunkID> m_ids;
+
+		uint32_t m_windowWidth = 0;
+		std::vector<Entry> m_cells;
+
+		std::vector<Entry> m_fallback;
+		uint32_t m_numFallback = 0;
+
+	};
+}
@@ -0,0 +1,67 @@
+#include "ChunkPool.h"
+
+namespace Okay
+{
+	void ChunkPool::reserve(uint32_t capacity)
+	{
+		while (getCapacity() < capacity)
+			addPage();
+	}
+
+	ChunkHandle ChunkPool::allocate()
+	{
+		if (m_freeHandles.empty())
+			addPage();
+
+		ChunkHandle handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+
+		return handle;
+	}
+
+	void ChunkPool::free(ChunkHandle handle)
+	{
+		OKAY_ASSERT(handle < getCapacity());
+		OKAY_ASSERT(m_freeHandles.size() < getCapacity());
+
+		m_freeHandles.emplace_back(handle);
+	}
+
+	Chunk& ChunkPool::get(ChunkHandle handle)
+	{
+		OKAY_ASSERT(handle < getCapacity());
+		return m_pages[handle / CHUNKS_PER_PAGE][handle % CHUNKS_PER_PAGE];
+	}
+
+	const Chunk& ChunkPool::get(ChunkHandle handle) const
+	{
+		OKAY_ASSERT(handle < getCapacity());
+		return m_pages[handle / CHUNKS_PER_PAGE][handle % CHUNKS_PER_PAGE];
+	}
+
+	uint32_t ChunkPool::getCapacity() const
+	{
+		return (uint32_t)m_pages.size() * CHUNKS_PER_PAGE;
+	}
+
+	uint32_t ChunkPool::getNumUsed() const
+	{
+		return getCapacity() - (uint32_t)m_freeHandles.size();
+	}
+
+	uint32_t ChunkPool::getNumPageAllocations() const
+	{
+		return m_numPageAllocations;
+	}
+
+	void ChunkPool::addPage()
+	{
+		ChunkHandle firstHandle = getCapacity();
+		m_pages.emplace_back(std::make_unique<Chunk[]>(CHUNKS_PER_PAGE));
+		m_numPageAllocations++;
+
+		// Reversed so the lowest handles are handed out first
+		for (uint32_t i = CHUNKS_PER_PAGE; i > 0; i--)
+			m_freeHandles.emplace_back(firstHandle + i - 1);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Chunk.h"
+
+#include <memory>
+#include <vector>
+
+namespace Okay
+{
+	typedef uint32_t ChunkHandle;
+	constexpr ChunkHandle INVALID_CHUNK_HANDLE = INVALID_UINT32;
+
+	/*
+		Recycles chunk storage so loading a chunk doesn't allocate or copy its 64 KiB of blocks.
+		Chunks live in pages that are never freed or moved, so a Chunk reference stays valid until its handle is freed
+		and generation threads can write into a chunk while more pages are being added.
+		A handle has exactly one owner at a time, generation hands it over to the loaded chunks when it finishes.
+		Not thread safe, only the thread owning the handles allocates & frees them
+	*/
+
+	class ChunkPool
+	{
+	public:
+		static const uint32_t CHUNKS_PER_PAGE = 64;
+
+	public:
+		ChunkPool() = default;
+		~ChunkPool() = default;
+
+		// Adds pages until there's room for capacity chunks, never shrinks
+		void reserve(uint32_t capacity);
+
+		// Adds a page if every chunk is in use, that only happens if reserve() underestimated
+		ChunkHandle allocate();
+		void free(ChunkHandle handle);
+
+		Chunk& get(ChunkHandle handle);
+		const Chunk& get(ChunkHandle handle) const;
+
+		uint32_t getCapacity() const;
+		uint32_t getNumUsed() const;
+		uint32_t getNumPageAllocations() const;
+
+	private:
+		void addPage();
+
+		std::vector<std::unique_ptr<Chunk[]>> m_pages;
+		std::vector<ChunkHandle> m_freeHandles;
+		uint32_t m_numPageAllocations = 0;
+
+	};
+}
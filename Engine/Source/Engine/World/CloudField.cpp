@@ -0,0 +1,393 @@
+#include "CloudField.h"
+#include "World.h"
+#include "Engine/Utilities/Random.h"
+#include "Engine/Utilities/ThreadPool.h"
+
+namespace Okay
+{
+	static const glm::ivec2 CLOUD_FACE_NEIGHBOURS[NUM_CLOUD_FACES] =
+	{
+		glm::ivec2(0, 0), glm::ivec2(0, 0), glm::ivec2(1, 0), glm::ivec2(-1, 0), glm::ivec2(0, 1), glm::ivec2(0, -1),
+	};
+
+	static int positiveModulo(int value, int divisor)
+	{
+		return ((value % divisor) + divisor) % divisor;
+	}
+
+	void CloudField::update(World& world, ThreadPool& threadPool, const glm::vec3& cameraPos)
+	{
+		const CloudGenerationData& genData = world.m_cloudGenData;
+
+		m_numCellsUpdated = 0;
+		m_dirtyRanges.clear();
+		m_quadDirtyRanges.clear();
+
+		// The front grid is frozen until the rebuild is swapped in, and the swap already uploads everything that frame
+		if (m_rebuilding)
+		{
+			updateRebuild(threadPool);
+			if (m_rebuilding || !m_dirtyRanges.empty())
+				return;
+		}
+
+		float viewDistance = (float)genData.chunkVisiblityDistance * CHUNK_WIDTH;
+		uint32_t gridWidth = (uint32_t)glm::ceil(viewDistance / genData.sampleDistance) * 2 + 1;
+		uint32_t cellCapacity = glm::max((uint32_t)glm::ceil(genData.height / genData.sampleDistance), 1u);
+
+		glm::vec2 cloudSpacePos = glm::vec2(cameraPos.x, cameraPos.z) - genData.globalDrift;
+		glm::ivec2 originCell = glm::ivec2(glm::floor(cloudSpacePos / genData.sampleDistance)) - (int)(gridWidth / 2);
+
+		const CloudGrid& front = m_grids[m_frontIdx];
+		bool fullUpdate = m_invalidated || front.originCell.x == INT_MAX || gridWidth != front.gridWidth || cellCapacity != front.cellCapacity ||
+			glm::abs(originCell.x - front.originCell.x) >= (int)gridWidth || glm::abs(originCell.y - front.originCell.y) >= (int)gridWidth;
+
+		if (fullUpdate)
+			startRebuild(threadPool, genData, originCell, gridWidth, cellCapacity);
+		else if (front.originCell != originCell)
+			updateFront(genData, originCell);
+	}
+
+	void CloudField::invalidate()
+	{
+		m_invalidated = true;
+	}
+
+	const std::vector<glm::vec3>& CloudField::getPoints() const
+	{
+		return m_grids[m_frontIdx].points;
+	}
+
+	const std::vector<uint32_t>& CloudField::getInstances() const
+	{
+		return m_instances;
+	}
+
+	const std::vector<CloudDirtyRange>& CloudField::getDirtyRanges() const
+	{
+		return m_dirtyRanges;
+	}
+
+	const std::vector<CloudQuad>& CloudField::getQuads() const
+	{
+		return m_grids[m_frontIdx].quads;
+	}
+
+	const std::vector<uint32_t>& CloudField::getQuadInstances() const
+	{
+		return m_quadInstances;
+	}
+
+	const std::vector<CloudDirtyRange>& CloudField::getQuadDirtyRanges() const
+	{
+		return m_quadDirtyRanges;
+	}
+
+	float CloudField::getVoxelSize() const
+	{
+		return m_grids[m_frontIdx].voxelSize;
+	}
+
+	uint32_t CloudField::getLayoutVersion() const
+	{
+		return m_layoutVersion;
+	}
+
+	uint32_t CloudField::getVersion() const
+	{
+		return m_version;
+	}
+
+	uint32_t CloudField::getNumCellsUpdated() const
+	{
+		return m_numCellsUpdated;
+	}
+
+	bool CloudField::isRebuilding() const
+	{
+		return m_rebuilding;
+	}
+
+	uint32_t CloudField::getStorageIdx(const CloudGrid& grid, const glm::ivec2& cellCoord)
+	{
+		return positiveModulo(cellCoord.x, grid.gridWidth) + positiveModulo(cellCoord.y, grid.gridWidth) * grid.gridWidth;
+	}
+
+	void CloudField::sampleCell(const CloudGenerationData& genData, CloudGrid& grid, const glm::ivec2& cellCoord)
+	{
+		float x = cellCoord.x * genData.sampleDistance;
+		float z = cellCoord.y * genData.sampleDistance;
+
+		float cloudNoise = Noise::samplePerlin2D_zeroOne(x, z, genData.cloudNoise);
+		float maskNoise = Noise::samplePerlin2D_zeroOne(x, z, genData.maskNoise);
+		float finalNoise = cloudNoise * maskNoise;
+
+		float cloudHeight = finalNoise * genData.height;
+
+		uint32_t storageIdx = getStorageIdx(grid, cellCoord);
+		glm::vec3* pCellPoints = grid.points.data() + (uint64_t)storageIdx * grid.cellCapacity;
+		uint32_t numPoints = 0;
+
+		float currentHeight = 0.f;
+		while (currentHeight < cloudHeight && numPoints < grid.cellCapacity)
+		{
+			uint32_t seed = uint32_t(finalNoise * UINT_MAX + currentHeight);
+
+			glm::vec3 placementOffset = glm::vec3(
+				Random::randomFloat(seed) * 2.f - 1.f,
+				(Random::randomFloat(seed) * 2.f - 1.f) * 0.5f,
+				Random::randomFloat(seed) * 2.f - 1.f);
+
+			placementOffset = glm::normalize(placementOffset) * genData.maxOffset * Random::randomFloat(seed);
+			glm::vec3 cloudPoint = glm::vec3(x, genData.spawnHeight + currentHeight, z);
+
+			pCellPoints[numPoints++] = cloudPoint + placementOffset;
+			currentHeight += genData.sampleDistance;
+		}
+
+		grid.cellNumPoints[storageIdx] = numPoints;
+	}
+
+	uint32_t CloudField::getNumLayers(const CloudGrid& grid, const glm::ivec2& cellCoord)
+	{
+		glm::ivec2 gridCoord = cellCoord - grid.originCell;
+		if (gridCoord.x < 0 || gridCoord.y < 0 || gridCoord.x >= (int)grid.gridWidth || gridCoord.y >= (int)grid.gridWidth)
+			return 0;
+
+		return grid.cellNumPoints[getStorageIdx(grid, cellCoord)];
+	}
+
+	void CloudField::meshCell(CloudGrid& grid, const glm::ivec2& cellCoord)
+	{
+		uint32_t storageIdx = getStorageIdx(grid, cellCoord);
+		uint32_t numLayers = grid.cellNumPoints[storageIdx];
+
+		CloudQuad* pQuads = grid.quads.data() + (uint64_t)storageIdx * NUM_CLOUD_FACES;
+		glm::vec3 basePos = glm::vec3(cellCoord.x * grid.voxelSize, grid.baseHeight, cellCoord.y * grid.voxelSize);
+
+		for (uint32_t face = 0; face < NUM_CLOUD_FACES; face++)
+		{
+			uint32_t firstLayer = 0;
+			uint32_t numFaceLayers = 0;
+
+			if (face == CLOUD_FACE_TOP || face == CLOUD_FACE_BOTTOM)
+			{
+				firstLayer = face == CLOUD_FACE_TOP ? glm::max(numLayers, 1u) - 1 : 0;
+				numFaceLayers = glm::min(numLayers, 1u);
+			}
+			else
+			{
+				// Everything up to the neighbour's height is hidden behind it
+				uint32_t neighbourLayers = getNumLayers(grid, cellCoord + CLOUD_FACE_NEIGHBOURS[face]);
+				firstLayer = glm::min(neighbourLayers, numLayers);
+				numFaceLayers = numLayers - firstLayer;
+			}
+
+			pQuads[face].basePos = basePos;
+			pQuads[face].faceAndLayers = face | (firstLayer << 3) | (numFaceLayers << 17);
+		}
+	}
+
+	void CloudField::mergeDirtyRanges(std::vector<CloudDirtyRange>& ranges)
+	{
+		if (ranges.empty())
+			return;
+
+		std::sort(ranges.begin(), ranges.end(), [](const CloudDirtyRange& a, const CloudDirtyRange& b)
+		{
+			return a.firstElement < b.firstElement;
+		});
+
+		// Remeshed cells can be listed more than once, so overlapping ranges are merged as well
+		uint32_t numMerged = 0;
+		for (uint32_t i = 1; i < (uint32_t)ranges.size(); i++)
+		{
+			CloudDirtyRange& merged = ranges[numMerged];
+			uint32_t mergedEnd = merged.firstElement + merged.numElements;
+
+			if (ranges[i].firstElement <= mergedEnd)
+				merged.numElements = glm::max(mergedEnd, ranges[i].firstElement + ranges[i].numElements) - merged.firstElement;
+			else
+				ranges[++numMerged] = ranges[i];
+		}
+
+		ranges.resize(numMerged + 1);
+	}
+
+	void CloudField::startRebuild(ThreadPool& threadPool, const CloudGenerationData& genData, const glm::ivec2& originCell, uint32_t gridWidth, uint32_t cellCapacity)
+	{
+		OKAY_ASSERT(m_sliceFinished.load());
+
+		CloudGrid& back = m_grids[m_frontIdx ^ 1];
+		back.originCell = originCell;
+		back.gridWidth = gridWidth;
+		back.cellCapacity = cellCapacity;
+		back.voxelSize = genData.sampleDistance;
+		back.baseHeight = (float)genData.spawnHeight;
+		back.points.assign((uint64_t)gridWidth * gridWidth * cellCapacity, glm::vec3(0.f));
+		back.cellNumPoints.assign((uint64_t)gridWidth * gridWidth, 0);
+		back.quads.assign((uint64_t)gridWidth * gridWidth * NUM_CLOUD_FACES, CloudQuad());
+
+		m_rebuildGenData = genData;
+		m_nextRebuildRow = 0;
+		m_rebuilding = true;
+		m_invalidated = false;
+
+		queueRebuildSlice(threadPool);
+	}
+
+	void CloudField::queueRebuildSlice(ThreadPool& threadPool)
+	{
+		CloudGrid& back = m_grids[m_frontIdx ^ 1];
+
+		uint32_t firstRow = m_nextRebuildRow;
+		uint32_t endRow = glm::min(firstRow + REBUILD_ROWS_PER_SLICE, back.gridWidth);
+		m_nextRebuildRow = endRow;
+
+		// Only the job touches the back grid & the settings copy until it flags that it's done
+		m_sliceFinished.store(false);
+		threadPool.queueJob([this, &back, firstRow, endRow]()
+		{
+			for (uint32_t z = firstRow; z < endRow; z++)
+			{
+				for (uint32_t x = 0; x < back.gridWidth; x++)
+					sampleCell(m_rebuildGenData, back, back.originCell + glm::ivec2(x, z));
+			}
+
+			// Every cell's neighbours are sampled once the last rows are
+			if (endRow == back.gridWidth)
+			{
+				for (uint32_t z = 0; z < back.gridWidth; z++)
+				{
+					for (uint32_t x = 0; x < back.gridWidth; x++)
+						meshCell(back, back.originCell + glm::ivec2(x, z));
+				}
+			}
+
+			m_sliceFinished.store(true, std::memory_order_release);
+		});
+
+		m_numCellsUpdated += (endRow - firstRow) * back.gridWidth;
+	}
+
+	void CloudField::updateRebuild(ThreadPool& threadPool)
+	{
+		if (!m_sliceFinished.load(std::memory_order_acquire))
+			return;
+
+		CloudGrid& back = m_grids[m_frontIdx ^ 1];
+
+		// Settings changed while rebuilding, what's done so far is already out of date
+		if (m_invalidated)
+		{
+			m_rebuilding = false;
+			return;
+		}
+
+		if (m_nextRebuildRow < back.gridWidth)
+		{
+			queueRebuildSlice(threadPool);
+			return;
+		}
+
+		const CloudGrid& front = m_grids[m_frontIdx];
+		if (back.points.size() != front.points.size() || back.quads.size() != front.quads.size())
+			m_layoutVersion++;
+
+		m_frontIdx ^= 1;
+		m_rebuilding = false;
+		rebuildInstances();
+
+		m_dirtyRanges.push_back({ 0, (uint32_t)back.points.size() });
+		m_quadDirtyRanges.push_back({ 0, (uint32_t)back.quads.size() });
+		m_version++;
+	}
+
+	void CloudField::updateFront(const CloudGenerationData& genData, const glm::ivec2& originCell)
+	{
+		CloudGrid& front = m_grids[m_frontIdx];
+		const glm::ivec2 oldOriginCell = front.originCell;
+		const int gridWidth = (int)front.gridWidth;
+
+		// Set first so the meshing sees the new window
+		front.originCell = originCell;
+		m_remeshCells.clear();
+
+		for (int z = originCell.y; z < originCell.y + gridWidth; z++)
+		{
+			bool rowCached = z >= oldOriginCell.y && z < oldOriginCell.y + gridWidth;
+
+			for (int x = originCell.x; x < originCell.x + gridWidth; x++)
+			{
+				// Cells still inside the previous window already hold the correct points
+				if (rowCached && x >= oldOriginCell.x && x < oldOriginCell.x + gridWidth)
+					continue;
+
+				sampleCell(genData, front, glm::ivec2(x, z));
+				m_dirtyRanges.push_back({ getStorageIdx(front, glm::ivec2(x, z)) * front.cellCapacity, front.cellCapacity });
+				m_numCellsUpdated++;
+
+				for (uint32_t face = 0; face < NUM_CLOUD_FACES; face++)
+					m_remeshCells.emplace_back(glm::ivec2(x, z) + CLOUD_FACE_NEIGHBOURS[face]);
+			}
+		}
+
+		// Cells that ended up on the edge lost the neighbours that scrolled out
+		for (int i = 0; i < gridWidth; i++)
+		{
+			glm::ivec2 edgeCells[4] =
+			{
+				originCell + glm::ivec2(gridWidth - 1, i), originCell + glm::ivec2(0, i),
+				originCell + glm::ivec2(i, gridWidth - 1), originCell + glm::ivec2(i, 0),
+			};
+
+			for (uint32_t side = 0; side < 4; side++)
+			{
+				glm::ivec2 oldNeighbourCoord = edgeCells[side] + CLOUD_FACE_NEIGHBOURS[CLOUD_FACE_POS_X + side] - oldOriginCell;
+				if (oldNeighbourCoord.x >= 0 && oldNeighbourCoord.y >= 0 && oldNeighbourCoord.x < gridWidth && oldNeighbourCoord.y < gridWidth)
+					m_remeshCells.emplace_back(edgeCells[side]);
+			}
+		}
+
+		for (const glm::ivec2& cellCoord : m_remeshCells)
+		{
+			glm::ivec2 gridCoord = cellCoord - originCell;
+			if (gridCoord.x < 0 || gridCoord.y < 0 || gridCoord.x >= gridWidth || gridCoord.y >= gridWidth)
+				continue;
+
+			meshCell(front, cellCoord);
+			m_quadDirtyRanges.push_back({ getStorageIdx(front, cellCoord) * NUM_CLOUD_FACES, NUM_CLOUD_FACES });
+		}
+
+		// Rows are contiguous, so moving along z gives one range per row while moving along x gives one per cell
+		mergeDirtyRanges(m_dirtyRanges);
+		mergeDirtyRanges(m_quadDirtyRanges);
+
+		rebuildInstances();
+		m_version++;
+	}
+
+	void CloudField::rebuildInstances()
+	{
+		const CloudGrid& front = m_grids[m_frontIdx];
+
+		m_instances.clear();
+		m_quadInstances.clear();
+
+		// Empty cells don't have any quads either
+		for (uint32_t i = 0; i < (uint32_t)front.cellNumPoints.size(); i++)
+		{
+			if (!front.cellNumPoints[i])
+				continue;
+
+			for (uint32_t j = 0; j < front.cellNumPoints[i]; j++)
+				m_instances.emplace_back(i * front.cellCapacity + j);
+
+			for (uint32_t face = 0; face < NUM_CLOUD_FACES; face++)
+			{
+				if (front.quads[i * NUM_CLOUD_FACES + face].faceAndLayers >> 17)
+					m_quadInstances.emplace_back(i * NUM_CLOUD_FACES + face);
+			}
+		}
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Engine/Okay.h"
+#include "Engine/Utilities/Noise.h"
+
+#include <atomic>
+#include <vector>
+
+namespace Okay
+{
+	class World;
+	class ThreadPool;
+
+	struct CloudGenerationData
+	{
+		Noise::SamplingData cloudNoise;
+		Noise::SamplingData maskNoise;
+
+		glm::vec2 velocity = glm::vec2(1.f, 1.f);
+		glm::vec2 globalDrift = glm::vec2(0.f);
+
+		uint32_t spawnHeight = 200;
+		float scale = 9.f;
+		float height = 100.f;
+		float maxOffset = 6.f;
+		float sampleDistance = 8.f;
+		uint32_t chunkVisiblityDistance = 32;
+		glm::vec4 colour = glm::vec4(248.f, 255.f, 255.f, 95.f) / (float)UCHAR_MAX;
+	};
+
+	// Elements [firstElement, firstElement + numElements) of one of the CloudField lists changed this update
+	struct CloudDirtyRange
+	{
+		uint32_t firstElement = 0;
+		uint32_t numElements = 0;
+	};
+
+	// Faces in the same order as CUBE_VERTICIES in CubeVerticies.hlsli
+	enum CloudFace : uint32_t
+	{
+		CLOUD_FACE_TOP = 0,
+		CLOUD_FACE_BOTTOM,
+		CLOUD_FACE_POS_X,
+		CLOUD_FACE_NEG_X,
+		CLOUD_FACE_POS_Z,
+		CLOUD_FACE_NEG_Z,
+		NUM_CLOUD_FACES,
+	};
+
+	// One outer face of a cell's column of voxels, matches CloudQuad in CloudsMeshVS.hlsl
+	struct CloudQuad
+	{
+		glm::vec3 basePos = glm::vec3(0.f); // Center of the column's lowest voxel, in cloud space
+		uint32_t faceAndLayers = 0; // Face (3 bits) | first layer (14 bits) | number of layers (15 bits), 0 layers is unused
+	};
+
+	// One complete set of cloud cells, see CloudField
+	struct CloudGrid
+	{
+		glm::ivec2 originCell = glm::ivec2(INT_MAX);
+		uint32_t gridWidth = 0;
+		uint32_t cellCapacity = 0;
+		float voxelSize = 0.f;
+		float baseHeight = 0.f;
+
+		std::vector<glm::vec3> points; // gridWidth * gridWidth * cellCapacity
+		std::vector<uint32_t> cellNumPoints;
+		std::vector<CloudQuad> quads; // gridWidth * gridWidth * NUM_CLOUD_FACES
+	};
+
+	/*
+		Cloud points in a toroidal grid of cells sampleDistance apart, covering the visibility distance around the camera.
+		Cells are in cloud space (drift removed), a cell at global cell coord (x, z) is stored at (x mod gridWidth, z mod gridWidth)
+		so moving only resamples the cells scrolling into view, which reuse the storage of the ones scrolling out.
+
+		Every cell owns a fixed number of point slots, enough for the tallest possible cloud. That keeps each cell's points
+		at a fixed offset so the renderer can mirror them in a persistent buffer & only copy the dirty ranges.
+		Slots in use are listed in getInstances(), which is what actually gets drawn.
+
+		The points are also voxelized for the meshed clouds, each point fills the voxel it was sampled for so a cell is a column of
+		cellNumPoints voxels. Only faces not touching another voxel become quads: a top & bottom per column and one quad per side
+		spanning the layers above the neighbour's column. That makes a cell's quads depend on its 4 neighbours, so they're
+		remeshed along with every cell that changes.
+
+		Filling the whole grid (first update, changed settings or teleporting) is too slow for one frame, so it's done into a
+		second grid on the thread pool, REBUILD_ROWS_PER_SLICE rows per job with at most one job in flight. The front grid
+		stays drawn & frozen meanwhile, and the two are swapped on the main thread once the last job has signalled it's done
+	*/
+
+	class CloudField
+	{
+	public:
+		static const uint32_t REBUILD_ROWS_PER_SLICE = 16;
+
+	public:
+		CloudField() = default;
+		~CloudField() = default;
+
+		void update(World& world, ThreadPool& threadPool, const glm::vec3& cameraPos);
+
+		// Rebuilds everything in the background, needed when any of the generation settings change
+		void invalidate();
+
+		const std::vector<glm::vec3>& getPoints() const;
+		const std::vector<uint32_t>& getInstances() const;
+		const std::vector<CloudDirtyRange>& getDirtyRanges() const; // Only valid for the frame of the update
+
+		const std::vector<CloudQuad>& getQuads() const;
+		const std::vector<uint32_t>& getQuadInstances() const;
+		const std::vector<CloudDirtyRange>& getQuadDirtyRanges() const; // Only valid for the frame of the update
+
+		float getVoxelSize() const;
+
+		// Bumped when the number of point or quad slots changes, the whole lists have to be uploaded again
+		uint32_t getLayoutVersion() const;
+
+		// Bumped when any point changes
+		uint32_t getVersion() const;
+
+		uint32_t getNumCellsUpdated() const;
+		bool isRebuilding() const;
+
+	private:
+		static uint32_t getStorageIdx(const CloudGrid& grid, const glm::ivec2& cellCoord);
+		static void sampleCell(const CloudGenerationData& genData, CloudGrid& grid, const glm::ivec2& cellCoord);
+		static uint32_t getNumLayers(const CloudGrid& grid, const glm::ivec2& cellCoord); // 0 outside the grid
+		static void meshCell(CloudGrid& grid, const glm::ivec2& cellCoord);
+		static void mergeDirtyRanges(std::vector<CloudDirtyRange>& ranges);
+
+		void startRebuild(ThreadPool& threadPool, const CloudGenerationData& genData, const glm::ivec2& originCell, uint32_t gridWidth, uint32_t cellCapacity);
+		void queueRebuildSlice(ThreadPool& threadPool);
+		void updateRebuild(ThreadPool& threadPool);
+
+		void updateFront(const CloudGenerationData& genData, const glm::ivec2& originCell);
+		void rebuildInstances();
+
+	private:
+		CloudGrid m_grids[2];
+		uint32_t m_frontIdx = 0;
+
+		std::vector<uint32_t> m_instances;
+		std::vector<CloudDirtyRange> m_dirtyRanges;
+		std::vector<uint32_t> m_quadInstances;
+		std::vector<CloudDirtyRange> m_quadDirtyRanges;
+		std::vector<glm::ivec2> m_remeshCells;
+
+		// Settings are copied when a rebuild starts so the UI can keep changing them while it runs
+		CloudGenerationData m_rebuildGenData;
+		uint32_t m_nextRebuildRow = 0;
+		bool m_rebuilding = false;
+		bool m_invalidated = true;
+		std::atomic<bool> m_sliceFinished = true;
+
+		uint32_t m_layoutVersion = 0;
+		uint32_t m_version = 0;
+		uint32_t m_numCellsUpdated = 0;
+
+	};
+}
@@ -0,0 +1,99 @@
+#include "FarTerrain.h"
+#include "World.h"
+
+#include "glm/gtc/constants.hpp"
+
+namespace Okay
+{
+	static int positiveModulo(int value, int divisor)
+	{
+		return ((value % divisor) + divisor) % divisor;
+	}
+
+	FarTerrain::FarTerrain()
+	{
+		for (uint32_t i = 0; i < NUM_LEVELS; i++)
+		{
+			m_levels[i].spacing = BASE_SPACING << i;
+			m_levels[i].heights.resize(NUM_SAMPLES * NUM_SAMPLES, 0.f);
+		}
+	}
+
+	void FarTerrain::update(World& world, const glm::vec3& cameraPos, float innerRadius)
+	{
+		m_numSamplesUpdated = 0;
+
+		if (!m_enabled)
+			return;
+
+		for (FarTerrainLevel& level : m_levels)
+		{
+			// Snapping to every other sample so the level boundary always lines up with the next (2x coarser) level
+			float snapDistance = level.spacing * 2.f;
+			glm::ivec2 centerSample = glm::ivec2(glm::floor(glm::vec2(cameraPos.x, cameraPos.z) / snapDistance)) * 2;
+			glm::ivec2 originSample = centerSample - glm::ivec2(GRID_CELLS / 2);
+
+			// Conservative, the level center can be up to one spacing away from the camera
+			float maxLevelDistance = (GRID_CELLS / 2 + 1) * level.spacing * glm::root_two<float>();
+			level.active = maxLevelDistance > innerRadius;
+
+			if (!level.active)
+			{
+				// Not kept up to date while hidden, so it has to be fully resampled once it's visible again
+				level.originSample = glm::ivec2(INT_MAX);
+				continue;
+			}
+
+			if (level.originSample != originSample)
+				updateLevel(world, level, originSample);
+		}
+	}
+
+	void FarTerrain::invalidate()
+	{
+		for (FarTerrainLevel& level : m_levels)
+			level.originSample = glm::ivec2(INT_MAX);
+	}
+
+	const FarTerrainLevel& FarTerrain::getLevel(uint32_t levelIdx) const
+	{
+		OKAY_ASSERT(levelIdx < NUM_LEVELS);
+		return m_levels[levelIdx];
+	}
+
+	uint32_t FarTerrain::getNumSamplesUpdated() const
+	{
+		return m_numSamplesUpdated;
+	}
+
+	uint32_t FarTerrain::getStorageIdx(const glm::ivec2& sampleCoord)
+	{
+		return positiveModulo(sampleCoord.x, NUM_SAMPLES) + positiveModulo(sampleCoord.y, NUM_SAMPLES) * NUM_SAMPLES;
+	}
+
+	void FarTerrain::updateLevel(World& world, FarTerrainLevel& level, const glm::ivec2& newOriginSample)
+	{
+		const glm::ivec2 oldOriginSample = level.originSample;
+		const bool fullUpdate = oldOriginSample.x == INT_MAX ||
+			glm::abs(newOriginSample.x - oldOriginSample.x) >= (int)NUM_SAMPLES || glm::abs(newOriginSample.y - oldOriginSample.y) >= (int)NUM_SAMPLES;
+
+		for (int z = newOriginSample.y; z < newOriginSample.y + (int)NUM_SAMPLES; z++)
+		{
+			bool rowCached = !fullUpdate && z >= oldOriginSample.y && z < oldOriginSample.y + (int)NUM_SAMPLES;
+
+			for (int x = newOriginSample.x; x < newOriginSample.x + (int)NUM_SAMPLES; x++)
+			{
+				// Samples still inside the previous window already hold the correct height
+				if (rowCached && x >= oldOriginSample.x && x < oldOriginSample.x + (int)NUM_SAMPLES)
+					continue;
+
+				glm::ivec3 blockCoordXZ = glm::ivec3(x, 0, z) * (int)level.spacing;
+				level.heights[getStorageIdx(glm::ivec2(x, z))] = (float)world.findColoumnHeight(blockCoordXZ);
+				m_numSamplesUpdated++;
+			}
+		}
+
+		level.originSample = newOriginSample;
+		level.version++;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Engine/Okay.h"
+
+#include <vector>
+
+namespace Okay
+{
+	class World;
+
+	struct FarTerrainLevel
+	{
+		// Sample coord (in this levels spacing) of the grids min corner, INT_MAX when the level hasn't been sampled
+		glm::ivec2 originSample = glm::ivec2(INT_MAX);
+		uint32_t spacing = 0;
+
+		// Toroidal, a sample at global sample coord (x, z) is stored at (x mod NUM_SAMPLES, z mod NUM_SAMPLES)
+		std::vector<float> heights;
+
+		// Incremented every time any height changes, used by the renderer to know when to re-upload
+		uint32_t version = 0;
+		bool active = false;
+	};
+
+	// Clipmap style heightfield used to render terrain beyond the voxel render distance.
+	// Each level doubles the spacing of the previous, and only the samples scrolling into view are resampled.
+	class FarTerrain
+	{
+	public:
+		static const uint32_t NUM_LEVELS = 6;
+		static const uint32_t GRID_CELLS = 64; // Cells per level side, must be a multiple of 4 to keep the levels nested
+		static const uint32_t NUM_SAMPLES = GRID_CELLS + 1;
+		static const uint32_t BASE_SPACING = 8;
+
+	public:
+		FarTerrain();
+		~FarTerrain() = default;
+
+		// Levels completely inside innerRadius are covered by voxels and are skipped
+		void update(World& world, const glm::vec3& cameraPos, float innerRadius);
+		void invalidate();
+
+		const FarTerrainLevel& getLevel(uint32_t levelIdx) const;
+		uint32_t getNumSamplesUpdated() const;
+
+		static uint32_t getStorageIdx(const glm::ivec2& sampleCoord);
+
+		bool m_enabled = true;
+
+	private:
+		void updateLevel(World& world, FarTerrainLevel& level, const glm::ivec2& newOriginSample);
+
+	private:
+		FarTerrainLevel m_levels[NUM_LEVELS];
+		uint32_t m_numSamplesUpdated = 0;
+
+	};
+}
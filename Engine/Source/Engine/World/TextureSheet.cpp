@@ -0,0 +1,480 @@
+#include "TextureSheet.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+namespace Okay
+{
+	// Bump when the baked output changes without the source textures changing
+	static const uint32_t TEXTURE_SHEET_CACHE_VERSION = 2;
+	static const uint32_t TEXTURE_SHEET_CACHE_MAGIC = 0x53544B4F; // "OKTS"
+
+	struct TextureSheetCacheHeader
+	{
+		uint32_t magic = TEXTURE_SHEET_CACHE_MAGIC;
+		uint32_t version = TEXTURE_SHEET_CACHE_VERSION;
+		uint32_t tileSize = TEXTURE_SHEET_TILE_SIZE;
+		uint32_t padding = TEXTURE_SHEET_PADDING;
+		uint32_t numBlocks = NUM_BLOCKS;
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t numMips = 0;
+		TextureSheetFormat format = TextureSheetFormat::RGBA8;
+
+		int64_t sourceWriteTime = 0; // Newest write time in the textures folder when baked
+		uint64_t payloadSize = 0;
+		uint64_t payloadHash = 0;
+	};
+
+	// FNV-1a, continues from hash so the payload can be hashed in parts
+	static uint64_t hashBytes(const uint8_t* pData, uint64_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		for (uint64_t i = 0; i < size; i++)
+		{
+			hash ^= pData[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	// One directory listing instead of probing for every block's textures
+	static int64_t findNewestSourceWriteTime()
+	{
+		int64_t newestWriteTime = 0;
+
+		std::error_code error;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(TEXTURES_PATH, error))
+		{
+			std::filesystem::file_time_type writeTime = entry.last_write_time(error);
+			if (!error)
+				newestWriteTime = glm::max(newestWriteTime, (int64_t)writeTime.time_since_epoch().count());
+		}
+
+		return newestWriteTime;
+	}
+
+	static uint32_t getNumMipLevels(uint32_t width, uint32_t height)
+	{
+		uint32_t numMips = 0;
+		for (uint32_t size = glm::max(width, height); size; size >>= 1)
+			numMips++;
+
+		return numMips;
+	}
+
+	// Average out RGB values of transparent pixel (so mipmaps generates better)
+	static void averageTransparentPixels(uint8_t* pPixels, int width, int height)
+	{
+		for (int i = 0; i < width * height; i++)
+		{
+			uint8_t* pPixel = pPixels + i * 4;
+			if (pPixel[3] == UINT8_MAX)
+				continue;
+
+			glm::ivec2 pixelCoord = glm::ivec2(i % width, i / width);
+			glm::ivec3 averageRGB = glm::ivec3(0);
+			uint32_t numSamples = 0;
+
+			for (int y = -1; y <= 1; y++)
+			{
+				for (int x = -1; x <= 1; x++)
+				{
+					glm::ivec2 adjacentCoord = glm::ivec2(pixelCoord.x + x, pixelCoord.y + y);
+					if (adjacentCoord.x < 0 || adjacentCoord.x >= width || adjacentCoord.y < 0 || adjacentCoord.y >= height)
+						continue;
+
+					const uint8_t* pAdjacent = pPixels + (adjacentCoord.x + adjacentCoord.y * width) * 4;
+					if (pAdjacent[3] == 0)
+						continue;
+
+					averageRGB += glm::ivec3(pAdjacent[0], pAdjacent[1], pAdjacent[2]);
+					numSamples++;
+				}
+			}
+
+			if (!numSamples)
+				continue;
+
+			averageRGB = (glm::vec3)averageRGB / (float)numSamples;
+
+			pPixel[0] = (uint8_t)averageRGB.r;
+			pPixel[1] = (uint8_t)averageRGB.g;
+			pPixel[2] = (uint8_t)averageRGB.b;
+		}
+	}
+
+	// Bilinear sample at each target texel's center, clamped at the edges
+	static void generateMip(const uint8_t* pSource, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t* pTarget, uint32_t targetWidth, uint32_t targetHeight)
+	{
+		glm::vec2 scale = glm::vec2((float)sourceWidth / (float)targetWidth, (float)sourceHeight / (float)targetHeight);
+
+		for (uint32_t y = 0; y < targetHeight; y++)
+		{
+			for (uint32_t x = 0; x < targetWidth; x++)
+			{
+				glm::vec2 sourceCoord = (glm::vec2((float)x, (float)y) + 0.5f) * scale - 0.5f;
+				glm::vec2 coordFloor = glm::floor(sourceCoord);
+				glm::vec2 weight = sourceCoord - coordFloor;
+
+				int x0 = glm::clamp((int)coordFloor.x, 0, (int)sourceWidth - 1);
+				int y0 = glm::clamp((int)coordFloor.y, 0, (int)sourceHeight - 1);
+				int x1 = glm::clamp((int)coordFloor.x + 1, 0, (int)sourceWidth - 1);
+				int y1 = glm::clamp((int)coordFloor.y + 1, 0, (int)sourceHeight - 1);
+
+				const uint8_t* p00 = pSource + (x0 + y0 * sourceWidth) * 4;
+				const uint8_t* p10 = pSource + (x1 + y0 * sourceWidth) * 4;
+				const uint8_t* p01 = pSource + (x0 + y1 * sourceWidth) * 4;
+				const uint8_t* p11 = pSource + (x1 + y1 * sourceWidth) * 4;
+
+				uint8_t* pTargetPixel = pTarget + (x + y * targetWidth) * 4;
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					float top = glm::mix((float)p00[c], (float)p10[c], weight.x);
+					float bottom = glm::mix((float)p01[c], (float)p11[c], weight.x);
+					pTargetPixel[c] = (uint8_t)(glm::mix(top, bottom, weight.y) + 0.5f);
+				}
+			}
+		}
+	}
+
+	static uint64_t getMipSize(TextureSheetFormat format, uint32_t width, uint32_t height)
+	{
+		if (format == TextureSheetFormat::RGBA8)
+			return width * (uint64_t)height * 4;
+
+		return BlockCompression::getCompressedSize(format == TextureSheetFormat::BC1 ? BCFormat::BC1 : BCFormat::BC3, width, height);
+	}
+
+	void TextureSheet::bake(const TextureSheetBakeSettings& settings, std::vector<TextureQuality>* pOutQuality)
+	{
+		m_cacheFile.close();
+
+		std::unordered_map<BlockType, BlockTextures> textureNames;
+		findBlockTextures(textureNames);
+
+		// IDs handed out in block order, so baking the same textures always gives the same sheet
+		std::unordered_map<std::string, uint32_t> textureNameToId;
+		std::vector<std::string> textureList;
+		memset(m_textureIds, INVALID_UINT8, sizeof(m_textureIds));
+
+		for (uint32_t i = 1; i < NUM_BLOCKS; i++)
+		{
+			const BlockTextures& textures = textureNames[BlockType(i)];
+			for (uint32_t side = 0; side < 3; side++)
+			{
+				const std::string& texture = textures.textures[side];
+				if (!textureNameToId.contains(texture))
+				{
+					textureNameToId[texture] = (uint32_t)textureList.size();
+					textureList.emplace_back(texture);
+				}
+
+				m_textureIds[i][side] = (uint8_t)textureNameToId[texture];
+			}
+		}
+
+		uint32_t tileSize = TEXTURE_SHEET_TILE_SIZE;
+		uint32_t padding = TEXTURE_SHEET_PADDING;
+
+		uint32_t numXTiles = (uint32_t)glm::ceil(glm::sqrt((float)textureList.size()));
+		uint32_t numYTiles = (uint32_t)glm::ceil((float)textureList.size() / (float)numXTiles);
+
+		m_width = numXTiles * tileSize + (numXTiles - 1) * padding;
+		m_height = numYTiles * tileSize + (numYTiles - 1) * padding;
+		m_numMips = getNumMipLevels(m_width, m_height);
+
+		// Mips are generated uncompressed & compressed at the end
+		m_format = TextureSheetFormat::RGBA8;
+		m_bakedPixels.assign(getPixelDataSize(), 0);
+		m_pPixels = m_bakedPixels.data();
+
+		// Untouched tiles to measure the compression against, the transparent pixel averaging would skew it
+		std::vector<uint8_t> sourceTiles;
+		if (pOutQuality)
+			sourceTiles.resize(textureList.size() * tileSize * tileSize * 4);
+
+		uint8_t* pSheet = m_bakedPixels.data();
+		uint64_t rowPitch = m_width * 4ull;
+
+		for (uint32_t textureId = 0; textureId < (uint32_t)textureList.size(); textureId++)
+		{
+			uint32_t xSlot = textureId % numXTiles;
+			uint32_t ySlot = textureId / numXTiles;
+
+			uint8_t* pTarget = pSheet +
+				xSlot * (tileSize + padding) * 4 +
+				ySlot * (tileSize + padding) * rowPitch;
+
+			int sourceWidth, sourceHeight;
+			std::string texturePath = (TEXTURES_PATH / (textureList[textureId] + ".png")).string();
+
+			uint8_t* pSource = stbi_load(texturePath.c_str(), &sourceWidth, &sourceHeight, nullptr, STBI_rgb_alpha);
+			OKAY_ASSERT(pSource);
+			OKAY_ASSERT(sourceWidth == (int)tileSize && sourceHeight >= (int)tileSize);
+
+			if (pOutQuality)
+				memcpy(sourceTiles.data() + textureId * tileSize * tileSize * 4ull, pSource, tileSize * tileSize * 4ull);
+
+			averageTransparentPixels(pSource, sourceWidth, sourceHeight);
+
+			for (uint32_t i = 0; i < tileSize; i++)
+			{
+				memcpy(pTarget + i * rowPitch, pSource + i * tileSize * 4, tileSize * 4ull);
+			}
+
+			stbi_image_free(pSource);
+		}
+
+
+		// Fill in column padding
+		for (uint32_t xTex = 0; xTex < numXTiles - 1; xTex++)
+		{
+			uint8_t* pTarget = pSheet + tileSize * 4 + (xTex * (tileSize + padding) * 4);
+			uint8_t* pSource = pTarget - 4;
+
+			for (uint32_t j = 0; j < padding / 2; j++)
+			{
+				for (uint32_t i = 0; i < m_height; i++)
+				{
+					memcpy(pTarget + i * rowPitch + j * 4, pSource + i * rowPitch, 4ull);
+				}
+			}
+
+			pTarget += (padding / 2) * 4;
+			pSource = pTarget + padding * 2;
+
+			for (uint32_t j = 0; j < padding / 2; j++)
+			{
+				for (uint32_t i = 0; i < m_height; i++)
+				{
+					memcpy(pTarget + i * rowPitch + j * 4, pSource + i * rowPitch, 4ull);
+				}
+			}
+		}
+
+		// Fill in row padding
+		for (uint32_t yTex = 0; yTex < numYTiles - 1; yTex++)
+		{
+			uint8_t* pTarget = pSheet + tileSize * rowPitch + (yTex * (tileSize + padding) * rowPitch);
+			uint8_t* pSource = pTarget - rowPitch;
+
+			for (uint32_t i = 0; i < padding / 2; i++)
+			{
+				memcpy(pTarget + i * rowPitch, pSource, rowPitch);
+			}
+
+			pTarget += (padding / 2) * rowPitch;
+			pSource = pTarget + (padding / 2) * rowPitch;
+
+			for (uint32_t i = 0; i < padding / 2; i++)
+			{
+				memcpy(pTarget + i * rowPitch, pSource, rowPitch);
+			}
+		}
+
+
+		for (uint32_t i = 1; i < m_numMips; i++)
+		{
+			generateMip(getMipData(i - 1), getMipWidth(i - 1), getMipHeight(i - 1), (uint8_t*)getMipData(i), getMipWidth(i), getMipHeight(i));
+		}
+
+		if (settings.format != TextureSheetFormat::RGBA8)
+		{
+			BCFormat bcFormat = settings.format == TextureSheetFormat::BC1 ? BCFormat::BC1 : BCFormat::BC3;
+
+			std::vector<uint8_t> rgbaPixels;
+			rgbaPixels.swap(m_bakedPixels);
+			m_pPixels = rgbaPixels.data();
+
+			std::vector<const uint8_t*> rgbaMips(m_numMips);
+			for (uint32_t i = 0; i < m_numMips; i++)
+				rgbaMips[i] = getMipData(i);
+
+			m_format = settings.format;
+			m_bakedPixels.assign(getPixelDataSize(), 0);
+			m_pPixels = m_bakedPixels.data();
+
+			for (uint32_t i = 0; i < m_numMips; i++)
+				BlockCompression::compressImage(bcFormat, settings.quality, rgbaMips[i], getMipWidth(i), getMipHeight(i), (uint8_t*)getMipData(i));
+		}
+
+		if (!pOutQuality)
+			return;
+
+		// Decode the top mip the same way the GPU would & compare each tile against its PNG
+		std::vector<uint8_t> decodedPixels(m_width * (uint64_t)m_height * 4);
+		if (m_format == TextureSheetFormat::RGBA8)
+			memcpy(decodedPixels.data(), getMipData(0), decodedPixels.size());
+		else
+			BlockCompression::decompressImage(m_format == TextureSheetFormat::BC1 ? BCFormat::BC1 : BCFormat::BC3, getMipData(0), m_width, m_height, decodedPixels.data());
+
+		std::vector<uint8_t> decodedTile(tileSize * tileSize * 4);
+		pOutQuality->clear();
+
+		for (uint32_t textureId = 0; textureId < (uint32_t)textureList.size(); textureId++)
+		{
+			uint32_t xSlot = textureId % numXTiles;
+			uint32_t ySlot = textureId / numXTiles;
+
+			const uint8_t* pDecoded = decodedPixels.data() +
+				xSlot * (tileSize + padding) * 4 +
+				ySlot * (tileSize + padding) * rowPitch;
+
+			for (uint32_t i = 0; i < tileSize; i++)
+				memcpy(decodedTile.data() + i * tileSize * 4, pDecoded + i * rowPitch, tileSize * 4ull);
+
+			TextureQuality& quality = pOutQuality->emplace_back();
+			quality.textureName = textureList[textureId];
+			quality.psnr = BlockCompression::computePSNR(sourceTiles.data() + textureId * tileSize * tileSize * 4ull, decodedTile.data(), tileSize * tileSize);
+		}
+	}
+
+	bool TextureSheet::writeCache(const FilePath& path) const
+	{
+		OKAY_ASSERT(m_pPixels);
+
+		TextureSheetCacheHeader header;
+		header.width = m_width;
+		header.height = m_height;
+		header.numMips = m_numMips;
+		header.format = m_format;
+		header.sourceWriteTime = findNewestSourceWriteTime();
+		header.payloadSize = sizeof(m_textureIds) + getPixelDataSize();
+		header.payloadHash = hashBytes(m_pPixels, getPixelDataSize(), hashBytes((const uint8_t*)m_textureIds, sizeof(m_textureIds)));
+
+		std::ofstream writer(path, std::ios::binary);
+		if (!writer)
+			return false;
+
+		writer.write((const char*)&header, sizeof(header));
+		writer.write((const char*)m_textureIds, sizeof(m_textureIds));
+		writer.write((const char*)m_pPixels, getPixelDataSize());
+
+		return writer.good();
+	}
+
+	bool TextureSheet::loadCache(const FilePath& path)
+	{
+		if (!m_cacheFile.open(path))
+			return false;
+
+		TextureSheetCacheHeader header;
+		TextureSheetCacheHeader expectedHeader;
+		const uint8_t* pPayload = m_cacheFile.getData() + sizeof(TextureSheetCacheHeader);
+		uint64_t payloadSize = m_cacheFile.getSize() - sizeof(TextureSheetCacheHeader);
+
+		bool valid = m_cacheFile.getSize() > sizeof(TextureSheetCacheHeader);
+		if (valid)
+		{
+			memcpy(&header, m_cacheFile.getData(), sizeof(TextureSheetCacheHeader));
+
+			valid = header.magic == expectedHeader.magic && header.version == expectedHeader.version &&
+				header.tileSize == expectedHeader.tileSize && header.padding == expectedHeader.padding && header.numBlocks == expectedHeader.numBlocks &&
+				header.numMips == getNumMipLevels(header.width, header.height) && header.format <= TextureSheetFormat::BC3 && header.payloadSize == payloadSize &&
+				header.sourceWriteTime == findNewestSourceWriteTime();
+		}
+
+		if (valid)
+		{
+			m_width = header.width;
+			m_height = header.height;
+			m_numMips = header.numMips;
+			m_format = header.format;
+
+			valid = payloadSize == sizeof(m_textureIds) + getPixelDataSize() && hashBytes(pPayload, payloadSize) == header.payloadHash;
+		}
+
+		if (!valid)
+		{
+			m_cacheFile.close();
+			m_width = m_height = m_numMips = 0;
+			return false;
+		}
+
+		memcpy(m_textureIds, pPayload, sizeof(m_textureIds));
+		m_pPixels = pPayload + sizeof(m_textureIds);
+
+		m_bakedPixels.clear();
+		m_bakedPixels.shrink_to_fit();
+
+		return true;
+	}
+
+	uint32_t TextureSheet::getWidth() const
+	{
+		return m_width;
+	}
+
+	uint32_t TextureSheet::getHeight() const
+	{
+		return m_height;
+	}
+
+	uint32_t TextureSheet::getNumMips() const
+	{
+		return m_numMips;
+	}
+
+	TextureSheetFormat TextureSheet::getFormat() const
+	{
+		return m_format;
+	}
+
+	uint32_t TextureSheet::getMipWidth(uint32_t mipLevel) const
+	{
+		return glm::max(m_width >> mipLevel, 1u);
+	}
+
+	uint32_t TextureSheet::getMipHeight(uint32_t mipLevel) const
+	{
+		return glm::max(m_height >> mipLevel, 1u);
+	}
+
+	uint32_t TextureSheet::getMipNumRows(uint32_t mipLevel) const
+	{
+		return m_format == TextureSheetFormat::RGBA8 ? getMipHeight(mipLevel) : BlockCompression::getNumBlocksY(getMipHeight(mipLevel));
+	}
+
+	uint64_t TextureSheet::getMipRowSize(uint32_t mipLevel) const
+	{
+		return getMipSize(m_format, getMipWidth(mipLevel), getMipHeight(mipLevel)) / getMipNumRows(mipLevel);
+	}
+
+	const uint8_t* TextureSheet::getMipData(uint32_t mipLevel) const
+	{
+		OKAY_ASSERT(mipLevel < m_numMips);
+
+		uint64_t offset = 0;
+		for (uint32_t i = 0; i < mipLevel; i++)
+			offset += getMipSize(m_format, getMipWidth(i), getMipHeight(i));
+
+		return m_pPixels + offset;
+	}
+
+	uint8_t TextureSheet::getTextureID(BlockType blockType, BlockSide side) const
+	{
+		return m_textureIds[(uint32_t)blockType][side];
+	}
+
+	uint64_t TextureSheet::getPixelDataSize() const
+	{
+		uint64_t size = 0;
+		for (uint32_t i = 0; i < m_numMips; i++)
+			size += getMipSize(m_format, getMipWidth(i), getMipHeight(i));
+
+		return size;
+	}
+
+	void loadTextureSheet(TextureSheet& outSheet)
+	{
+		if (outSheet.loadCache(TEXTURE_SHEET_CACHE_PATH))
+			return;
+
+		outSheet.bake();
+
+		if (!outSheet.writeCache(TEXTURE_SHEET_CACHE_PATH))
+			printf("Failed to write the texture sheet cache: %s\n", TEXTURE_SHEET_CACHE_PATH.string().c_str());
+	}
+}
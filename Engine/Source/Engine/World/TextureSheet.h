@@ -0,0 +1,90 @@
+#pragma once
+#include "Blocks.h"
+#include "Engine/Utilities/MappedFile.h"
+#include "Engine/Utilities/BlockCompression.h"
+
+#include <vector>
+
+namespace Okay
+{
+	constexpr uint32_t TEXTURE_SHEET_TILE_SIZE = 16;
+	constexpr uint32_t TEXTURE_SHEET_PADDING = 8;
+
+	inline const FilePath TEXTURE_SHEET_CACHE_PATH = RESOURCES_PATH / "texture_sheet.bin";
+
+	enum struct TextureSheetFormat : uint32_t
+	{
+		RGBA8 = 0,
+		BC1, // 8x smaller than RGBA8, the 1 bit alpha cuts at the same 0.5 as the alpha test in PixelShader
+		BC3, // 4x smaller, keeps smooth alpha
+	};
+
+	struct TextureSheetBakeSettings
+	{
+		TextureSheetFormat format = TextureSheetFormat::BC1;
+		BCQuality quality = BCQuality::HIGH;
+	};
+
+	// How close the compressed top mip is to the source PNG, see BlockCompression::computePSNR
+	struct TextureQuality
+	{
+		std::string textureName;
+		float psnr = 0.f;
+	};
+
+	/*
+		The block textures packed into one padded sheet with its full mip chain, plus which texture each block side uses.
+		Baking decodes the PNGs, generates the mips & block compresses them on the CPU so it runs without a GPU, the result is cached
+		in one file that later launches memory map instead of touching the PNGs.
+
+		Cache layout: TextureSheetCacheHeader, texture IDs (NUM_BLOCKS * 3 bytes), then every mip with tightly packed rows.
+		Rows are rows of 4x4 blocks for the BC formats. The header holds a hash of everything after it
+	*/
+
+	class TextureSheet
+	{
+	public:
+		TextureSheet() = default;
+		~TextureSheet() = default;
+
+		// pOutQuality gets one entry per texture, comparing them takes an extra decode so it's optional
+		void bake(const TextureSheetBakeSettings& settings = {}, std::vector<TextureQuality>* pOutQuality = nullptr);
+		bool writeCache(const FilePath& path) const;
+
+		// Fails if the cache is missing, corrupt, baked with another layout or older than the source textures.
+		// Any format is accepted, so a sheet baked with --bake-textures isn't replaced by one with the default settings
+		bool loadCache(const FilePath& path);
+
+		uint32_t getWidth() const;
+		uint32_t getHeight() const;
+		uint32_t getNumMips() const;
+		TextureSheetFormat getFormat() const;
+		uint32_t getMipWidth(uint32_t mipLevel) const;
+		uint32_t getMipHeight(uint32_t mipLevel) const;
+
+		// Rows of pixels, or rows of blocks for the BC formats
+		uint32_t getMipNumRows(uint32_t mipLevel) const;
+		uint64_t getMipRowSize(uint32_t mipLevel) const;
+		const uint8_t* getMipData(uint32_t mipLevel) const;
+
+		uint8_t getTextureID(BlockType blockType, BlockSide side) const; // INVALID_UINT8 for air
+
+	private:
+		uint64_t getPixelDataSize() const; // All mips
+
+		uint32_t m_width = 0;
+		uint32_t m_height = 0;
+		uint32_t m_numMips = 0;
+		TextureSheetFormat m_format = TextureSheetFormat::RGBA8;
+		uint8_t m_textureIds[NUM_BLOCKS][3] = {};
+
+		// Points into either m_bakedPixels or the mapped cache
+		const uint8_t* m_pPixels = nullptr;
+		std::vector<uint8_t> m_bakedPixels;
+		MappedFile m_cacheFile;
+
+	};
+
+	// Uses the cache if it's valid, otherwise bakes the sheet & rewrites the cache
+	void loadTextureSheet(TextureSheet& outSheet);
+}
@@ -5,11 +5,10 @@
 #include "Engine/Utilities/Random.h"
 
 #include <shared_mutex>
+#include <algorithm>
 
 namespace Okay
 {
-	const float CloudGenerationData::UPDATE_INTERVAL = 10.f;
-
 	static std::shared_mutex mutis;
 	static std::unordered_map<StructureType, StructureDescription> s_structureDescriptions;
 
@@ -20,6 +19,9 @@ namespace Okay
 		uint32_t numThreads = glm::max(uint32_t(std::thread::hardware_concurrency() * 0.5), 1u);
 		m_threadPool.initialize(numThreads);
 
+		for (uint32_t i = MAX_LOADING_CHUNKS; i > 0; i--)
+			m_freeChunkGenerations.emplace_back(i - 1);
+
 		m_worldGenData.terrrainNoiseInterpolation.addPoint(-0.45f, -0.55f);
 		m_worldGenData.terrrainNoiseInterpolation.addPoint(-0.1f, 0.f);
 		m_worldGenData.terrrainNoiseInterpolation.addPoint(0.f, 0.1f);
@@ -66,13 +68,15 @@ namespace Okay
 	{
 		clearUpdatedChunks();
 		m_currentCamChunkCoord = chunkIDToChunkCoord(blockCoordToChunkID(glm::floor(camera.transform.position)));
+		updatePrefetchChunkCoord(camera, dt);
 
 		updateClouds(camera, dt);
+		m_farTerrain.update(*this, camera.transform.position, getFarTerrainInnerRadius());
 
 		std::unique_lock lock(mutis);
 		unloadDistantChunks();
 		processLoadingChunks();
-		tryLoadRenderEligableChunks(camera);
+		tryLoadRenderEligableChunks();
 	}
 
 	BlockType World::getBlockAtBlockCoord(const glm::ivec3& blockCoord) const
@@ -139,7 +143,7 @@ namespace Okay
 				if (!shouldPlaceTree(blockCoord))
 					continue;
 
-				ChunkStructures& chunkStructures = m_chunksStructures[chunkID];
+				ChunkStructures& chunkStructures = m_chunksStructures.getOrInsert(chunkID);
 				uint32_t nextIdx = chunkStructures.numStructures;
 				if (nextIdx >= MAX_CHUNK_STRUCTURES)
 					return;
@@ -174,11 +178,11 @@ namespace Okay
 
 	BlockType World::searchChunkForStructure(ChunkID chunkID, const glm::ivec3& blockCoord) const
 	{
-		const auto& chunkIt = m_chunksStructures.find(chunkID);
-		if (chunkIt == m_chunksStructures.end())
+		const ChunkStructures* pChunkStructures = m_chunksStructures.tryGet(chunkID);
+		if (!pChunkStructures)
 			return BlockType::INVALID;
 
-		const ChunkStructures& chunkStructures = chunkIt->second;
+		const ChunkStructures& chunkStructures = *pChunkStructures;
 		for (const Structure& structure : chunkStructures.structures)
 		{
 			if (!structure.isWithinBounds(blockCoord))
@@ -265,121 +269,80 @@ namespace Okay
 	{
 		std::unique_lock lock(mutis);
 
+		for (uint32_t i = 0; i < m_loadedChunks.size(); i++)
+			m_chunkPool.free(m_loadedChunks.getValue(i));
+
 		m_loadedChunks.clear();
 		m_chunksStructures.clear();
+		m_loadCursor = 0;
+		m_prefetchCursor = 0;
+		std::fill(m_unloadedChunkCells.begin(), m_unloadedChunkCells.end(), INVALID_CHUNK_ID);
+		m_prefetchedChunks.clear();
+
+		m_farTerrain.invalidate();
 	}
 
 	void World::recreateClouds()
 	{
-		m_cloudGenData.cloudList.clear();
-		m_cloudGenData.localDrift = glm::vec3(FLT_MAX);
-		m_cloudGenData.updateTimer = CloudGenerationData::UPDATE_INTERVAL;
+		m_cloudField.invalidate();
 	}
 
 	void World::updateClouds(const Camera& camera, TimeStep dt)
 	{
 		m_cloudGenData.globalDrift += m_cloudGenData.velocity * dt;
-		m_cloudGenData.localDrift += m_cloudGenData.velocity * dt;
-
-		m_cloudGenData.updateTimer += dt;
-		if (m_cloudGenData.updateTimer < CloudGenerationData::UPDATE_INTERVAL)
-			return;
-
-		m_cloudGenData.updateTimer -= CloudGenerationData::UPDATE_INTERVAL;
-
-		clearDistanceClouds(camera);
-		generateCloudList(camera);
-
-		m_cloudGenData.localDrift = glm::vec2(camera.transform.position.x, camera.transform.position.z);
+		m_cloudField.update(*this, m_threadPool, camera.transform.position);
 	}
 
-	void World::generateCloudList(const Camera& camera)
+	const CloudField& World::getCloudField() const
 	{
-		float viewDistance = (float)m_cloudGenData.chunkVisiblityDistance * CHUNK_WIDTH;
-		glm::vec2 cameraXZPos = glm::vec2(camera.transform.position.x, camera.transform.position.z);
-
-		glm::vec2 min = glm::min(m_cloudGenData.localDrift, cameraXZPos);
-		glm::vec2 max = glm::max(m_cloudGenData.localDrift, cameraXZPos);
-
-		glm::vec2 overlappingMin = max - glm::vec2(viewDistance);
-		glm::vec2 overlappingMax = min + glm::vec2(viewDistance);
-
-		for (float x = -viewDistance + cameraXZPos.x; x <= viewDistance + cameraXZPos.x; x += m_cloudGenData.sampleDistance)
-		{
-			for (float z = -viewDistance + cameraXZPos.y; z <= viewDistance + cameraXZPos.y; z += m_cloudGenData.sampleDistance)
-			{
-				if (x >= overlappingMin.x && x <= overlappingMax.x && z >= overlappingMin.y && z <= overlappingMax.y)
-					continue;
-
-				sampleCloud(x - m_cloudGenData.globalDrift.x, z - m_cloudGenData.globalDrift.y);
-			}
-		}
+		return m_cloudField;
 	}
 
-	void World::clearDistanceClouds(const Camera& camera)
+	float World::getFarTerrainInnerRadius() const
 	{
-		float viewDistance = (float)m_cloudGenData.chunkVisiblityDistance * CHUNK_WIDTH;
-		glm::vec3 globalDriftVec3 = glm::vec3(m_cloudGenData.globalDrift.x, 0, m_cloudGenData.globalDrift.y);
-
-		for (int32_t i = (int32_t)m_cloudGenData.cloudList.size() - 1; i >= 0; i--)
-		{
-			glm::vec3 cloudGlobalPos = m_cloudGenData.cloudList[i] + globalDriftVec3;
-			glm::vec3 camToCloud = glm::abs(cloudGlobalPos - camera.transform.position);
-
-			if (camToCloud.x > viewDistance || camToCloud.z > viewDistance)
-			{
-				m_cloudGenData.cloudList.erase(m_cloudGenData.cloudList.begin() + i);
-			}
-		}
+		// One chunk of overlap so there's no gap between the voxels and the far terrain
+		return glm::max((float)m_renderDistance - 1.f, 0.f) * (float)CHUNK_WIDTH;
 	}
 
-	void World::sampleCloud(float x, float z)
+	uint32_t World::getUnloadDistance() const
 	{
-		float cloudNoise = Noise::samplePerlin2D_zeroOne(x, z, m_cloudGenData.cloudNoise);
-		float maskNoise = Noise::samplePerlin2D_zeroOne(x, z, m_cloudGenData.maskNoise);
-		float finalNoise = cloudNoise * maskNoise;
-
-		float cloudHeight = finalNoise * m_cloudGenData.height;
-
-		float currentHeight = 0.f;
-		while (currentHeight < cloudHeight)
-		{
-			uint32_t seed = uint32_t(finalNoise * UINT_MAX + currentHeight);
+		return m_renderDistance + m_unloadDistanceMargin;
+	}
 
-			glm::vec3 placementOffset = glm::vec3(
-				Random::randomFloat(seed) * 2.f - 1.f,
-				(Random::randomFloat(seed) * 2.f - 1.f) * 0.5f,
-				Random::randomFloat(seed) * 2.f - 1.f);
+	uint32_t World::getNumRegeneratedChunks() const
+	{
+		return m_numRegeneratedChunks;
+	}
 
-			placementOffset = glm::normalize(placementOffset) * m_cloudGenData.maxOffset * Random::randomFloat(seed);
-			glm::vec3 cloudPoint = glm::vec3(x, m_cloudGenData.spawnHeight + currentHeight, z);
+	uint32_t World::getNumPrefetchHits() const
+	{
+		return m_numPrefetchHits;
+	}
 
-			m_cloudGenData.cloudList.emplace_back(cloudPoint + placementOffset);
-			currentHeight += m_cloudGenData.sampleDistance;
-		}
+	uint32_t World::getNumPrefetchMisses() const
+	{
+		return m_numPrefetchMisses;
 	}
 
-	const std::vector<glm::vec3>& World::getCloudList() const
+	const ChunkPool& World::getChunkPool() const
 	{
-		return m_cloudGenData.cloudList;
+		return m_chunkPool;
 	}
 
 	Chunk& World::getChunk(ChunkID chunkID)
 	{
-		return m_loadedChunks[chunkID];
+		return m_chunkPool.get(m_loadedChunks.get(chunkID));
 	}
 
 	const Chunk& World::getChunkConst(ChunkID chunkID) const
 	{
-		auto iterator = m_loadedChunks.find(chunkID);
-		OKAY_ASSERT(iterator != m_loadedChunks.end());
-		return iterator->second;
+		return m_chunkPool.get(m_loadedChunks.get(chunkID));
 	}
 
 	const Chunk* World::tryGetChunk(ChunkID chunkID) const
 	{
-		auto iterator = m_loadedChunks.find(chunkID);
-		return iterator == m_loadedChunks.end() ? nullptr : &iterator->second;
+		const ChunkHandle* pChunkHandle = m_loadedChunks.tryGet(chunkID);
+		return pChunkHandle ? &m_chunkPool.get(*pChunkHandle) : nullptr;
 	}
 
 	bool World::isChunkLoaded(ChunkID chunkID) const
@@ -395,108 +358,260 @@ namespace Okay
 
 	void World::unloadDistantChunks()
 	{
-		auto chunkIterator = m_loadedChunks.begin();
-		while (chunkIterator != m_loadedChunks.end())
+		uint32_t unloadDistance = getUnloadDistance();
+		if (m_unloadCamChunkCoord == m_currentCamChunkCoord && m_unloadPrefetchChunkCoord == m_prefetchChunkCoord && m_lastUnloadDistance == unloadDistance)
+			return;
+
+		if (m_lastUnloadDistance != unloadDistance)
+			resizeChunkStorage();
+
+		m_unloadCamChunkCoord = m_currentCamChunkCoord;
+		m_unloadPrefetchChunkCoord = m_prefetchChunkCoord;
+		m_lastUnloadDistance = unloadDistance;
+
+		// Removing swaps the last chunk into i, so i only moves on when the chunk is kept
+		uint32_t i = 0;
+		while (i < m_loadedChunks.size())
 		{
-			ChunkID chunkID = chunkIterator->first;
-			if (isChunkWithinRenderDistance(chunkID))
+			ChunkID chunkID = m_loadedChunks.getID(i);
+			if (shouldKeepChunk(chunkID))
 			{
-				++chunkIterator;
+				i++;
 				continue;
 			}
 
-			chunkIterator = m_loadedChunks.erase(chunkIterator);
-			m_chunksStructures.erase(chunkID);
+			m_chunkPool.free(m_loadedChunks.getValue(i));
+			m_loadedChunks.remove(chunkID);
+			m_chunksStructures.remove(chunkID);
 
 			m_removedChunks.emplace_back(chunkID);
+			getUnloadedChunkCell(chunkID) = chunkID;
+			countPrefetchMiss(chunkID);
 		}
 	}
 
 	void World::processLoadingChunks()
 	{
-		auto chunkIterator = m_loadingChunks.begin();
-		while (chunkIterator != m_loadingChunks.end())
+		uint32_t i = 0;
+		while (i < m_loadingChunks.size())
 		{
-			ChunkGeneration& chunkGeneration = chunkIterator->second;
+			uint32_t generationIdx = m_loadingChunks.getValue(i);
+			ChunkGeneration& chunkGeneration = m_chunkGenerations[generationIdx];
 			if (!chunkGeneration.threadFinished.load())
 			{
-				++chunkIterator;
+				i++;
 				continue;
 			}
 
-			ChunkID chunkID = chunkIterator->first;
-			if (!isChunkWithinRenderDistance(chunkID))
+			ChunkID chunkID = m_loadingChunks.getID(i);
+			m_loadingChunks.remove(chunkID);
+			m_freeChunkGenerations.emplace_back(generationIdx);
+
+			if (!shouldKeepChunk(chunkID))
 			{
-				chunkIterator = m_loadingChunks.erase(chunkIterator);
+				countPrefetchMiss(chunkID);
+				m_chunkPool.free(chunkGeneration.chunkHandle);
 				continue;
 			}
 
-			m_loadedChunks[chunkID] = chunkGeneration.chunk;
+			// The generated blocks stay where they are, only the handle moves
+			m_loadedChunks.getOrInsert(chunkID) = chunkGeneration.chunkHandle;
 			m_addedChunks.emplace_back(chunkID);
+		}
+	}
 
-			chunkIterator = m_loadingChunks.erase(chunkIterator);
+	void World::tryLoadRenderEligableChunks()
+	{
+		updateLoadOrder();
+
+		// Chunks are checked at most once per camera chunk, so this costs the same whether or not the camera moved
+		uint32_t numChecks = 0;
+		while (m_loadCursor < (uint32_t)m_loadOrder.size() && numChecks < MAX_LOAD_CHECKS_PER_UPDATE && m_loadingChunks.size() < MAX_LOADING_CHUNKS)
+		{
+			ChunkID chunkID = chunkCoordToChunkID(m_currentCamChunkCoord + m_loadOrder[m_loadCursor++]);
+			numChecks++;
+
+			if (!m_prefetchedChunks.empty() && m_prefetchedChunks.remove(chunkID))
+				m_numPrefetchHits++;
+
+			if (!isChunkLoaded(chunkID) && !isChunkLoading(chunkID))
+				launchChunkGenerationThread(chunkID);
 		}
+
+		// Prefetching only gets what's left once everything within the render distance is queued
+		if (m_loadCursor == (uint32_t)m_loadOrder.size())
+			tryPrefetchChunks(numChecks);
 	}
 
-	void World::tryLoadRenderEligableChunks(const Camera& camera)
+	void World::tryPrefetchChunks(uint32_t& numChecks)
 	{
-		for (int i = 0; i < (int)m_renderDistance; i++)
+		if (!m_prefetchData.enabled || m_prefetchChunkCoord == m_currentCamChunkCoord)
+			return;
+
+		if (m_prefetchCursorChunkCoord != m_prefetchChunkCoord || m_prefetchCursorCamChunkCoord != m_currentCamChunkCoord)
 		{
-			uint32_t loadedChunks = 0;
-			uint32_t totalChunks = 0;
+			m_prefetchCursorChunkCoord = m_prefetchChunkCoord;
+			m_prefetchCursorCamChunkCoord = m_currentCamChunkCoord;
+			m_prefetchCursor = 0;
+		}
 
-			for (int chunkX = -i; chunkX <= i; chunkX++)
-			{
-				int zIncrement = chunkX == -i || chunkX == i ? 1 : i * 2;
+		int renderDistance = (int)m_renderDistance;
+		while (m_prefetchCursor < (uint32_t)m_loadOrder.size() && numChecks < MAX_LOAD_CHECKS_PER_UPDATE && m_loadingChunks.size() < MAX_LOADING_CHUNKS)
+		{
+			glm::ivec2 chunkCoord = m_prefetchChunkCoord + m_loadOrder[m_prefetchCursor++];
 
-				for (int chunkZ = -i; chunkZ <= i; chunkZ += zIncrement)
-				{
-					glm::ivec2 chunkCoord = m_currentCamChunkCoord + glm::ivec2(chunkX, chunkZ);
-					ChunkID chunkID = chunkCoordToChunkID(chunkCoord);
-					
-					if (!isChunkWithinRenderDistance(chunkID) || !isChunkInView(camera, chunkID))
-						continue;
+			// Already handled by the load cursor, skipping them is cheap enough to not count as a check
+			glm::ivec2 camOffset = chunkCoord - m_currentCamChunkCoord;
+			if (camOffset.x * camOffset.x + camOffset.y * camOffset.y <= renderDistance * renderDistance)
+				continue;
 
-					totalChunks++;
+			ChunkID chunkID = chunkCoordToChunkID(chunkCoord);
+			numChecks++;
 
-					if (isChunkLoaded(chunkID))
-					{
-						loadedChunks++;
-						continue;
-					}
+			if (isChunkLoaded(chunkID) || isChunkLoading(chunkID))
+				continue;
+
+			launchChunkGenerationThread(chunkID);
+			m_prefetchedChunks.getOrInsert(chunkID);
+		}
+	}
+
+	void World::updatePrefetchChunkCoord(const Camera& camera, TimeStep dt)
+	{
+		glm::vec3 cameraPos = camera.transform.position;
+
+		// Smoothed over a few frames so a single long frame doesn't throw the prediction off
+		if (m_hasLastCameraPos && dt > 0.f)
+		{
+			glm::vec3 velocity = (cameraPos - m_lastCameraPos) / dt;
+			m_cameraVelocity = glm::mix(m_cameraVelocity, velocity, glm::min(dt * 10.f, 1.f));
+		}
+
+		m_lastCameraPos = cameraPos;
+		m_hasLastCameraPos = true;
+		m_prefetchChunkCoord = m_currentCamChunkCoord;
+
+		glm::vec2 velocityXZ = glm::vec2(m_cameraVelocity.x, m_cameraVelocity.z);
+		float speed = glm::length(velocityXZ);
+		if (!m_prefetchData.enabled || speed < glm::max(m_prefetchData.minSpeed, 0.001f))
+			return;
+
+		glm::vec2 moveDir = velocityXZ / speed;
+		glm::vec3 forward = camera.transform.forwardVec();
+		glm::vec2 lookDir = glm::vec2(forward.x, forward.z);
 
-					if (isChunkLoading(chunkID))
-						continue;
-					
-					launchChunkGenerationThread(chunkID);
+		if (glm::length2(lookDir) > 0.0001f)
+		{
+			glm::vec2 blendedDir = glm::mix(moveDir, glm::normalize(lookDir), glm::clamp(m_prefetchData.lookDirectionWeight, 0.f, 1.f));
+			if (glm::length2(blendedDir) > 0.0001f)
+				moveDir = glm::normalize(blendedDir);
+		}
+
+		glm::vec2 predictedPos = glm::vec2(cameraPos.x, cameraPos.z) + moveDir * speed * m_prefetchData.lookAheadTime;
+		m_prefetchChunkCoord = chunkIDToChunkCoord(blockCoordToChunkID(glm::floor(glm::vec3(predictedPos.x, 0.f, predictedPos.y))));
+	}
+
+	void World::updateLoadOrder()
+	{
+		if (m_loadOrderRenderDistance != m_renderDistance)
+		{
+			int renderDistance = (int)m_renderDistance;
+			m_loadOrder.clear();
+
+			// Same circle as isChunkWithinDistance
+			for (int chunkX = -renderDistance; chunkX <= renderDistance; chunkX++)
+			{
+				for (int chunkZ = -renderDistance; chunkZ <= renderDistance; chunkZ++)
+				{
+					if (chunkX * chunkX + chunkZ * chunkZ <= renderDistance * renderDistance)
+						m_loadOrder.emplace_back(chunkX, chunkZ);
 				}
 			}
 
-			if (loadedChunks != totalChunks)
-				break;
+			std::sort(m_loadOrder.begin(), m_loadOrder.end(), [](const glm::ivec2& a, const glm::ivec2& b)
+			{
+				int distanceA = a.x * a.x + a.y * a.y;
+				int distanceB = b.x * b.x + b.y * b.y;
+				return distanceA != distanceB ? distanceA < distanceB : (a.x != b.x ? a.x < b.x : a.y < b.y);
+			});
+
+			m_loadOrderRenderDistance = m_renderDistance;
+			m_loadCursor = 0;
+			m_prefetchCursor = 0;
+		}
+
+		if (m_loadOrderCamChunkCoord != m_currentCamChunkCoord)
+		{
+			m_loadOrderCamChunkCoord = m_currentCamChunkCoord;
+			m_loadCursor = 0;
 		}
 	}
 
-	bool World::isChunkWithinRenderDistance(ChunkID chunkID) const
+	bool World::isChunkWithinDistance(ChunkID chunkID, uint32_t distance) const
 	{
 		glm::vec2 chunkMiddle = glm::vec2(chunkIDToChunkCoord(chunkID));
 		glm::vec2 camChunkMiddle = glm::vec2(m_currentCamChunkCoord);
-		return glm::length2(chunkMiddle - camChunkMiddle) <= m_renderDistance * m_renderDistance;
+		return glm::length2(chunkMiddle - camChunkMiddle) <= distance * distance;
 	}
 
-	bool World::isChunkLoading(ChunkID chunkID) const
+	void World::resizeChunkStorage()
 	{
-		return m_loadingChunks.contains(chunkID);
+		// Everything kept by the unload distance plus what can be generating at once, prefetching past that grows the pool
+		// & ends up in the fallback tables of the indices
+		int unloadDistance = (int)getUnloadDistance();
+		uint32_t numChunks = 0;
+
+		for (int chunkX = -unloadDistance; chunkX <= unloadDistance; chunkX++)
+		{
+			for (int chunkZ = -unloadDistance; chunkZ <= unloadDistance; chunkZ++)
+				numChunks += chunkX * chunkX + chunkZ * chunkZ <= unloadDistance * unloadDistance;
+		}
+
+		m_chunkPool.reserve(numChunks + MAX_LOADING_CHUNKS);
+
+		// Structures are loaded one chunk past the generated ones
+		uint32_t windowWidth = (uint32_t)unloadDistance * 2 + 1;
+		m_loadedChunks.setWindowWidth(windowWidth);
+		m_loadingChunks.setWindowWidth(windowWidth);
+		m_chunksStructures.setWindowWidth(windowWidth + 2);
+		m_prefetchedChunks.setWindowWidth(windowWidth);
+
+		// Chunks further away than twice the unload distance can't come back before the camera has moved a long way, which isn't thrashing
+		m_unloadedChunkGridWidth = std::bit_ceil(windowWidth * 2);
+		m_unloadedChunkCells.assign((size_t)m_unloadedChunkGridWidth * m_unloadedChunkGridWidth, INVALID_CHUNK_ID);
 	}
 
-	bool World::isChunkInView(const Camera& camera, ChunkID chunkID) const
+	bool World::shouldKeepChunk(ChunkID chunkID) const
 	{
-		glm::vec3 chunkExtents = glm::vec3(CHUNK_WIDTH, WORLD_HEIGHT, CHUNK_WIDTH) * 0.5f;
-		glm::vec3 chunkCenter = chunkCoordToWorldCoord(chunkIDToChunkCoord(chunkID));
-		chunkCenter += chunkExtents;
+		if (isChunkWithinDistance(chunkID, getUnloadDistance()))
+			return true;
+
+		if (!m_prefetchData.enabled)
+			return false;
 
-		Collision::AABB chunkBox = Collision::createAABB(chunkCenter, chunkExtents);
-		return Collision::frustumAABB(camera.frustum, chunkBox);
+		glm::vec2 prefetchOffset = glm::vec2(chunkIDToChunkCoord(chunkID) - m_prefetchChunkCoord);
+		return glm::length2(prefetchOffset) <= m_renderDistance * m_renderDistance;
+	}
+
+	ChunkID& World::getUnloadedChunkCell(ChunkID chunkID)
+	{
+		// Same split as ChunkIndex
+		uint32_t mask = m_unloadedChunkGridWidth - 1;
+		uint32_t cellX = uint32_t(chunkID % WORLD_CHUNK_WIDTH) & mask;
+		uint32_t cellZ = uint32_t(chunkID / WORLD_CHUNK_WIDTH) & mask;
+
+		return m_unloadedChunkCells[cellX + cellZ * m_unloadedChunkGridWidth];
+	}
+
+		void World::countPrefetchMiss(ChunkID chunkID)
+	{
+		if (!m_prefetchedChunks.empty() && m_prefetchedChunks.remove(chunkID))
+			m_numPrefetchMisses++;
+	}
+
+	bool World::isChunkLoading(ChunkID chunkID) const
+	{
+		return m_loadingChunks.contains(chunkID);
 	}
 
 	const std::vector<ChunkID>& World::getAddedChunks() const
@@ -512,7 +627,7 @@ namespace Okay
 	void World::generateChunk(ChunkGeneration* pChunkGeneration)
 	{
 		ChunkID chunkID = pChunkGeneration->chunkID;
-		Chunk& chunk = pChunkGeneration->chunk;
+		Chunk& chunk = *pChunkGeneration->pChunk;
 
 		for (uint32_t i = 0; i < MAX_BLOCKS_IN_CHUNK; i++)
 		{
@@ -535,8 +650,22 @@ namespace Okay
 			}
 		}
 
-		ChunkGeneration& chunkGeneration = m_loadingChunks[chunkID];
+		ChunkID& unloadedCell = getUnloadedChunkCell(chunkID);
+		if (unloadedCell == chunkID)
+		{
+			unloadedCell = INVALID_CHUNK_ID;
+			m_numRegeneratedChunks++;
+		}
+
+		OKAY_ASSERT(!m_freeChunkGenerations.empty());
+		uint32_t generationIdx = m_freeChunkGenerations.back();
+		m_freeChunkGenerations.pop_back();
+		m_loadingChunks.getOrInsert(chunkID) = generationIdx;
+
+		ChunkGeneration& chunkGeneration = m_chunkGenerations[generationIdx];
 		chunkGeneration.chunkID = chunkID;
+		chunkGeneration.chunkHandle = m_chunkPool.allocate();
+		chunkGeneration.pChunk = &m_chunkPool.get(chunkGeneration.chunkHandle);
 		chunkGeneration.threadFinished.store(false);
 
 		ChunkGeneration* pChunkGeneration = &chunkGeneration;
@@ -6,6 +6,10 @@
 #include "Engine/Utilities/ThreadPool.h"
 #include "Engine/Application/Time.h"
 #include "Structure.h"
+#include "FarTerrain.h"
+#include "CloudField.h"
+#include "ChunkPool.h"
+#include "ChunkIndex.h"
 
 #include <atomic>
 #include <unordered_map>
@@ -16,30 +20,8 @@ namespace Okay
 	{
 		std::atomic<bool> threadFinished;
 		ChunkID chunkID = INVALID_CHUNK_ID;
-		Chunk chunk;
-	};
-
-	struct CloudGenerationData
-	{
-		static const float UPDATE_INTERVAL;
-		float updateTimer = UPDATE_INTERVAL;
-
-		std::vector<glm::vec3> cloudList;
-
-		Noise::SamplingData cloudNoise;
-		Noise::SamplingData maskNoise;
-
-		glm::vec2 velocity = glm::vec2(1.f, 1.f);
-		glm::vec2 localDrift = glm::vec2(FLT_MAX);
-		glm::vec2 globalDrift = glm::vec2(0.f);
-
-		uint32_t spawnHeight = 200;
-		float scale = 9.f;
-		float height = 100.f;
-		float maxOffset = 6.f;
-		float sampleDistance = 8.f;
-		uint32_t chunkVisiblityDistance = 32;
-		glm::vec4 colour = glm::vec4(248.f, 255.f, 255.f, 95.f) / (float)UCHAR_MAX;
+		ChunkHandle chunkHandle = INVALID_CHUNK_HANDLE; // Owned until the chunk is loaded or discarded
+		Chunk* pChunk = nullptr;
 	};
 
 	struct WorldGenerationData
@@ -59,6 +41,15 @@ namespace Okay
 		uint32_t treeMaxSpawnAltitude = 90;
 	};
 
+	// Generates chunks ahead of a moving camera, after everything within the render distance has been queued
+	struct ChunkPrefetchData
+	{
+		bool enabled = true;
+		float lookAheadTime = 1.f; // Seconds of movement to prefetch for
+		float minSpeed = 20.f; // Blocks per second, slower cameras get there before prefetching would help
+		float lookDirectionWeight = 0.5f; // 0 follows the velocity, 1 the horizontal look direction, which is where the camera will move next
+	};
+
 	class Window;
 	struct Camera;
 
@@ -80,6 +71,7 @@ namespace Okay
 		bool isBlockCoordSolid(const glm::ivec3& blockCoord) const;
 
 		BlockType generateBlock(const glm::ivec3& blockCoord);
+		uint32_t findColoumnHeight(const glm::ivec3& blockCoordXZ);
 
 		Chunk& getChunk(ChunkID chunkID);
 		const Chunk& getChunkConst(ChunkID chunkID) const;
@@ -94,17 +86,34 @@ namespace Okay
 		void resetWorld();
 
 		void recreateClouds();
-		const std::vector<glm::vec3>& getCloudList() const;
+		const CloudField& getCloudField() const;
+
+		// Distance from the camera where the far terrain takes over from the voxels
+		float getFarTerrainInnerRadius() const;
+
+		// Chunks are loaded within m_renderDistance but only unloaded beyond this, so crossing a chunk border back & forth doesn't regenerate a ring
+		uint32_t getUnloadDistance() const;
+
+		// Chunks generated again after being unloaded, which the unload margin is meant to keep low
+		uint32_t getNumRegeneratedChunks() const;
+
+		const ChunkPool& getChunkPool() const;
+
+		// A prefetched chunk is a hit if it comes within the render distance before being unloaded
+		uint32_t getNumPrefetchHits() const;
+		uint32_t getNumPrefetchMisses() const;
 
 		WorldGenerationData m_worldGenData;
 		CloudGenerationData m_cloudGenData;
+		FarTerrain m_farTerrain;
 		uint32_t m_renderDistance = 32;
+		uint32_t m_unloadDistanceMargin = 3;
+		ChunkPrefetchData m_prefetchData;
 
 	private:
 		void launchChunkGenerationThread(ChunkID chunkID);
 		void generateChunk(ChunkGeneration* pChunkGeneration);
 		bool shouldPlaceTree(const glm::ivec3& blockCoordXZ) const;
-		uint32_t findColoumnHeight(const glm::ivec3& blockCoordXZ);
 
 		void loadChunkStructures(ChunkID chunkID);
 		BlockType searchChunkForStructure(ChunkID chunkID, const glm::ivec3& blockCoord) const;
@@ -113,27 +122,72 @@ namespace Okay
 		void clearUpdatedChunks();
 		void unloadDistantChunks();
 		void processLoadingChunks();
-		void tryLoadRenderEligableChunks(const Camera& camera);
-
-		bool isChunkWithinRenderDistance(ChunkID chunkID) const;
+		void tryLoadRenderEligableChunks();
+		void tryPrefetchChunks(uint32_t& numChecks);
+		void updateLoadOrder();
+		void resizeChunkStorage();
+		void updatePrefetchChunkCoord(const Camera& camera, TimeStep dt);
+
+		bool isChunkWithinDistance(ChunkID chunkID, uint32_t distance) const;
+		bool shouldKeepChunk(ChunkID chunkID) const;
+		ChunkID& getUnloadedChunkCell(ChunkID chunkID);
+		void countPrefetchMiss(ChunkID chunkID);
 		bool isChunkLoading(ChunkID chunkID) const;
 
-		bool isChunkInView(const Camera& camera, ChunkID chunkID) const;
-
 		void updateClouds(const Camera& camera, TimeStep dt);
-		void generateCloudList(const Camera& camera);
-		void clearDistanceClouds(const Camera& camera);
-		void sampleCloud(float x, float z);
 
 	private:
 		ThreadPool m_threadPool;
+		CloudField m_cloudField;
 
 		glm::ivec2 m_currentCamChunkCoord = glm::ivec2(0, 0);
 		float m_aspectRatio = 0.f;
 
-		std::unordered_map<ChunkID, Chunk> m_loadedChunks;
-		std::unordered_map<ChunkID, ChunkGeneration> m_loadingChunks;
-		std::unordered_map<ChunkID, ChunkStructures> m_chunksStructures;
+		/*
+			Chunk offsets within the render distance sorted closest first, only rebuilt when the render distance changes.
+			The cursor walks them relative to the camera chunk & restarts when that changes, every offset before it is already loaded or loading.
+			Generation is capped so a far ring queued before the camera moved can't hold up the chunks closest to it
+		*/
+		static const uint32_t MAX_LOADING_CHUNKS = 64;
+		static const uint32_t MAX_LOAD_CHECKS_PER_UPDATE = 1024;
+
+		std::vector<glm::ivec2> m_loadOrder;
+		uint32_t m_loadOrderRenderDistance = INVALID_UINT32;
+		glm::ivec2 m_loadOrderCamChunkCoord = glm::ivec2(INT_MAX);
+		uint32_t m_loadCursor = 0;
+
+		// Unloading only happens when the camera chunk, the prefetch chunk or the unload distance changes
+		glm::ivec2 m_unloadCamChunkCoord = glm::ivec2(INT_MAX);
+		glm::ivec2 m_unloadPrefetchChunkCoord = glm::ivec2(INT_MAX);
+		uint32_t m_lastUnloadDistance = INVALID_UINT32;
+
+		// Recently unloaded chunks, used to count regenerations. A toroidal grid twice the unload distance wide where chunk (x, z) uses cell
+		// (x mod width, z mod width), so entries expire when a chunk far enough away to share the cell is unloaded
+		std::vector<ChunkID> m_unloadedChunkCells;
+		uint32_t m_unloadedChunkGridWidth = 0;
+		uint32_t m_numRegeneratedChunks = 0;
+
+		// Where the camera is predicted to be, chunks within the render distance of it are prefetched with their own cursor into m_loadOrder
+		glm::vec3 m_lastCameraPos = glm::vec3(0.f);
+		glm::vec3 m_cameraVelocity = glm::vec3(0.f);
+		bool m_hasLastCameraPos = false;
+		glm::ivec2 m_prefetchChunkCoord = glm::ivec2(0, 0);
+		glm::ivec2 m_prefetchCursorCamChunkCoord = glm::ivec2(INT_MAX);
+		glm::ivec2 m_prefetchCursorChunkCoord = glm::ivec2(INT_MAX);
+		uint32_t m_prefetchCursor = 0;
+
+		ChunkIndex<uint8_t> m_prefetchedChunks; // Loading or loaded but not yet within the render distance, the value is unused
+		uint32_t m_numPrefetchHits = 0;
+		uint32_t m_numPrefetchMisses = 0;
+
+		ChunkPool m_chunkPool;
+		ChunkIndex<ChunkHandle> m_loadedChunks;
+		ChunkIndex<uint32_t> m_loadingChunks; // Index into m_chunkGenerations
+		ChunkIndex<ChunkStructures> m_chunksStructures;
+
+		// Jobs write into these while running, so they stay where they are instead of living in m_loadingChunks
+		ChunkGeneration m_chunkGenerations[MAX_LOADING_CHUNKS];
+		std::vector<uint32_t> m_freeChunkGenerations;
 
 		std::vector<ChunkID> m_addedChunks;
 		std::vector<ChunkID> m_removedChunks;
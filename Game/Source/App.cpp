@@ -133,6 +133,65 @@ void App::handleImgui()
 		ImGui::Separator();
 		
 		ImGui::DragInt("Render Distance", (int*)&m_world.m_renderDistance, 0.075f, 0, INT_MAX);
+		ImGui::DragInt("Unload Distance Margin", (int*)&m_world.m_unloadDistanceMargin, 0.075f, 0, INT_MAX);
+		ImGui::Text("Regenerated Chunks: %u", m_world.getNumRegeneratedChunks());
+
+		const ChunkPool& chunkPool = m_world.getChunkPool();
+		ImGui::Text("Chunk Pool: %u / %u, %u pages allocated", chunkPool.getNumUsed(), chunkPool.getCapacity(), chunkPool.getNumPageAllocations());
+
+		ImGui::Checkbox("Prefetch Chunks", &m_world.m_prefetchData.enabled);
+		ImGui::DragFloat("Prefetch Look Ahead (s)", &m_world.m_prefetchData.lookAheadTime, 0.01f, 0.f, FLT_MAX, "%.2f", ImGuiSliderFlags_AlwaysClamp);
+		ImGui::SliderFloat("Prefetch Look Direction Weight", &m_world.m_prefetchData.lookDirectionWeight, 0.f, 1.f);
+
+		uint32_t numPrefetchResults = m_world.getNumPrefetchHits() + m_world.getNumPrefetchMisses();
+		float prefetchHitRate = numPrefetchResults ? m_world.getNumPrefetchHits() / (float)numPrefetchResults * 100.f : 0.f;
+		ImGui::Text("Prefetch Hit Rate: %.1f%% (%u hits, %u misses)", prefetchHitRate, m_world.getNumPrefetchHits(), m_world.getNumPrefetchMisses());
+		ImGui::DragInt3("LOD Distances", (int*)m_renderer.m_lodData.levelDistances, 0.075f, 0, INT_MAX);
+		ImGui::Checkbox("Far Terrain", &m_world.m_farTerrain.m_enabled);
+		ImGui::Text("Far Terrain Samples Updated: %u", m_world.m_farTerrain.getNumSamplesUpdated());
+
+		const RenderStatistics& renderStats = m_renderer.getRenderStatistics();
+		ImGui::Checkbox("Frustum Culling", &m_renderer.m_frustumCulling);
+		ImGui::Text("Visible Chunks: %u, Culled: %u", renderStats.numVisibleChunks, renderStats.numCulledChunks);
+		ImGui::Checkbox("Cave Culling", &m_renderer.m_caveCulling);
+		ImGui::Text("Cave Culled Chunks: %u", renderStats.numCaveCulledChunks);
+		ImGui::Checkbox("Occlusion Culling", &m_renderer.m_occlusionData.enabled);
+		ImGui::DragFloat("Occlusion Budget (ms)", &m_renderer.m_occlusionData.timeBudgetMS, 0.01f, 0.f, 16.f);
+		ImGui::Text("Occluded Chunks: %u", renderStats.numOccludedChunks);
+		ImGui::Text("Occluders Rasterized: %u / %u", renderStats.numRasterizedOccluders, renderStats.numOccluders);
+		ImGui::Checkbox("Indirect Drawing", &m_renderer.m_indirectDrawing);
+		ImGui::Checkbox("Region Batching", &m_renderer.m_regionBatching.enabled);
+		ImGui::Text("Draws: %u, Draw Calls: %u, Regions: %u", renderStats.numDraws, renderStats.numDrawCalls, renderStats.numDrawnRegions);
+		ImGui::Checkbox("Multithreaded Recording", &m_renderer.m_drawRecordingData.multithreaded);
+		ImGui::Checkbox("Sort Draws", &m_renderer.m_sortDraws);
+		ImGui::Text("Draw Submit Time: %.3fms, Threads: %u", renderStats.submitTimeMS, renderStats.numRecordingThreads);
+		ImGui::Text("Draw Sort Time: %.3fms", renderStats.sortTimeMS);
+
+		ImGui::Separator();
+
+		ImGui::Checkbox("Defragment Mesh Arenas", &m_renderer.m_defragData.enabled);
+		ImGui::DragInt("Defrag Bytes Per Frame", (int*)&m_renderer.m_defragData.bytesPerFrame, 1000.f, 0, INT_MAX);
+		ImGui::DragFloat("Min Fragmentation", &m_renderer.m_defragData.minFragmentation, 0.01f, 0.f, 1.f);
+		ImGui::Text("Defragmented Bytes: %llu", m_renderer.getNumDefragmentedBytes());
+
+		auto displayArenaStats = [](const char* pName, const ResourceArenaStatistics& stats)
+		{
+			ImGui::Text("%s: %.2f / %.2f MB free (%u pages), largest block %.2f MB, fragmentation %.1f%%", pName,
+				stats.totalFreeSize / 1'000'000.f, stats.size / 1'000'000.f, stats.numPages, stats.largestFreeSize / 1'000'000.f, stats.fragmentation * 100.f);
+		};
+
+		displayArenaStats("Vertex Arena", m_renderer.getVertexArenaStatistics());
+		displayArenaStats("Index Arena", m_renderer.getIndexArenaStatistics());
+
+		ImGui::Separator();
+
+		ImGui::DragInt("Upload Bytes Per Frame", (int*)&m_renderer.m_uploadData.bytesPerFrame, 1000.f, 0, INT_MAX);
+		ImGui::Checkbox("Upload On Copy Queue", &m_renderer.m_uploadData.useCopyQueue);
+		ImGui::Text("Pending Uploads: %u (%.2f MB)", m_renderer.getNumPendingUploads(), m_renderer.getNumPendingUploadBytes() / 1'000'000.f);
+		ImGui::Text("Uploaded: %.2f MB", m_renderer.getNumUploadedBytes() / 1'000'000.f);
+
+		const RingBuffer& ringBuffer = m_renderer.getRingBuffer();
+		ImGui::Text("Upload Ring Buffer: %.2f / %.2f MB, %u stalls", ringBuffer.getUsedSize() / 1'000'000.f, ringBuffer.getSize() / 1'000'000.f, ringBuffer.getNumStalls());
 	}
 	ImGui::End();
 
@@ -144,14 +203,22 @@ void App::handleImgui()
 
 		ImGui::DragFloat2("Velocity", glm::value_ptr(m_world.m_cloudGenData.velocity), 0.1f);
 
-		ImGui::DragInt("spawnHeight", (int*)&m_world.m_cloudGenData.spawnHeight, 0.1f);
-		ImGui::DragFloat("Scale", &m_world.m_cloudGenData.scale, 0.01f);
+		update |= ImGui::DragInt("spawnHeight", (int*)&m_world.m_cloudGenData.spawnHeight, 0.1f);
 		update |= ImGui::DragFloat("Height", &m_world.m_cloudGenData.height, 0.01f);
+		// Meshed clouds are grid aligned quads, so the per point size & offset don't apply
+		ImGui::BeginDisabled(m_renderer.m_meshedClouds);
+		ImGui::DragFloat("Scale", &m_world.m_cloudGenData.scale, 0.01f);
 		update |= ImGui::DragFloat("Max Offset", &m_world.m_cloudGenData.maxOffset, 0.01f);
+		ImGui::EndDisabled();
 		update |= ImGui::DragFloat("Sample Distance", &m_world.m_cloudGenData.sampleDistance, 0.01f, 1.f, FLT_MAX, "%.3f", ImGuiSliderFlags_AlwaysClamp);
 		update |= ImGui::DragInt("Visibilty Distance (chunks)", (int*)&m_world.m_cloudGenData.chunkVisiblityDistance, 0.1f);
 		ImGui::ColorEdit4("Colour", glm::value_ptr(m_world.m_cloudGenData.colour));
 
+		const CloudField& cloudField = m_world.getCloudField();
+		ImGui::Checkbox("Meshed", &m_renderer.m_meshedClouds);
+		ImGui::Text("Points: %u, Quads: %u, Cells Updated: %u%s", (uint32_t)cloudField.getInstances().size(), (uint32_t)cloudField.getQuadInstances().size(),
+			cloudField.getNumCellsUpdated(), cloudField.isRebuilding() ? " (Rebuilding)" : "");
+
 		ImGui::Separator();
 		
 		ImGui::Text("Placement");
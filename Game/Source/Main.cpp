@@ -1,11 +1,381 @@
 
 #include "App.h"
+#include "Tests.h"
+#include "Engine/World/TextureSheet.h"
+#include "Engine/World/ChunkIndex.h"
+#include "Engine/Application/Time.h"
 
-int main()
+#include <string_view>
+#include <cfloat>
+#include <unordered_map>
+#include <unordered_set>
+
+static const char* getFormatName(Okay::TextureSheetFormat format)
+{
+	switch (format)
+	{
+	case Okay::TextureSheetFormat::BC1:
+		return "BC1";
+
+	case Okay::TextureSheetFormat::BC3:
+		return "BC3";
+
+	default:
+		return "RGBA8";
+	}
+}
+
+// Headless, bakes the texture sheet cache without creating a window or device & reports how much the compression cost.
+// Optional arguments: rgba8 / bc1 / bc3 for the format and fast / high for the encoder quality
+static int bakeTextures(int argc, char** argv)
+{
+	Okay::TextureSheetBakeSettings settings;
+	for (int i = 2; i < argc; i++)
+	{
+		std::string_view arg = argv[i];
+
+		if (arg == "rgba8")
+			settings.format = Okay::TextureSheetFormat::RGBA8;
+		else if (arg == "bc1")
+			settings.format = Okay::TextureSheetFormat::BC1;
+		else if (arg == "bc3")
+			settings.format = Okay::TextureSheetFormat::BC3;
+		else if (arg == "fast")
+			settings.quality = Okay::BCQuality::FAST;
+		else if (arg == "high")
+			settings.quality = Okay::BCQuality::HIGH;
+		else
+		{
+			printf("Unknown bake argument: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	Okay::Timer timer;
+	std::vector<Okay::TextureQuality> quality;
+
+	Okay::TextureSheet textureSheet;
+	textureSheet.bake(settings, &quality);
+
+	float bakeTimeMS = timer.measure() * 1000.f;
+
+	float minPSNR = FLT_MAX;
+	for (const Okay::TextureQuality& texture : quality)
+	{
+		minPSNR = glm::min(minPSNR, texture.psnr);
+
+		if (texture.psnr == FLT_MAX)
+			printf("  %-24s exact\n", texture.textureName.c_str());
+		else
+			printf("  %-24s %.2f dB\n", texture.textureName.c_str(), texture.psnr);
+	}
+
+	if (!textureSheet.writeCache(Okay::TEXTURE_SHEET_CACHE_PATH))
+	{
+		printf("Failed to write the texture sheet cache: %s\n", Okay::TEXTURE_SHEET_CACHE_PATH.string().c_str());
+		return 1;
+	}
+
+	printf("Baked %ux%u %s texture sheet with %u mips in %.1f ms: %s\n", textureSheet.getWidth(), textureSheet.getHeight(),
+		getFormatName(textureSheet.getFormat()), textureSheet.getNumMips(), bakeTimeMS, Okay::TEXTURE_SHEET_CACHE_PATH.string().c_str());
+
+	if (minPSNR != FLT_MAX)
+		printf("Lowest PSNR: %.2f dB\n", minPSNR);
+
+	return 0;
+}
+
+// Looks up the chunks over & over until at least minLookups are done & returns nanoseconds per lookup, the values are summed so the lookups can't be skipped
+template<typename LookupFunc>
+static float timeChunkLookups(const std::vector<Okay::ChunkID>& chunkIDs, uint32_t minLookups, uint64_t& outSum, LookupFunc lookup)
+{
+	uint64_t numLookups = 0;
+
+	Okay::Timer timer;
+	while (numLookups < minLookups)
+	{
+		for (Okay::ChunkID chunkID : chunkIDs)
+			outSum += lookup(chunkID);
+
+		numLookups += chunkIDs.size();
+	}
+
+	return (float)timer.measure() * 1e9f / (float)numLookups;
+}
+
+// Headless, compares the lookup throughput of ChunkIndex against the std::unordered_map the world used to store chunks in.
+// Filled like the world with the default unload distance, then looked up with a few access patterns
+static int benchmarkChunkIndex()
+{
+	const int loadedRadius = 35;
+	const uint32_t numLookups = 20'000'000;
+
+	Okay::ChunkIndex<uint32_t> chunkIndex;
+	chunkIndex.setWindowWidth(loadedRadius * 2 + 1);
+
+	std::unordered_map<Okay::ChunkID, uint32_t> chunkMap;
+
+	for (int chunkX = -loadedRadius; chunkX <= loadedRadius; chunkX++)
+	{
+		for (int chunkZ = -loadedRadius; chunkZ <= loadedRadius; chunkZ++)
+		{
+			if (chunkX * chunkX + chunkZ * chunkZ > loadedRadius * loadedRadius)
+				continue;
+
+			// Numbered from 1 so a hit never looks like a miss
+			Okay::ChunkID chunkID = Okay::chunkCoordToChunkID(glm::ivec2(chunkX, chunkZ));
+			uint32_t value = (uint32_t)chunkMap.size() + 1;
+
+			chunkIndex.getOrInsert(chunkID) = value;
+			chunkMap[chunkID] = value;
+		}
+	}
+
+	// Meshing style (a chunk & its 4 neighbours, moving along a row), random loaded chunks & random chunks where a fifth is missing
+	std::vector<Okay::ChunkID> patterns[3];
+	const char* patternNames[3] = { "Neighbours", "Random hits", "Random mixed" };
+
+	for (int chunkX = -loadedRadius / 2; chunkX <= loadedRadius / 2; chunkX++)
+	{
+		for (const glm::ivec2& offset : { glm::ivec2(0, 0), glm::ivec2(1, 0), glm::ivec2(-1, 0), glm::ivec2(0, 1), glm::ivec2(0, -1) })
+			patterns[0].emplace_back(Okay::chunkCoordToChunkID(glm::ivec2(chunkX, 0) + offset));
+	}
+
+	for (uint32_t i = 0; i < 1'000'000; i++)
+	{
+		glm::ivec2 chunkCoord = glm::ivec2(rand() % (loadedRadius * 2 + 1), rand() % (loadedRadius * 2 + 1)) - loadedRadius;
+		Okay::ChunkID chunkID = Okay::chunkCoordToChunkID(chunkCoord);
+
+		if (chunkCoord.x * chunkCoord.x + chunkCoord.y * chunkCoord.y <= loadedRadius * loadedRadius)
+			patterns[1].emplace_back(chunkID);
+
+		patterns[2].emplace_back(chunkID);
+	}
+
+	bool sumsMatch = true;
+	printf("%u chunks, %u lookups per pattern, %u fallback entries\n", chunkIndex.size(), numLookups, chunkIndex.getNumFallbackEntries());
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		uint64_t mapSum = 0;
+		uint64_t indexSum = 0;
+
+		float mapNS = timeChunkLookups(patterns[i], numLookups, mapSum, [&](Okay::ChunkID chunkID)
+		{
+			auto iterator = chunkMap.find(chunkID);
+			return iterator == chunkMap.end() ? 0u : iterator->second;
+		});
+
+		float indexNS = timeChunkLookups(patterns[i], numLookups, indexSum, [&](Okay::ChunkID chunkID)
+		{
+			const uint32_t* pValue = chunkIndex.tryGet(chunkID);
+			return pValue ? *pValue : 0u;
+		});
+
+		printf("  %-14s unordered_map %.2f ns, ChunkIndex %.2f ns (%.2fx)\n", patternNames[i], mapNS, indexNS, mapNS / indexNS);
+
+		// Both are looked up the same number of times, so any difference is a lookup finding the wrong value
+		if (mapSum != indexSum)
+		{
+			printf("  %-14s checksum mismatch: unordered_map %llu, ChunkIndex %llu\n", patternNames[i], (unsigned long long)mapSum, (unsigned long long)indexSum);
+			sumsMatch = false;
+		}
+	}
+
+	return sumsMatch ? 0 : 1;
+}
+
+// Headless, compares the CPU side of the voxel draws with & without region batching.
+// A disc of visible chunks is turned into draws the way Renderer::renderWorld does it, then sorted, partitioned & copied like the indirect arguments
+static int benchmarkRegionBatching()
+{
+	using namespace Okay;
+
+	const int visibleRadius = 24;
+	const uint32_t numFrames = 200;
+	const uint32_t numPasses = (uint32_t)VoxelPass::NUM_PASSES;
+	const int regionWidth = (int)RegionBatchingData::REGION_CHUNK_WIDTH;
+
+	struct BenchmarkChunk
+	{
+		ChunkID chunkID = INVALID_CHUNK_ID;
+		glm::vec3 worldPos = glm::vec3(0.f);
+		float depth = 0.f;
+		uint32_t numVertices[numPasses] = {};
+	};
+
+	struct BenchmarkRegion
+	{
+		std::vector<GPUDrawCallData> members[numPasses];
+		uint32_t numVertices[numPasses] = {};
+	};
+
+	// Block meshes from bare hills to busy surfaces, water in some chunks. Vertices are drawn without sharing, so indices match vertices
+	std::vector<BenchmarkChunk> chunks;
+	std::unordered_map<uint64_t, BenchmarkRegion> regions;
+
+	srand(1);
+	for (int chunkX = -visibleRadius; chunkX <= visibleRadius; chunkX++)
+	{
+		for (int chunkZ = -visibleRadius; chunkZ <= visibleRadius; chunkZ++)
+		{
+			if (chunkX * chunkX + chunkZ * chunkZ > visibleRadius * visibleRadius)
+				continue;
+
+			BenchmarkChunk& chunk = chunks.emplace_back();
+			chunk.chunkID = chunkCoordToChunkID(glm::ivec2(chunkX, chunkZ));
+			chunk.worldPos = glm::vec3(chunkCoordToWorldCoord(glm::ivec2(chunkX, chunkZ)));
+			chunk.depth = glm::length(chunk.worldPos);
+			chunk.numVertices[(uint32_t)VoxelPass::BLOCKS] = 6 * (50 + rand() % 800);
+			chunk.numVertices[(uint32_t)VoxelPass::WATER] = rand() % 5 < 2 ? 6 * (rand() % 250) : 0;
+
+			glm::ivec2 regionCoord = glm::ivec2(glm::floor(glm::vec2((float)chunkX, (float)chunkZ) / (float)regionWidth));
+			BenchmarkRegion& region = regions[chunkCoordToChunkID(regionCoord)];
+
+			for (uint32_t pass = 0; pass < numPasses; pass++)
+			{
+				uint32_t numVertices = chunk.numVertices[pass];
+				if (!numVertices || numVertices > RegionBatchingData::MAX_BATCHED_VERTICES)
+					continue;
+
+				region.numVertices[pass] += numVertices;
+
+				GPUDrawCallData& member = region.members[pass].emplace_back();
+				member.chunkWorldPos = chunk.worldPos;
+				member.vertexEnd = region.numVertices[pass];
+			}
+		}
+	}
+
+	VoxelDrawList drawList;
+	std::unordered_set<uint64_t> visibleRegions;
+	std::vector<VoxelDrawRange> drawRanges;
+	std::vector<IndirectDrawArguments> indirectArguments;
+
+	printf("%u visible chunks, %u regions, %u frames\n", (uint32_t)chunks.size(), (uint32_t)regions.size(), numFrames);
+
+	uint64_t checksums[2] = {};
+	for (bool batching : { false, true })
+	{
+		uint32_t numPartitions = 0;
+		uint64_t& checksum = checksums[batching];
+
+		Timer timer;
+		for (uint32_t frame = 0; frame < numFrames; frame++)
+		{
+			drawList.clear();
+			visibleRegions.clear();
+
+			for (const BenchmarkChunk& chunk : chunks)
+			{
+				uint32_t drawIdx = INVALID_UINT32;
+				for (uint32_t pass = 0; pass < numPasses; pass++)
+				{
+					uint32_t numVertices = chunk.numVertices[pass];
+					if (batching && numVertices && numVertices <= RegionBatchingData::MAX_BATCHED_VERTICES)
+					{
+						glm::ivec2 chunkCoord = chunkIDToChunkCoord(chunk.chunkID);
+						visibleRegions.insert(chunkCoordToChunkID(glm::ivec2(glm::floor(glm::vec2(chunkCoord) / (float)regionWidth))));
+						continue;
+					}
+
+					if (drawIdx == INVALID_UINT32)
+						drawIdx = drawList.addDrawData(chunk.worldPos);
+
+					drawList.addDraw((VoxelPass)pass, drawIdx, 0, D3D12_INDEX_BUFFER_VIEW(), numVertices, chunk.depth);
+				}
+			}
+
+			for (uint64_t regionID : visibleRegions)
+			{
+				const BenchmarkRegion& region = regions[regionID];
+				float regionDepth = glm::length(glm::vec2(chunkIDToChunkCoord(regionID)) * (float)(regionWidth * CHUNK_WIDTH));
+
+				for (uint32_t pass = 0; pass < numPasses; pass++)
+				{
+					if (region.members[pass].empty())
+						continue;
+
+					uint32_t firstDrawIdx = (uint32_t)drawList.getDrawData().size();
+					for (const GPUDrawCallData& member : region.members[pass])
+						drawList.addDrawData(member.chunkWorldPos, member.vertexEnd);
+
+					drawList.addDraw((VoxelPass)pass, firstDrawIdx, 0, D3D12_INDEX_BUFFER_VIEW(), region.numVertices[pass], regionDepth, (uint32_t)region.members[pass].size());
+				}
+			}
+
+			drawList.sortDraws();
+			numPartitions = drawList.partitionDraws(DrawRecordingData::NUM_THREADS, DrawRecordingData::MIN_DRAWS_PER_THREAD, drawRanges);
+
+			// Stands in for the copy into the ring buffer, the draws are recorded from these
+			indirectArguments.clear();
+			for (uint32_t pass = 0; pass < numPasses; pass++)
+			{
+				const std::vector<IndirectDrawArguments>& draws = drawList.getDraws((VoxelPass)pass);
+				indirectArguments.insert(indirectArguments.end(), draws.begin(), draws.end());
+			}
+
+			for (const IndirectDrawArguments& draw : indirectArguments)
+				checksum += draw.drawArguments.IndexCountPerInstance;
+		}
+
+		float frameMS = timer.measure() * 1000.f / (float)numFrames;
+
+		printf("  %-12s %5u draws, %5u draw data, %u partitions, %.3f ms per frame (checksum %llu)\n", batching ? "Batched" : "Unbatched",
+			drawList.getNumDraws(), (uint32_t)drawList.getDrawData().size(), numPartitions, frameMS, (unsigned long long)(checksum / numFrames));
+	}
+
+	// Both ways have to draw the same indices
+	if (checksums[0] != checksums[1])
+	{
+		printf("Index count mismatch\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
 {
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 	srand((uint32_t)time(nullptr));
 
+	if (argc > 1 && std::string_view(argv[1]) == "--bake-textures")
+		return bakeTextures(argc, argv);
+
+	if (argc > 1 && std::string_view(argv[1]) == "--bench-chunk-index")
+		return benchmarkChunkIndex();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--bench-region-batching")
+		return benchmarkRegionBatching();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-upload-scheduler")
+		return testUploadScheduler();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-ring-allocator")
+		return testRingAllocator();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-tlsf-allocator")
+		return testTLSFAllocator();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-paged-allocator")
+		return testPagedAllocator();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-occlusion-buffer")
+		return testOcclusionBuffer();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-block-compression")
+		return testBlockCompression();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-render-queue")
+		return testRenderQueue();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-voxel-draw-list")
+		return testVoxelDrawList();
+
+	if (argc > 1 && std::string_view(argv[1]) == "--test-draw-partitioning")
+		return testDrawPartitioning();
+
 	App voxelWorld;
 	voxelWorld.run();
 
@@ -0,0 +1,984 @@
+#include "Tests.h"
+#include "Engine/Utilities/UploadScheduler.h"
+#include "Engine/Utilities/RingAllocator.h"
+#include "Engine/Utilities/TLSFAllocator.h"
+#include "Engine/Utilities/PagedAllocator.h"
+#include "Engine/Utilities/OcclusionBuffer.h"
+#include "Engine/Utilities/BlockCompression.h"
+#include "Engine/Utilities/RenderQueue.h"
+#include "Engine/D3D12/VoxelDrawList.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <map>
+#include <deque>
+#include <cfloat>
+#include <cstdio>
+#include <cstddef>
+#include <algorithm>
+#include <bit>
+
+// Prints the failed condition & keeps going so one run reports everything that's broken
+#define TEST_CHECK(condition) if (!(condition)) { printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition); numFailed++; }
+
+static int reportResult(const char* testName, uint32_t numFailed)
+{
+	if (numFailed)
+		printf("%s: %u checks failed\n", testName, numFailed);
+	else
+		printf("%s: passed\n", testName);
+
+	return numFailed ? 1 : 0;
+}
+
+int testUploadScheduler()
+{
+	uint32_t numFailed = 0;
+
+	Okay::UploadScheduler scheduler;
+	std::vector<uint64_t> keys;
+
+	auto keyPriority = [](uint64_t key) { return (float)key; };
+	auto reversePriority = [](uint64_t key) { return -(float)key; };
+
+	// Budget, uploads are taken in priority order until the next one doesn't fit
+	for (uint64_t key = 1; key <= 4; key++)
+		scheduler.push(key, 100);
+
+	TEST_CHECK(scheduler.getNumPending() == 4 && scheduler.getNumPendingBytes() == 400);
+
+	scheduler.schedule(250, keyPriority, keys);
+	TEST_CHECK(keys == std::vector<uint64_t>({ 1, 2 }));
+	TEST_CHECK(scheduler.getNumScheduledBytes() == 200);
+	TEST_CHECK(scheduler.getNumPending() == 2 && scheduler.getNumPendingBytes() == 200);
+	TEST_CHECK(!scheduler.isQueued(1) && !scheduler.isQueued(2) && scheduler.isQueued(3) && scheduler.isQueued(4));
+
+	// Priorities are re-evaluated every call
+	keys.clear();
+	scheduler.schedule(100, reversePriority, keys);
+	TEST_CHECK(keys == std::vector<uint64_t>({ 4 }));
+	TEST_CHECK(scheduler.isQueued(3) && !scheduler.isQueued(4));
+
+	// A budget of 0 schedules everything
+	keys.clear();
+	scheduler.push(5, 1000);
+	scheduler.schedule(0, keyPriority, keys);
+	TEST_CHECK(keys == std::vector<uint64_t>({ 3, 5 }));
+	TEST_CHECK(scheduler.getNumScheduledBytes() == 1100);
+	TEST_CHECK(scheduler.getNumPending() == 0 && scheduler.getNumPendingBytes() == 0);
+
+	// Scheduling stops at the first upload that doesn't fit even if a later, smaller one would
+	keys.clear();
+	scheduler.push(1, 100);
+	scheduler.push(2, 500);
+	scheduler.push(3, 50);
+	scheduler.schedule(200, keyPriority, keys);
+	TEST_CHECK(keys == std::vector<uint64_t>({ 1 }));
+	TEST_CHECK(scheduler.getNumPending() == 2 && scheduler.getNumPendingBytes() == 550);
+
+	// At least one upload is scheduled even if it's bigger than the budget
+	keys.clear();
+	scheduler.schedule(200, keyPriority, keys);
+	TEST_CHECK(keys == std::vector<uint64_t>({ 2 }));
+	TEST_CHECK(scheduler.getNumScheduledBytes() == 500);
+
+	keys.clear();
+	scheduler.schedule(200, keyPriority, keys);
+	TEST_CHECK(keys == std::vector<uint64_t>({ 3 }));
+
+	// Nothing queued, nothing scheduled
+	keys.clear();
+	scheduler.schedule(200, keyPriority, keys);
+	TEST_CHECK(keys.empty() && scheduler.getNumScheduledBytes() == 0);
+
+	// Pushing a queued key again only updates its size
+	scheduler.push(1, 100);
+	scheduler.push(2, 200);
+	scheduler.push(3, 300);
+	scheduler.push(2, 250);
+	TEST_CHECK(scheduler.getNumPending() == 3 && scheduler.getNumPendingBytes() == 650);
+
+	// The renderer removes meshes that were re-queued for meshing, they can't be scheduled until they're pushed again.
+	// Removing swaps the last upload into the hole, the moved one has to stay reachable
+	scheduler.remove(1);
+	scheduler.remove(1);
+	TEST_CHECK(!scheduler.isQueued(1) && scheduler.isQueued(2) && scheduler.isQueued(3));
+	TEST_CHECK(scheduler.getNumPending() == 2 && scheduler.getNumPendingBytes() == 550);
+
+	scheduler.push(3, 30);
+	TEST_CHECK(scheduler.getNumPending() == 2 && scheduler.getNumPendingBytes() == 280);
+
+	keys.clear();
+	scheduler.schedule(0, keyPriority, keys);
+	TEST_CHECK(keys == std::vector<uint64_t>({ 2, 3 }));
+	TEST_CHECK(scheduler.getNumScheduledBytes() == 280);
+
+	scheduler.push(1, 100);
+	scheduler.push(2, 100);
+	scheduler.remove(2);
+	scheduler.push(2, 400);
+
+	keys.clear();
+	scheduler.schedule(0, keyPriority, keys);
+	TEST_CHECK(keys == std::vector<uint64_t>({ 1, 2 }));
+	TEST_CHECK(scheduler.getNumScheduledBytes() == 500);
+
+	scheduler.push(1, 100);
+	scheduler.clear();
+	TEST_CHECK(scheduler.getNumPending() == 0 && scheduler.getNumPendingBytes() == 0 && !scheduler.isQueued(1));
+
+	return reportResult("UploadScheduler", numFailed);
+}
+
+int testRingAllocator()
+{
+	uint32_t numFailed = 0;
+
+	Okay::RingAllocator ring;
+	ring.initialize(1000);
+
+	TEST_CHECK(ring.allocate(300) == 0);
+	TEST_CHECK(ring.allocate(300) == 300);
+	ring.endFrame(1);
+	TEST_CHECK(ring.getUsedSize() == 600 && ring.getCurrentFrameSize() == 0);
+
+	// Alignment padding counts as used
+	TEST_CHECK(ring.allocate(10, 256) == 768);
+	TEST_CHECK(ring.allocate(100) == 778);
+	TEST_CHECK(ring.getUsedSize() == 878 && ring.getCurrentFrameSize() == 278);
+	ring.endFrame(2);
+
+	// Frames without allocations aren't tracked
+	ring.endFrame(3);
+	TEST_CHECK(ring.getOldestFenceValue() == 1);
+
+	// Back-pressure, nothing fits until the GPU is done with frame 1
+	TEST_CHECK(ring.allocate(200) == Okay::INVALID_UINT64);
+	ring.releaseCompleted(0);
+	TEST_CHECK(ring.allocate(200) == Okay::INVALID_UINT64);
+	TEST_CHECK(ring.getUsedSize() == 878 && ring.getCurrentFrameSize() == 0);
+
+	ring.releaseCompleted(1);
+	TEST_CHECK(ring.getUsedSize() == 278 && ring.getOldestFenceValue() == 2);
+
+	// Wrap-around, the 122 bytes left at the end are skipped & freed with this frame
+	TEST_CHECK(ring.allocate(200) == 0);
+	TEST_CHECK(ring.getUsedSize() == 600 && ring.getCurrentFrameSize() == 322);
+
+	// Fills the gap up to the tail exactly, after which the ring is full
+	TEST_CHECK(ring.allocate(400) == 200);
+	TEST_CHECK(ring.getUsedSize() == 1000);
+	TEST_CHECK(ring.allocate(1) == Okay::INVALID_UINT64);
+	ring.endFrame(4);
+
+	// Releasing several frames at once, frame 3 was empty so only frame 2 is freed
+	ring.releaseCompleted(3);
+	TEST_CHECK(ring.getOldestFenceValue() == 4 && ring.getUsedSize() == 722);
+
+	// Fits before the tail but not once aligned
+	TEST_CHECK(ring.allocate(250, 256) == Okay::INVALID_UINT64);
+	ring.releaseCompleted(4);
+	TEST_CHECK(ring.getUsedSize() == 0 && ring.getOldestFenceValue() == Okay::INVALID_UINT64);
+
+	// Empty again so it starts over from 0
+	TEST_CHECK(ring.allocate(600) == 0);
+	ring.endFrame(5);
+	TEST_CHECK(ring.allocate(300) == 600);
+	ring.endFrame(6);
+	ring.releaseCompleted(5);
+
+	// Fits at the end unaligned but not aligned, so it wraps & the padding at the end is freed with this frame
+	TEST_CHECK(ring.allocate(80, 256) == 0);
+	TEST_CHECK(ring.getUsedSize() == 480 && ring.getCurrentFrameSize() == 180);
+	TEST_CHECK(ring.allocate(400, 256) == Okay::INVALID_UINT64);
+	TEST_CHECK(ring.allocate(300, 256) == 256);
+	TEST_CHECK(ring.getUsedSize() == 956);
+	ring.endFrame(7);
+
+	ring.releaseCompleted(7);
+	TEST_CHECK(ring.getUsedSize() == 0 && ring.getOldestFenceValue() == Okay::INVALID_UINT64);
+	TEST_CHECK(ring.allocate(1000) == 0);
+	ring.endFrame(8);
+	ring.releaseCompleted(8);
+
+	// Random frames with the GPU a few frames behind, live allocations must never overlap & always be aligned
+	struct LiveRange
+	{
+		uint64_t fenceValue = 0;
+		uint64_t begin = 0;
+		uint64_t end = 0;
+	};
+
+	const uint64_t ringSize = 64 * 1024;
+	const uint64_t framesInFlight = 3;
+
+	std::deque<LiveRange> liveRanges;
+	ring.initialize(ringSize);
+
+	srand(1);
+	for (uint64_t fenceValue = 1; fenceValue <= 20'000; fenceValue++)
+	{
+		uint32_t numAllocations = rand() % 8;
+		for (uint32_t i = 0; i < numAllocations; i++)
+		{
+			uint64_t size = 1 + rand() % 8192;
+			uint64_t alignment = 1ull << (rand() % 10);
+			uint64_t offset = ring.allocate(size, alignment);
+
+			// Back-pressure, wait for the oldest frame like the renderer does
+			while (offset == Okay::INVALID_UINT64 && ring.getOldestFenceValue() != Okay::INVALID_UINT64)
+			{
+				uint64_t oldestFenceValue = ring.getOldestFenceValue();
+				ring.releaseCompleted(oldestFenceValue);
+
+				while (!liveRanges.empty() && liveRanges.front().fenceValue <= oldestFenceValue)
+					liveRanges.pop_front();
+
+				offset = ring.allocate(size, alignment);
+			}
+
+			// Can still fail if the current frame alone fills the ring
+			if (offset == Okay::INVALID_UINT64)
+				continue;
+
+			TEST_CHECK(offset % alignment == 0 && offset + size <= ringSize);
+
+			for (const LiveRange& range : liveRanges)
+				TEST_CHECK(offset + size <= range.begin || offset >= range.end);
+
+			liveRanges.push_back({ fenceValue, offset, offset + size });
+		}
+
+		ring.endFrame(fenceValue);
+
+		if (fenceValue > framesInFlight)
+		{
+			ring.releaseCompleted(fenceValue - framesInFlight);
+
+			while (!liveRanges.empty() && liveRanges.front().fenceValue <= fenceValue - framesInFlight)
+				liveRanges.pop_front();
+		}
+
+		if (numFailed)
+			break;
+	}
+
+	ring.releaseCompleted(Okay::INVALID_UINT64 - 1);
+	TEST_CHECK(ring.getUsedSize() == 0);
+
+	return reportResult("RingAllocator", numFailed);
+}
+
+// Sizes of the free gaps between the reference allocations, which is exactly what the free blocks are when they're always merged
+static uint64_t findLargestGap(const std::map<uint64_t, uint64_t>& allocations, uint64_t size)
+{
+	uint64_t largestGap = 0;
+	uint64_t gapBegin = 0;
+
+	for (const auto& [offset, allocationSize] : allocations)
+	{
+		largestGap = glm::max(largestGap, offset - gapBegin);
+		gapBegin = offset + allocationSize;
+	}
+
+	return glm::max(largestGap, size - gapBegin);
+}
+
+int testTLSFAllocator()
+{
+	uint32_t numFailed = 0;
+
+	Okay::TLSFAllocator allocator;
+	allocator.initialize(1 << 20);
+
+	// Reference state, offset -> size & the handles that are still allocated
+	std::map<uint64_t, uint64_t> allocations;
+	std::vector<std::pair<uint32_t, uint64_t>> handles;
+	uint64_t allocatedSize = 0;
+
+	srand(1);
+	for (uint32_t i = 0; i < 200'000; i++)
+	{
+		uint32_t operation = rand() % 100;
+
+		if (operation < 55)
+		{
+			// Mostly small sizes with the occasional big one, alignments up to 4 KiB
+			uint64_t size = rand() % 16 ? 1 + rand() % 2048 : 1 + rand() % (64 * 1024);
+			uint64_t alignment = 1ull << (rand() % 13);
+
+			uint64_t offset = Okay::INVALID_UINT64;
+			uint32_t handle = allocator.allocate(size, alignment, &offset);
+
+			if (handle == Okay::INVALID_UINT32)
+			{
+				// Good fit, a failure means no free block could hold the allocation at any alignment
+				TEST_CHECK(findLargestGap(allocations, allocator.getSize()) < size + alignment - 1);
+				continue;
+			}
+
+			TEST_CHECK(offset % alignment == 0 && offset + size <= allocator.getSize());
+			TEST_CHECK(allocator.getOffset(handle) == offset && allocator.getAllocationSize(handle) == size);
+
+			// Only the closest allocations on either side can overlap
+			auto nextIterator = allocations.lower_bound(offset);
+			if (nextIterator != allocations.end())
+				TEST_CHECK(offset + size <= nextIterator->first);
+
+			if (nextIterator != allocations.begin())
+			{
+				auto prevIterator = std::prev(nextIterator);
+				TEST_CHECK(prevIterator->first + prevIterator->second <= offset);
+			}
+
+			allocations[offset] = size;
+			handles.emplace_back(handle, offset);
+			allocatedSize += size;
+		}
+		else if (operation < 99)
+		{
+			if (handles.empty())
+				continue;
+
+			uint32_t handleIdx = rand() % (uint32_t)handles.size();
+			auto [handle, offset] = handles[handleIdx];
+
+			allocatedSize -= allocations[offset];
+			allocations.erase(offset);
+			allocator.free(handle);
+
+			handles[handleIdx] = handles.back();
+			handles.pop_back();
+		}
+		else if (allocator.getSize() < 16 << 20)
+		{
+			allocator.grow(allocator.getSize() + 1 + rand() % (256 * 1024));
+		}
+
+		TEST_CHECK(allocator.getNumAllocations() == (uint32_t)handles.size());
+		TEST_CHECK(allocator.getTotalFreeSize() == allocator.getSize() - allocatedSize);
+
+		// Free neighbours are always merged, so the largest free block is the largest gap
+		if (i % 64 == 0)
+			TEST_CHECK(allocator.getLargestFreeBlockSize() == findLargestGap(allocations, allocator.getSize()));
+
+		if (numFailed)
+			break;
+	}
+
+	for (const auto& [handle, offset] : handles)
+		allocator.free(handle);
+
+	// Everything freed has to merge back into a single block
+	TEST_CHECK(allocator.getNumAllocations() == 0);
+	TEST_CHECK(allocator.getTotalFreeSize() == allocator.getSize());
+	TEST_CHECK(allocator.getLargestFreeBlockSize() == allocator.getSize());
+
+	uint64_t offset = Okay::INVALID_UINT64;
+	TEST_CHECK(allocator.allocate(allocator.getSize(), 1, &offset) != Okay::INVALID_UINT32 && offset == 0);
+
+	allocator.shutdown();
+
+	return reportResult("TLSFAllocator", numFailed);
+}
+
+int testPagedAllocator()
+{
+	uint32_t numFailed = 0;
+
+	Okay::PagedAllocator allocator;
+	allocator.initialize(1000);
+
+	// Growing, nothing fits until a page is added
+	Okay::PagedAllocation first;
+	TEST_CHECK(allocator.getNumPages() == 0 && !allocator.allocate(100, &first));
+	TEST_CHECK(allocator.addPage() == 0 && allocator.getPageSize(0) == 1000);
+	TEST_CHECK(allocator.allocate(100, &first) && first.pageIdx == 0 && first.offset == 0 && first.size == 100);
+
+	Okay::PagedAllocation rest;
+	TEST_CHECK(allocator.allocate(900, &rest) && rest.pageIdx == 0 && rest.offset == 100);
+
+	Okay::PagedAllocation second;
+	TEST_CHECK(!allocator.allocate(1, &second));
+	TEST_CHECK(allocator.addPage() == 1);
+	TEST_CHECK(allocator.allocate(50, &second) && second.pageIdx == 1 && second.offset == 0);
+
+	// Oversized allocations get a page of their own
+	Okay::PagedAllocation oversized;
+	TEST_CHECK(!allocator.allocate(5000, &oversized));
+	TEST_CHECK(allocator.addPage(5000) == 2 && allocator.getPageSize(2) == 5000 && allocator.getPageSize() == 1000);
+	TEST_CHECK(allocator.allocate(5000, &oversized) && oversized.pageIdx == 2 && oversized.offset == 0);
+	TEST_CHECK(allocator.getTotalSize() == 7000 && allocator.getTotalFreeSize() == 950 && allocator.getNumAllocations() == 4);
+
+	// Finding & claiming separately gives the same result as allocate
+	Okay::PagedAllocation freeBlock;
+	TEST_CHECK(allocator.findFreeBlock(200, &freeBlock) && freeBlock.pageIdx == 1 && freeBlock.offset == 50 && freeBlock.size >= 200);
+
+	Okay::PagedAllocation claimed = allocator.claimFreeBlock(freeBlock, 200);
+	TEST_CHECK(claimed.pageIdx == freeBlock.pageIdx && claimed.offset == freeBlock.offset && claimed.size == 200);
+	TEST_CHECK(claimed.allocationHandle != Okay::INVALID_UINT32 && allocator.getNumAllocations() == 5);
+
+	// Lower pages are searched first, pages without a large enough block are skipped
+	allocator.free(first);
+	TEST_CHECK(allocator.findFreeBlock(100, &freeBlock) && freeBlock.pageIdx == 0 && freeBlock.offset == 0);
+	TEST_CHECK(allocator.findFreeBlock(101, &freeBlock) && freeBlock.pageIdx == 1 && freeBlock.offset == 250);
+	TEST_CHECK(!allocator.findFreeBlock(751, &freeBlock));
+	TEST_CHECK(allocator.getLargestFreeBlockSize() == 750);
+
+	// Free memory at the end of separate pages isn't fragmented, a hole within a page is
+	TEST_CHECK(allocator.getFragmentation() == 0.f);
+	allocator.free(second);
+	TEST_CHECK(allocator.getTotalFreeSize() == 900 && glm::abs(allocator.getFragmentation() - 50.f / 900.f) < 1e-6f);
+
+	allocator.free(claimed);
+	TEST_CHECK(allocator.getFragmentation() == 0.f && allocator.getLargestFreeBlockSize() == 1000);
+
+	// Freeing across pages, then clearing keeps the pages but frees everything
+	allocator.free(oversized);
+	TEST_CHECK(allocator.getNumAllocations() == 1 && allocator.getTotalFreeSize() == 6100);
+
+	allocator.clear();
+	TEST_CHECK(allocator.getNumPages() == 3 && allocator.getNumAllocations() == 0);
+	TEST_CHECK(allocator.getTotalFreeSize() == allocator.getTotalSize() && allocator.getLargestFreeBlockSize() == 5000);
+
+	Okay::PagedAllocation allocation;
+	TEST_CHECK(allocator.allocate(5000, &allocation) && allocation.pageIdx == 2 && allocation.offset == 0);
+	TEST_CHECK(allocator.allocate(1000, &allocation) && allocation.pageIdx == 0 && allocation.offset == 0);
+	TEST_CHECK(allocator.allocate(1000, &allocation) && allocation.pageIdx == 1);
+	TEST_CHECK(!allocator.allocate(1, &allocation));
+
+	allocator.shutdown();
+	TEST_CHECK(allocator.getNumPages() == 0);
+
+	return reportResult("PagedAllocator", numFailed);
+}
+
+struct TestBox
+{
+	glm::vec3 boxMin = glm::vec3(0.f);
+	glm::vec3 boxMax = glm::vec3(0.f);
+};
+
+static float randomFloat(float min, float max)
+{
+	return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+// Slab test, returns the distance along the ray where it enters the box or FLT_MAX if it misses
+static float rayBoxDistance(const glm::vec3& origin, const glm::vec3& direction, const TestBox& box)
+{
+	glm::vec3 inverseDirection = 1.f / direction;
+	glm::vec3 t0 = (box.boxMin - origin) * inverseDirection;
+	glm::vec3 t1 = (box.boxMax - origin) * inverseDirection;
+
+	glm::vec3 tMin = glm::min(t0, t1);
+	glm::vec3 tMax = glm::max(t0, t1);
+
+	float enter = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.f));
+	float exit = glm::min(glm::min(tMax.x, tMax.y), tMax.z);
+
+	return enter <= exit ? enter : FLT_MAX;
+}
+
+static float findNearestHit(const glm::vec3& origin, const glm::vec3& direction, const std::vector<TestBox>& boxes)
+{
+	float nearest = FLT_MAX;
+	for (const TestBox& box : boxes)
+		nearest = glm::min(nearest, rayBoxDistance(origin, direction, box));
+
+	return nearest;
+}
+
+static bool isRayBlocked(const glm::vec3& origin, const glm::vec3& targetPos, const std::vector<TestBox>& boxes)
+{
+	glm::vec3 toTarget = targetPos - origin;
+	float targetDistance = glm::length(toTarget);
+
+	return findNearestHit(origin, toTarget / targetDistance, boxes) < targetDistance;
+}
+
+// The buffer only sees gaps at least a pixel wide, so the point has to be visible through a whole pixel sized square around it.
+// Such a square always holds a pixel center, whose pixel is within the one pixel border testAABB adds around the box
+static bool isVisibleThroughPixelGap(const glm::vec3& cameraPos, const glm::mat4& inverseViewProjMatrix, const glm::vec2& screenSize,
+	const std::vector<TestBox>& occluders, const glm::vec4& sampleClipPos)
+{
+	const uint32_t raysPerSide = 5;
+
+	auto getWorldPos = [&](const glm::vec2& pixelOffset)
+	{
+		glm::vec4 clipPos = sampleClipPos;
+		clipPos.x += pixelOffset.x * 2.f / screenSize.x * sampleClipPos.w;
+		clipPos.y -= pixelOffset.y * 2.f / screenSize.y * sampleClipPos.w;
+
+		glm::vec4 worldPos = inverseViewProjMatrix * clipPos;
+		return glm::vec3(worldPos) / worldPos.w;
+	};
+
+	if (isRayBlocked(cameraPos, getWorldPos(glm::vec2(0.f)), occluders))
+		return false;
+
+	for (uint32_t squareIdx = 0; squareIdx < 9; squareIdx++)
+	{
+		glm::vec2 squareMin = -glm::vec2((float)(squareIdx % 3), (float)(squareIdx / 3)) * 0.5f;
+
+		bool squareVisible = true;
+		for (uint32_t rayIdx = 0; rayIdx < raysPerSide * raysPerSide && squareVisible; rayIdx++)
+		{
+			glm::vec2 rayOffset = glm::vec2((float)(rayIdx % raysPerSide), (float)(rayIdx / raysPerSide)) / (float)(raysPerSide - 1);
+			squareVisible = !isRayBlocked(cameraPos, getWorldPos(squareMin + rayOffset), occluders);
+		}
+
+		if (squareVisible)
+			return true;
+	}
+
+	return false;
+}
+
+// Compares the buffer against rays cast through the scene:
+// - Every pixel has to be at or behind the nearest occluder the ray through its center hits
+// - Every box testAABB says is hidden can't have any point inside the view visible through a gap at least a pixel wide
+int testOcclusionBuffer()
+{
+	uint32_t numFailed = 0;
+
+	const uint32_t width = 256;
+	const uint32_t height = 128;
+	const uint32_t numScenes = 20;
+	const uint32_t samplesPerSide = 12;
+
+	uint32_t numHitPixels = 0;
+	uint32_t numCoveredPixels = 0;
+	uint32_t numTestedBoxes = 0;
+	uint32_t numOccludedBoxes = 0;
+	uint32_t numHiddenBoxes = 0;
+
+	Okay::OcclusionBuffer occlusionBuffer;
+	occlusionBuffer.initialize(width, height);
+
+	srand(1);
+	for (uint32_t scene = 0; scene < numScenes; scene++)
+	{
+		// Terrain like columns in front of a camera looking roughly along +Z
+		glm::vec3 cameraPos = glm::vec3(randomFloat(-8.f, 8.f), randomFloat(4.f, 30.f), 0.f);
+		glm::vec3 cameraTarget = cameraPos + glm::vec3(randomFloat(-0.4f, 0.4f), randomFloat(-0.4f, 0.1f), 1.f);
+
+		glm::mat4 viewMatrix = glm::lookAtLH(cameraPos, cameraTarget, glm::vec3(0.f, 1.f, 0.f));
+		glm::mat4 projMatrix = glm::perspectiveFovLH_ZO(glm::radians(80.f), (float)width, (float)height, 0.1f, 1000.f);
+		glm::mat4 viewProjMatrix = projMatrix * viewMatrix;
+		glm::mat4 inverseViewProjMatrix = glm::inverse(viewProjMatrix);
+
+		std::vector<TestBox> occluders;
+		for (uint32_t i = 0; i < 60; i++)
+		{
+			TestBox& occluder = occluders.emplace_back();
+			occluder.boxMin = glm::vec3(randomFloat(-80.f, 80.f), 0.f, randomFloat(2.f, 80.f));
+			occluder.boxMax = occluder.boxMin + glm::vec3(randomFloat(1.f, 16.f), randomFloat(1.f, 40.f), randomFloat(1.f, 16.f));
+		}
+
+		occlusionBuffer.clear();
+		occlusionBuffer.setViewProjection(viewProjMatrix, cameraPos);
+
+		for (const TestBox& occluder : occluders)
+			occlusionBuffer.addOccluder(occluder.boxMin, occluder.boxMax);
+
+		// Rays passing exactly along an edge can miss both neighbouring faces, the reference uses slightly bigger boxes
+		std::vector<TestBox> rayOccluders = occluders;
+		for (TestBox& occluder : rayOccluders)
+		{
+			occluder.boxMin -= 0.01f;
+			occluder.boxMax += 0.01f;
+		}
+
+		// Filled in bands like the renderer does
+		for (uint32_t rowBegin = 0; rowBegin < height; rowBegin += 32)
+			occlusionBuffer.rasterizeTriangles(0, occlusionBuffer.getNumTriangles(), rowBegin, rowBegin + 32);
+
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				glm::vec2 ndc = glm::vec2(((float)x + 0.5f) / width * 2.f - 1.f, 1.f - ((float)y + 0.5f) / height * 2.f);
+				glm::vec4 nearPos = inverseViewProjMatrix * glm::vec4(ndc, 0.f, 1.f);
+				glm::vec3 direction = glm::normalize(glm::vec3(nearPos) / nearPos.w - cameraPos);
+
+				float bufferDepth = occlusionBuffer.getDepth(x, y);
+				float hitDistance = findNearestHit(cameraPos, direction, rayOccluders);
+
+				if (hitDistance == FLT_MAX)
+				{
+					TEST_CHECK(bufferDepth == 1.f);
+					continue;
+				}
+
+				glm::vec4 hitClipPos = viewProjMatrix * glm::vec4(cameraPos + direction * hitDistance, 1.f);
+				float hitDepth = hitClipPos.z / hitClipPos.w;
+
+				TEST_CHECK(bufferDepth >= hitDepth - 1e-5f);
+
+				numHitPixels++;
+				numCoveredPixels += bufferDepth < 1.f;
+			}
+		}
+
+		for (uint32_t i = 0; i < 200; i++)
+		{
+			TestBox box;
+			box.boxMin = glm::vec3(randomFloat(-100.f, 100.f), randomFloat(0.f, 20.f), randomFloat(10.f, 160.f));
+			box.boxMax = box.boxMin + glm::vec3(randomFloat(0.5f, 16.f), randomFloat(0.5f, 16.f), randomFloat(0.5f, 16.f));
+
+			bool occluded = !occlusionBuffer.testAABB(box.boxMin, box.boxMax);
+
+			// Hidden if none of a grid of points on its faces can be seen through a pixel sized gap
+			bool hidden = true;
+			for (uint32_t axis = 0; axis < 3 && hidden; axis++)
+			{
+				for (uint32_t side = 0; side < 2; side++)
+				{
+					for (uint32_t u = 0; u <= samplesPerSide; u++)
+					{
+						for (uint32_t v = 0; v <= samplesPerSide; v++)
+						{
+							glm::vec3 weights;
+							weights[axis] = (float)side;
+							weights[(axis + 1) % 3] = (float)u / samplesPerSide;
+							weights[(axis + 2) % 3] = (float)v / samplesPerSide;
+
+							// Points outside the view don't need to be hidden
+							glm::vec4 sampleClipPos = viewProjMatrix * glm::vec4(glm::mix(box.boxMin, box.boxMax, weights), 1.f);
+							if (sampleClipPos.z < 0.f || glm::abs(sampleClipPos.x) > sampleClipPos.w || glm::abs(sampleClipPos.y) > sampleClipPos.w)
+								continue;
+
+							if (hidden)
+								hidden = !isVisibleThroughPixelGap(cameraPos, inverseViewProjMatrix, glm::vec2((float)width, (float)height), rayOccluders, sampleClipPos);
+						}
+					}
+				}
+			}
+
+			TEST_CHECK(!occluded || hidden);
+
+			numTestedBoxes++;
+			numOccludedBoxes += occluded;
+			numHiddenBoxes += hidden;
+		}
+
+		if (numFailed)
+			break;
+	}
+
+	// Only conservative is easy, these make sure the buffer is actually doing something
+	printf("  %u of %u hit pixels covered, %u of %u tested boxes occluded (%u hidden)\n", numCoveredPixels, numHitPixels, numOccludedBoxes, numTestedBoxes, numHiddenBoxes);
+	TEST_CHECK(numCoveredPixels >= numHitPixels * 9 / 10);
+	TEST_CHECK(numOccludedBoxes >= numHiddenBoxes / 2);
+
+	occlusionBuffer.shutdown();
+
+	return reportResult("OcclusionBuffer", numFailed);
+}
+
+// Round trips two colour gradients through BC1, the fast encoder has to follow the gradient's diagonal through the colour box.
+// Gradients between opposite corners of a channel pair are where picking the wrong diagonal hurts the most
+int testBlockCompression()
+{
+	uint32_t numFailed = 0;
+
+	const glm::vec3 gradientEnds[][2] =
+	{
+		{ glm::vec3(0.f, 0.f, 0.f), glm::vec3(255.f, 255.f, 255.f) },
+		{ glm::vec3(255.f, 0.f, 0.f), glm::vec3(0.f, 255.f, 0.f) },
+		{ glm::vec3(40.f, 200.f, 30.f), glm::vec3(120.f, 60.f, 90.f) },
+		{ glm::vec3(0.f, 128.f, 255.f), glm::vec3(255.f, 128.f, 0.f) },
+		{ glm::vec3(200.f, 40.f, 255.f), glm::vec3(30.f, 220.f, 10.f) },
+	};
+
+	for (const auto& [colourA, colourB] : gradientEnds)
+	{
+		// One 4x4 block, diagonal gradient so every pixel is on the line between the ends
+		uint8_t pixels[16 * 4] = {};
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			glm::vec3 colour = glm::mix(colourA, colourB, (float)(i % 4 + i / 4) / 6.f);
+			pixels[i * 4 + 0] = (uint8_t)glm::round(colour.r);
+			pixels[i * 4 + 1] = (uint8_t)glm::round(colour.g);
+			pixels[i * 4 + 2] = (uint8_t)glm::round(colour.b);
+			pixels[i * 4 + 3] = UINT8_MAX;
+		}
+
+		float psnr[2] = {};
+		for (Okay::BCQuality quality : { Okay::BCQuality::FAST, Okay::BCQuality::HIGH })
+		{
+			uint8_t blocks[8] = {};
+			uint8_t decodedPixels[16 * 4] = {};
+
+			Okay::BlockCompression::compressImage(Okay::BCFormat::BC1, quality, pixels, 4, 4, blocks);
+			Okay::BlockCompression::decompressImage(Okay::BCFormat::BC1, blocks, 4, 4, decodedPixels);
+
+			psnr[(uint32_t)quality] = glm::min(Okay::BlockCompression::computePSNR(pixels, decodedPixels, 16), 99.f);
+		}
+
+		printf("  (%3.0f, %3.0f, %3.0f) -> (%3.0f, %3.0f, %3.0f): fast %.2f dB, high %.2f dB\n",
+			colourA.r, colourA.g, colourA.b, colourB.r, colourB.g, colourB.b, psnr[0], psnr[1]);
+
+		TEST_CHECK(psnr[0] >= psnr[1] - 3.f);
+	}
+
+	return reportResult("BlockCompression", numFailed);
+}
+
+// Sorts the queue & compares the item order against std::stable_sort on the same keys
+static bool matchesStableSort(Okay::RenderQueue& renderQueue)
+{
+	std::vector<Okay::RenderQueueItem> expectedItems = renderQueue.getItems();
+	std::stable_sort(expectedItems.begin(), expectedItems.end(), [](const Okay::RenderQueueItem& a, const Okay::RenderQueueItem& b)
+		{
+			return a.sortKey < b.sortKey;
+		});
+
+	renderQueue.sort();
+
+	const std::vector<Okay::RenderQueueItem>& items = renderQueue.getItems();
+	if (items.size() != expectedItems.size())
+		return false;
+
+	for (uint32_t i = 0; i < (uint32_t)items.size(); i++)
+	{
+		if (items[i].itemIdx != expectedItems[i].itemIdx || items[i].sortKey != expectedItems[i].sortKey)
+			return false;
+	}
+
+	return true;
+}
+
+int testRenderQueue()
+{
+	using Okay::RenderQueue;
+
+	uint32_t numFailed = 0;
+
+	// Keys order like the depths they're made from, back to front flips that but never across passes
+	TEST_CHECK(RenderQueue::makeSortKey(0, 1.f, false) < RenderQueue::makeSortKey(0, 2.f, false));
+	TEST_CHECK(RenderQueue::makeSortKey(0, 1.f, true) > RenderQueue::makeSortKey(0, 2.f, true));
+	TEST_CHECK(RenderQueue::makeSortKey(0, 100000.f, false) < RenderQueue::makeSortKey(1, 0.f, false));
+	TEST_CHECK(RenderQueue::makeSortKey(0, 0.f, true) < RenderQueue::makeSortKey(1, 100000.f, true));
+	TEST_CHECK(RenderQueue::makeSortKey(0, -5.f, false) == RenderQueue::makeSortKey(0, 0.f, false));
+
+	srand(1);
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		float depthA = randomFloat(0.f, 5000.f);
+		float depthB = randomFloat(0.f, 5000.f);
+		if (depthA > depthB)
+			std::swap(depthA, depthB);
+
+		TEST_CHECK(RenderQueue::makeSortKey(1, depthA, false) <= RenderQueue::makeSortKey(1, depthB, false));
+		TEST_CHECK(RenderQueue::makeSortKey(1, depthA, true) >= RenderQueue::makeSortKey(1, depthB, true));
+	}
+
+	RenderQueue renderQueue;
+
+	// Random passes, depths & directions, with a few repeated keys so stability matters
+	for (uint32_t i = 0; i < 5000; i++)
+	{
+		uint32_t pass = rand() % 3;
+		float depth = rand() % 8 ? randomFloat(0.f, 2000.f) : 100.f;
+		renderQueue.push(RenderQueue::makeSortKey(pass, depth, pass == 2), i);
+	}
+
+	TEST_CHECK(matchesStableSort(renderQueue));
+
+	// Only the lowest depth byte differs, so a single radix pass has to do all the work
+	renderQueue.clear();
+	uint32_t baseDepthBits = std::bit_cast<uint32_t>(64.f);
+	for (uint32_t i = 0; i < 5000; i++)
+	{
+		float depth = std::bit_cast<float>(baseDepthBits + ((uint32_t)(rand() % 16) << 12));
+		renderQueue.push(RenderQueue::makeSortKey(0, depth, false), i);
+	}
+
+	TEST_CHECK(matchesStableSort(renderQueue));
+
+	// Identical keys skip every radix pass & keep the push order
+	renderQueue.clear();
+	for (uint32_t i = 0; i < 100; i++)
+		renderQueue.push(RenderQueue::makeSortKey(1, 10.f, false), i);
+
+	renderQueue.sort();
+	for (uint32_t i = 0; i < 100; i++)
+		TEST_CHECK(renderQueue.getItems()[i].itemIdx == i);
+
+	// Nothing & a single item
+	renderQueue.clear();
+	renderQueue.sort();
+	TEST_CHECK(renderQueue.getItems().empty());
+
+	renderQueue.push(RenderQueue::makeSortKey(3, 1.f, false), 7);
+	renderQueue.sort();
+	TEST_CHECK(renderQueue.getItems().size() == 1 && renderQueue.getItems()[0].itemIdx == 7);
+
+	return reportResult("RenderQueue", numFailed);
+}
+
+int testVoxelDrawList()
+{
+	using namespace Okay;
+
+	uint32_t numFailed = 0;
+
+	// Same layout as the command signature: 2 root constants, root SRV, index buffer view & indexed draw, padded to 8 bytes
+	TEST_CHECK(sizeof(IndirectDrawArguments) == 56);
+	TEST_CHECK(offsetof(IndirectDrawArguments, drawIdx) == 0 && offsetof(IndirectDrawArguments, numDrawData) == 4);
+	TEST_CHECK(offsetof(IndirectDrawArguments, vertexDataGVA) == 8);
+	TEST_CHECK(offsetof(IndirectDrawArguments, indicesView) == 16);
+	TEST_CHECK(offsetof(IndirectDrawArguments, drawArguments) == 32);
+	TEST_CHECK(sizeof(GPUDrawCallData) == 16);
+
+	VoxelDrawList drawList;
+
+	// A chunk drawing both passes shares its draw data
+	uint32_t chunkDrawIdx = drawList.addDrawData(glm::vec3(16.f, 0.f, 32.f));
+	TEST_CHECK(chunkDrawIdx == 0);
+	TEST_CHECK(drawList.getDrawData()[0].chunkWorldPos == glm::vec3(16.f, 0.f, 32.f) && drawList.getDrawData()[0].vertexEnd == INVALID_UINT32);
+
+	D3D12_INDEX_BUFFER_VIEW indicesView = {};
+	indicesView.BufferLocation = 0x20000;
+	indicesView.SizeInBytes = 36 * sizeof(uint32_t);
+
+	drawList.addDraw(VoxelPass::BLOCKS, chunkDrawIdx, 0x10000, indicesView, 36, 5.f);
+	drawList.addDraw(VoxelPass::WATER, chunkDrawIdx, 0x30000, indicesView, 6, 5.f);
+
+	// Merged draws point at their first member & count them
+	uint32_t firstMemberIdx = drawList.addDrawData(glm::vec3(0.f), 100);
+	TEST_CHECK(drawList.addDrawData(glm::vec3(16.f, 0.f, 0.f), 250) == firstMemberIdx + 1);
+	TEST_CHECK(drawList.addDrawData(glm::vec3(32.f, 0.f, 0.f), 300) == firstMemberIdx + 2);
+	drawList.addDraw(VoxelPass::BLOCKS, firstMemberIdx, 0x40000, indicesView, 450, 20.f, 3);
+
+	// Meshes without indices don't get a draw
+	drawList.addDraw(VoxelPass::BLOCKS, chunkDrawIdx, 0x10000, indicesView, 0, 1.f);
+	drawList.addDraw(VoxelPass::WATER, chunkDrawIdx, 0x10000, indicesView, INVALID_UINT32, 1.f);
+
+	TEST_CHECK(drawList.getDrawData().size() == 4);
+	TEST_CHECK(drawList.getNumDraws() == 3);
+	TEST_CHECK(drawList.getDraws(VoxelPass::BLOCKS).size() == 2 && drawList.getDraws(VoxelPass::WATER).size() == 1);
+
+	const IndirectDrawArguments& blockDraw = drawList.getDraws(VoxelPass::BLOCKS)[0];
+	TEST_CHECK(blockDraw.drawIdx == chunkDrawIdx && blockDraw.numDrawData == 1);
+	TEST_CHECK(blockDraw.vertexDataGVA == 0x10000 && blockDraw.indicesView.BufferLocation == 0x20000);
+	TEST_CHECK(blockDraw.drawArguments.IndexCountPerInstance == 36 && blockDraw.drawArguments.InstanceCount == 1);
+	TEST_CHECK(blockDraw.drawArguments.StartIndexLocation == 0 && blockDraw.drawArguments.BaseVertexLocation == 0 && blockDraw.drawArguments.StartInstanceLocation == 0);
+
+	const IndirectDrawArguments& mergedDraw = drawList.getDraws(VoxelPass::BLOCKS)[1];
+	TEST_CHECK(mergedDraw.drawIdx == firstMemberIdx && mergedDraw.numDrawData == 3);
+	TEST_CHECK(mergedDraw.drawArguments.IndexCountPerInstance == 450 && mergedDraw.drawArguments.InstanceCount == 1);
+
+	const IndirectDrawArguments& waterDraw = drawList.getDraws(VoxelPass::WATER)[0];
+	TEST_CHECK(waterDraw.drawIdx == chunkDrawIdx && waterDraw.numDrawData == 1 && waterDraw.vertexDataGVA == 0x30000);
+	TEST_CHECK(waterDraw.drawArguments.IndexCountPerInstance == 6 && waterDraw.drawArguments.InstanceCount == 1);
+
+	// Blocks front to back, water back to front, the draws keep their arguments
+	drawList.clear();
+	TEST_CHECK(drawList.getDrawData().empty() && drawList.getNumDraws() == 0);
+
+	uint32_t drawIdx = drawList.addDrawData(glm::vec3(0.f));
+	const float depths[4] = { 30.f, 10.f, 40.f, 20.f };
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		drawList.addDraw(VoxelPass::BLOCKS, drawIdx, 0, indicesView, (uint32_t)depths[i], depths[i]);
+		drawList.addDraw(VoxelPass::WATER, drawIdx, 0, indicesView, (uint32_t)depths[i], depths[i]);
+	}
+
+	drawList.sortDraws();
+
+	const uint32_t frontToBack[4] = { 10, 20, 30, 40 };
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		TEST_CHECK(drawList.getDraws(VoxelPass::BLOCKS)[i].drawArguments.IndexCountPerInstance == frontToBack[i]);
+		TEST_CHECK(drawList.getDraws(VoxelPass::WATER)[i].drawArguments.IndexCountPerInstance == frontToBack[3 - i]);
+	}
+
+	return reportResult("VoxelDrawList", numFailed);
+}
+
+int testDrawPartitioning()
+{
+	using namespace Okay;
+
+	uint32_t numFailed = 0;
+
+	VoxelDrawList drawList;
+	std::vector<VoxelDrawRange> ranges;
+
+	D3D12_INDEX_BUFFER_VIEW indicesView = {};
+	const uint32_t passSizes[][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 7, 3 }, { 256, 0 }, { 255, 2 }, { 1000, 37 }, { 3, 2000 } };
+	const uint32_t maxPartitionCounts[] = { 1, 2, 3, 4, 8 };
+	const uint32_t minDrawCounts[] = { 0, 1, 5, 256 };
+
+	for (const uint32_t* passSize : passSizes)
+	{
+		// Every draw gets a unique index count so the order can be followed, this is the order a single thread records them in
+		drawList.clear();
+		uint32_t drawIdx = drawList.addDrawData(glm::vec3(0.f));
+		std::vector<uint32_t> expectedSequence;
+
+		for (uint32_t pass = 0; pass < (uint32_t)VoxelPass::NUM_PASSES; pass++)
+		{
+			for (uint32_t i = 0; i < passSize[pass]; i++)
+			{
+				uint32_t drawID = (uint32_t)expectedSequence.size() + 1;
+				drawList.addDraw((VoxelPass)pass, drawIdx, 0, indicesView, drawID, 0.f);
+				expectedSequence.emplace_back(drawID);
+			}
+		}
+
+		uint32_t numDraws = (uint32_t)expectedSequence.size();
+
+		for (uint32_t maxPartitions : maxPartitionCounts)
+		{
+			for (uint32_t minDraws : minDrawCounts)
+			{
+				uint32_t numPartitions = drawList.partitionDraws(maxPartitions, minDraws, ranges);
+				TEST_CHECK(numPartitions <= maxPartitions);
+				TEST_CHECK(numDraws ? numPartitions > 0 : numPartitions == 0 && ranges.empty());
+
+				// Running the partitions one after the other has to record exactly the single threaded sequence
+				std::vector<uint32_t> sequence;
+				std::vector<uint32_t> partitionSizes(numPartitions, 0);
+				uint32_t prevPartitionIdx = 0;
+
+				for (const VoxelDrawRange& range : ranges)
+				{
+					TEST_CHECK(range.partitionIdx < numPartitions && range.partitionIdx >= prevPartitionIdx && range.partitionIdx <= prevPartitionIdx + 1);
+					TEST_CHECK(range.numDraws > 0 && range.firstDraw + range.numDraws <= (uint32_t)drawList.getDraws(range.pass).size());
+					if (numFailed)
+						break;
+
+					prevPartitionIdx = range.partitionIdx;
+					partitionSizes[range.partitionIdx] += range.numDraws;
+
+					const std::vector<IndirectDrawArguments>& draws = drawList.getDraws(range.pass);
+					for (uint32_t i = range.firstDraw; i < range.firstDraw + range.numDraws; i++)
+						sequence.emplace_back(draws[i].drawArguments.IndexCountPerInstance);
+				}
+
+				TEST_CHECK(sequence == expectedSequence);
+
+				// Only the last partition can be smaller than the minimum, none of them can be empty
+				for (uint32_t partitionIdx = 0; partitionIdx < numPartitions; partitionIdx++)
+				{
+					TEST_CHECK(partitionSizes[partitionIdx] > 0);
+					if (partitionIdx + 1 < numPartitions)
+						TEST_CHECK(partitionSizes[partitionIdx] >= minDraws);
+				}
+
+				// Unless the minimum is bigger, the draws are split evenly and the first partition gets the rounded up share
+				if (numPartitions > 1 && minDraws <= (numDraws + maxPartitions - 1) / maxPartitions)
+					TEST_CHECK(partitionSizes[0] == (numDraws + maxPartitions - 1) / maxPartitions);
+
+				if (numFailed)
+					return reportResult("DrawPartitioning", numFailed);
+			}
+		}
+	}
+
+	return reportResult("DrawPartitioning", numFailed);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// Headless checks for engine code that doesn't need a window or device, run with --test-<name>.
+// Each prints what failed and returns nonzero if anything did
+int testUploadScheduler();
+int testRingAllocator();
+int testTLSFAllocator();
+int testPagedAllocator();
+int testOcclusionBuffer();
+int testBlockCompression();
+int testRenderQueue();
+int testVoxelDrawList();
+int testDrawPartitioning();